@@ -0,0 +1,80 @@
+#include "floatformat.hpp"
+
+namespace FloatFormat {
+  static const uint32_t scales[MAX_PRECISION + 1] = {
+      1, 10, 100, 1000, 10000, 100000, 1000000,
+  };
+
+  /**
+   * @brief Write value into out, null terminated
+   * @return the text length, 0 when out is too small
+   */
+  size_t format(float value, uint8_t precision, char* out, size_t capacity) {
+    if (precision > MAX_PRECISION)
+      precision = MAX_PRECISION;
+
+    //* Exact integer path, the float is taken apart into mantissa * 2^exp.
+    //* Double math is soft-float on the ESP32 and a float product rounds
+    //* before the half is added, which carries 9.995f into the next digit.
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t biased = (bits >> 23) & 0xFF;
+    uint64_t mantissa = bits & 0x7FFFFF;
+    int32_t exponent = -149;
+    if (biased != 0) {
+      mantissa |= 0x800000;
+      exponent = biased - 150;
+    }
+
+    //* Beyond 1e15 the scaled integer no longer fits, and no sensor gets there
+    const uint64_t limit = 1000000000000000ULL;
+    uint64_t scaled = 0;
+    bool fits = biased != 0xFF;
+    if (fits && exponent >= 0) {
+      fits = exponent < 30 && (mantissa << exponent) < limit / scales[precision];
+      if (fits)
+        scaled = (mantissa << exponent) * scales[precision];
+    } else if (fits && exponent > -64) {
+      //* Round half away from zero on the bits shifted out
+      uint32_t shift = -exponent;
+      uint64_t product = mantissa * scales[precision];
+      scaled = product >> shift;
+      if (((product >> (shift - 1)) & 1) != 0)
+        scaled++;
+    }
+    if (!fits) {
+      if (capacity < 5)
+        return 0;
+      memcpy(out, "null", 5);
+      return 4;
+    }
+
+    //* No "-0.000" for tiny negative values
+    bool negative = (bits >> 31) != 0 && scaled != 0;
+    char digits[FLOAT_FORMAT_SIZE];
+    size_t count = 0;
+    do {
+      digits[count++] = '0' + scaled % 10;
+      scaled /= 10;
+    } while (scaled > 0);
+    //* At least one digit before the point
+    while (count <= precision) {
+      digits[count++] = '0';
+    }
+
+    size_t length = count + (negative ? 1 : 0) + (precision > 0 ? 1 : 0);
+    if (length + 1 > capacity)
+      return 0;
+
+    size_t position = 0;
+    if (negative)
+      out[position++] = '-';
+    for (size_t i = count; i > 0; i--) {
+      if (i == precision)
+        out[position++] = '.';
+      out[position++] = digits[i - 1];
+    }
+    out[position] = '\0';
+    return position;
+  }
+}  // namespace FloatFormat
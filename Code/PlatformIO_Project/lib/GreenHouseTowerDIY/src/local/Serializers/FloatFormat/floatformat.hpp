@@ -0,0 +1,31 @@
+#ifndef FLOATFORMAT_HPP
+#define FLOATFORMAT_HPP
+#include <Arduino.h>
+#include <string>
+
+//* Room for any value format() emits, including the terminator
+#define FLOAT_FORMAT_SIZE 24
+
+/**
+ * @brief Fixed precision float to text without printf
+ * @note The value is scaled by 10^precision, rounded half away from zero and
+ * printed as an integer with the decimal point inserted. The scaling works
+ * on the float's mantissa and exponent in integers, so the exact stored value
+ * is rounded - no soft-float double or printf path, no allocation. Trailing zeros are kept so a channel always has
+ * the same width. NaN and infinities print as null so JSON documents stay
+ * valid.
+ */
+namespace FloatFormat {
+  const uint8_t MAX_PRECISION = 6;
+
+  size_t format(float value, uint8_t precision, char* out, size_t capacity);
+
+  //* Works for any string type, the cycle arena ones included
+  template <typename String>
+  void append(String& out, float value, uint8_t precision) {
+    char buffer[FLOAT_FORMAT_SIZE];
+    out.append(buffer, format(value, precision, buffer, sizeof(buffer)));
+  }
+}  // namespace FloatFormat
+
+#endif
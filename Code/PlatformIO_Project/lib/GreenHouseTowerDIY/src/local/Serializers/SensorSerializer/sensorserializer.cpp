@@ -7,8 +7,19 @@ template <>
 const char* SensorSerializer<int>::fmt = "\"%s\":%d";
 template <>
 const char* SensorSerializer<long>::fmt = "\"%s\":%ld";
+
+//* Floats go through FloatFormat with the precision of the sensor
 template <>
-const char* SensorSerializer<float>::fmt = "\"%s\":%.3f";
+void SensorSerializer<float>::visit(SensorInterface<float>* sensor) {
+  value = sensor->read();
+  precision = sensor->getPrecision();
+  sensorName.assign(sensor->getSensorName());
+
+  serializedData.assign("\"");
+  serializedData.append(sensorName.data(), sensorName.size());
+  serializedData.append("\":");
+  FloatFormat::append(serializedData, value, precision);
+}
 
 //* Specialize for std::string
 template <>
@@ -16,10 +27,12 @@ void SensorSerializer<std::string>::visit(
     SensorInterface<std::string>* sensor) {
   auto read = sensor->read();
 
-  serializedData.assign(Helpers::format_string(
-      "\"%s\":\"%s\"", sensor->getSensorName().c_str(), read.c_str()));
-  value = read;
   sensorName.assign(sensor->getSensorName());
+  serializedData.clear();
+  CycleArena::appendf(serializedData, "\"%s\":\"%s\"", sensorName.c_str(),
+                      read.c_str());
+  value = read;
+  precision = sensor->getPrecision();
 }
 
 //* Specialize for float vectors
@@ -28,15 +41,18 @@ void SensorSerializer<std::vector<float>>::visit(
     SensorInterface<std::vector<float>>* sensor) {
   auto read = sensor->read();
 
-  serializedData.assign(
-      Helpers::format_string("\"%s\":[", sensor->getSensorName().c_str()));
+  sensorName.assign(sensor->getSensorName());
+  serializedData.assign("\"");
+  serializedData.append(sensorName.data(), sensorName.size());
+  serializedData.append("\":[");
+  precision = sensor->getPrecision();
   for (auto&& value : read) {
-    serializedData.append(Helpers::format_string("%.3f,", value));
+    FloatFormat::append(serializedData, value, precision);
+    serializedData.append(",");
   }
   // remove the last comma
   serializedData.pop_back();
   serializedData.append("]");
-  sensorName.assign(sensor->getSensorName());
   value = read;
 }
 
@@ -46,15 +62,18 @@ void SensorSerializer<std::vector<std::string>>::visit(
     SensorInterface<std::vector<std::string>>* sensor) {
   auto read = sensor->read();
 
-  serializedData.assign(
-      Helpers::format_string("\"%s\":[", sensor->getSensorName().c_str()));
+  sensorName.assign(sensor->getSensorName());
+  serializedData.assign("\"");
+  serializedData.append(sensorName.data(), sensorName.size());
+  serializedData.append("\":[");
   for (auto&& value : read) {
-    serializedData.append(Helpers::format_string("\"%s\",", value.c_str()));
+    serializedData.append("\"");
+    serializedData.append(value.c_str());
+    serializedData.append("\",");
   }
   // remove the last comma
   serializedData.pop_back();
   serializedData.append("]");
-  sensorName.assign(sensor->getSensorName());
   value = read;
 }
 
@@ -64,17 +83,22 @@ void SensorSerializer<std::unordered_map<std::string, float>>::visit(
     SensorInterface<std::unordered_map<std::string, float>>* sensor) {
   auto read = sensor->read();
 
-  serializedData.assign(
-      Helpers::format_string("\"%s\":{", sensor->getSensorName().c_str()));
+  sensorName.assign(sensor->getSensorName());
+  serializedData.assign("\"");
+  serializedData.append(sensorName.data(), sensorName.size());
+  serializedData.append("\":{");
 
+  precision = sensor->getPrecision();
   for (auto&& kv : read) {
-    serializedData.append(Helpers::format_string("\"%s\":%.3f,",
-                                                 kv.first.c_str(), kv.second));
+    serializedData.append("\"");
+    serializedData.append(kv.first.c_str());
+    serializedData.append("\":");
+    FloatFormat::append(serializedData, kv.second, precision);
+    serializedData.append(",");
   }
 
   // remove the last comma
   serializedData.pop_back();
   serializedData.append("}");
-  sensorName.assign(sensor->getSensorName());
   value = read;
 }
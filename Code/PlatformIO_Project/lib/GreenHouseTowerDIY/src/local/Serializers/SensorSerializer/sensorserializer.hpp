@@ -4,6 +4,8 @@
 #include <string>
 #include <unordered_map>
 #include <utilities/helpers.hpp>
+#include "local/Serializers/FloatFormat/floatformat.hpp"
+#include "local/data/arena/cyclearena.hpp"
 #include "local/data/visitor.hpp"
 
 template <typename T>
@@ -15,16 +17,22 @@ class SensorSerializer : public Visitor<SensorInterface<T>> {
   void visit(SensorInterface<T>* sensor) override {
     auto read = sensor->read();
 
-    log_d("Serializing %s", sensor->getSensorName().c_str());
-    serializedData.assign(
-        Helpers::format_string(fmt, sensor->getSensorName().c_str(), read));
-    value = read;
     sensorName.assign(sensor->getSensorName());
+    log_d("Serializing %s", sensorName.c_str());
+    serializedData.clear();
+    CycleArena::appendf(serializedData, fmt, sensorName.c_str(), read);
+    value = read;
+    precision = sensor->getPrecision();
   };
 
-  std::string serializedData;
-  std::string sensorName;
+  //* Drop the arena buffer, must run before the arena is reset
+  void release() { CycleArena::String().swap(serializedData); }
+
+  //* Lives in the cycle arena, valid until the end of the cycle
+  CycleArena::String serializedData;
+  SensorName_t sensorName;
   T value;
+  uint8_t precision = 3;
 };
 
 #endif
\ No newline at end of file
@@ -1,4 +1,20 @@
 #include "accumulatedata.hpp"
+#include <algorithm>
+
+//* Must follow Telemetry::Channel_e, {absolute, relative}
+const AccumulateData::Deadband_t
+    AccumulateData::default_deadbands[Telemetry::CHANNEL_COUNT] = {
+        {0.0f, 0.05f},  // ldr, 5 %
+        {0.5f, 0.0f},   // water level
+        {1.0f, 0.0f},   // water level percentage
+        {0.2f, 0.0f},   // tower temperature
+        {1.0f, 0.0f},   // dht humidity
+        {0.2f, 0.0f},   // dht temperature
+        {1.0f, 0.0f},   // sht31 1 humidity
+        {0.2f, 0.0f},   // sht31 1 temperature
+        {1.0f, 0.0f},   // sht31 2 humidity
+        {0.2f, 0.0f},   // sht31 2 temperature
+};
 
 AccumulateData::AccumulateData(GreenHouseConfig& config,
                                ProjectConfig& deviceConfig,
@@ -7,7 +23,11 @@ AccumulateData::AccumulateData(GreenHouseConfig& config,
                                Humidity& humidity,
                                WaterLevelSensor& waterlevelsensor,
                                NetworkNTP& ntp,
-                               BaseMQTT& mqtt)
+                               BaseMQTT& mqtt,
+                               DataSnapshot& snapshot,
+                               HistoryStore& history,
+                               FlashLog& flashLog,
+                               Clock& clock)
     : _config(config),
       _deviceConfig(deviceConfig),
       _ldr(ldr),
@@ -22,20 +42,117 @@ AccumulateData::AccumulateData(GreenHouseConfig& config,
       _vectorFloatSensorSerializer(),
       _humiditySerializer(),
       _mqtt(mqtt),
-      _gatherDataTimer(60000),
+      _snapshot(snapshot),
+      _history(history),
+      _flashLog(flashLog),
+      _clock(clock),
+      _gatherInterval(60000),
+      _lastGather(0),
+      _cycles(0),
+      _cycleMicros(0),
+      _cycleHeap(0),
       _maxTemp(100),
       _numTempSensors(0),
       _sensors{
-          &_ldr,
-          &_waterLevelSensor,
-          &_waterLevelPercentage,
-      } {}
+          {&_ldr, Telemetry::LDR, Topics::LDR, 3, AllocTracker::LDR},
+          {&_waterLevelSensor, Telemetry::WATER_LEVEL, Topics::WATER_LEVEL, 3,
+           AllocTracker::WATER_LEVEL},
+          {&_waterLevelPercentage, Telemetry::WATER_LEVEL_PERCENTAGE,
+           Topics::WATER_LEVEL_PERCENTAGE, 3,
+           AllocTracker::WATER_LEVEL_PERCENTAGE},
+      },
+      _lastExportHour(0),
+      _readRequested(false),
+      _pendingInterval(0),
+#if ALLOC_TRACKING
+      _heapReportRequested(false),
+#endif  // ALLOC_TRACKING
+      _deadbandRevision(0),
+      _cborLength(0) {
+  Telemetry::clear(_sample);
+  loadDeadbands(std::string());
+  for (auto& reported : _reported) {
+    reported = {NAN, 0};
+  }
+}
 
 AccumulateData::~AccumulateData() {}
 
-void AccumulateData::begin() {}
+/**
+ * @brief Register the acquisition commands and start the schedule
+ * @note cmd/read runs a cycle right away, cmd/sample_rate takes the interval
+ * in milliseconds (1 s to 1 h). Allocation tracking builds add
+ * cmd/heap_report, answered on <prefix>/heap with AllocTracker::toJson()
+ * @note The first scheduled cycle runs one interval after begin(), which
+ * leaves NTP time to sync before a sample is timestamped
+ * @note Binds the cycle arena to the calling task, call it from the task
+ * running loop()
+ */
+void AccumulateData::begin() {
+  CycleArena::begin();
+  _lastGather = _clock.millis();
+
+  _mqtt.getRouter().on("read", [this](const char* payload, size_t length) {
+    _readRequested = true;
+  });
+
+  _mqtt.getRouter().on(
+      "sample_rate", [this](const char* payload, size_t length) {
+        uint32_t interval;
+        if (CommandRouter::parseUInt(payload, length, interval) &&
+            interval >= 1000 && interval <= 3600000)
+          _pendingInterval = interval;
+      });
+
+#if ALLOC_TRACKING
+  _mqtt.getRouter().on(
+      "heap_report", [this](const char* payload, size_t length) {
+        _heapReportRequested = true;
+      });
+#endif  // ALLOC_TRACKING
+}
 
 //* Collect the data
+/**
+ * @brief Run an acquisition cycle when the interval elapsed or one was asked
+ * for
+ * @note The cycle's hardware time and the free heap it kept are recorded for
+ * the replay harness and the diagnostics, allocation tracking builds also
+ * count its heap traffic per phase and sensor
+ * @note The serializer buffers are dropped and the cycle arena reset before
+ * the cycle is closed, its strings never outlive it
+ */
+void AccumulateData::loop() {
+  uint32_t interval = _pendingInterval.exchange(0);
+  if (interval != 0) {
+    log_i("[Accumulate Data]: Sample interval set to %u ms", interval);
+    _gatherInterval = interval;
+  }
+
+#if ALLOC_TRACKING
+  if (_heapReportRequested.exchange(false) && _mqtt.mqttConnected()) {
+    MQTTTopic_t topic(_mqtt.getTopics().getPrefix());
+    topic.append("heap");
+    _mqtt.dataHandler(topic, AllocTracker::toJson());
+  }
+#endif  // ALLOC_TRACKING
+
+  if (_clock.millis() - _lastGather >= _gatherInterval ||
+      _readRequested.exchange(false)) {
+    uint32_t start = micros();
+    uint32_t heap = ESP.getFreeHeap();
+    AllocTracker::beginCycle();
+    cycle();
+    releaseBuffers();
+    CycleArena::reset();
+    AllocTracker::endCycle(_clock.millis());
+    _lastGather = _clock.millis();
+    _cycleMicros = micros() - start;
+    _cycleHeap = (int32_t)(heap - ESP.getFreeHeap());
+    _cycles++;
+  }
+}
+
 /**
  * @brief Accumulate Data to send from sensors and store in json.
  * @note This function accumulates all sensor data and stores it in the main
@@ -43,80 +160,319 @@ void AccumulateData::begin() {}
  * @parameters: None
  * @return void
  */
-void AccumulateData::loop() {
-  if (_gatherDataTimer.ding()) {
-    _ntp.ntpLoop();
+void AccumulateData::cycle() {
+  Telemetry::clear(_sample);
+  _sample.timestamp_ms = _ntp.getEpochMillis();
+  _sample.timestamp = _sample.timestamp_ms / 1000;
+  _sample.uptime = _clock.micros() / 1000000;
 
-    std::string json = "{";
+  //* The document carries its acquisition time, so it stays meaningful
+  //* when delivered late from the outbox. Before the first NTP sync the
+  //* timestamp is 0 and only the uptime dates it, a later document of the
+  //* same boot maps uptime to epoch time. Sized after the last document, so
+  //* it is not reallocated while it grows.
+  CycleArena::String json;
+  json.reserve(_deviceConfig.getDeviceDataJson().deviceJson.size() + 16);
+  CycleArena::appendf(
+      json, "{\"timestamp\":%u,\"timestamp_ms\":%llu,\"uptime\":%u,",
+      _sample.timestamp, (unsigned long long)_sample.timestamp_ms,
+      _sample.uptime);
 
-    log_d("[Accumulate Data]: Gathering data...");
-    _ntp.accept(_stringSensorSerializer);
+  log_d("[Accumulate Data]: Gathering data...");
+  AllocTracker::enter(AllocTracker::NTP);
+  _ntp.accept(_stringSensorSerializer);
 
-    log_d("[Accumulate Data]: Tower");
-    _towertemp.accept(_vectorFloatSensorSerializer);
+  log_d("[Accumulate Data]: Tower");
+  AllocTracker::enter(AllocTracker::TOWER_TEMP);
+  _towertemp.accept(_vectorFloatSensorSerializer);
 
-    log_d("[Accumulate Data]: Humidity");
-    _humidity.accept(_humiditySerializer);
+  log_d("[Accumulate Data]: Humidity");
+  AllocTracker::enter(AllocTracker::HUMIDITY);
+  _humidity.accept(_humiditySerializer);
 
-    //* Pass the data to the mqtt client
-    log_d("[Accumulate Data]: Humidity");
+  //* build the json string
+  AllocTracker::enter(AllocTracker::DOCUMENT);
+  json.append(_stringSensorSerializer.serializedData);
 
-    log_d("[Accumulate Data]: %s", _mqtt.mqttConnected() ? "true" : "false");
+  json.append(",");
 
-    if (_mqtt.mqttConnected()) {
-      log_d("[Accumulate Data]: NTPTimer MQTT");
-      _mqtt.dataHandler(_stringSensorSerializer.sensorName,
-                        _stringSensorSerializer.value);
-      log_d("[Accumulate Data]: Tower MQTT");
-      _mqtt.dataHandler(_vectorFloatSensorSerializer.sensorName,
-                        _vectorFloatSensorSerializer.serializedData);
-      log_d("[Accumulate Data]: Humidity MQTT");
-      _mqtt.dataHandler(_humiditySerializer.sensorName,
-                        _humiditySerializer.serializedData);
-    }
+  //* Serialize the temperature vector
+  json.append(_vectorFloatSensorSerializer.serializedData);
+
+  json.append(",");
+
+  //* Serialize the humidity
+  json.append(_humiditySerializer.serializedData);
+
+  json.append(",");
+
+  //* Generate JSON for the sensors
+  for (auto it = _sensors.begin(); it != _sensors.end(); ++it) {
+    //* serialize the data
+    log_d("[Accumulate Data]: Sensors");
+    AllocTracker::enter(it->scope);
+    it->sensor->accept(_floatSensorSerializer);
+    _sample.values[it->channel] = _floatSensorSerializer.value;
+    it->precision = _floatSensorSerializer.precision;
+
+    //* add the data to the json string
+    AllocTracker::enter(AllocTracker::DOCUMENT);
+    json.append(_floatSensorSerializer.serializedData);
+
+    if (it != _sensors.end() - 1)
+      json.append(",");
+  }
+
+  json.append("}");
+  _deviceConfig.getDeviceDataJson().deviceJson.assign(json.data(),
+                                                      json.size());
+  AllocTracker::enter(AllocTracker::ENCODE);
+  buildSample();
+  _cborLength = TelemetryCbor::encode(_sample,
+                                      _vectorFloatSensorSerializer.value,
+                                      _cbor, sizeof(_cbor));
+  if (_cborLength == 0)
+    log_e("[Accumulate Data]: CBOR cycle with %u probes is over %u bytes, "
+          "raise TELEMETRY_CBOR_MAX_PROBES",
+          _vectorFloatSensorSerializer.value.size(), sizeof(_cbor));
+  AllocTracker::enter(AllocTracker::SNAPSHOT);
+  _snapshot.update(json.data(), json.size(), _cbor, _cborLength);
+
+#if SENSOR_TRACE_REPLAY
+  //* Replayed cycles stay off MQTT and flash, only the RAM history keeps them
+  AllocTracker::enter(AllocTracker::HISTORY);
+  if (_sample.timestamp != 0)
+    _history.insert(_sample);
+#else
+  //* Pass the data to the mqtt client, only what moved past its deadband
+  AllocTracker::enter(AllocTracker::PUBLISH);
+  publish(json);
+
+  //* Keep the cycle in the on-device history
+  AllocTracker::enter(AllocTracker::HISTORY);
+  if (_sample.timestamp != 0) {
+    _history.insert(_sample);
+    _flashLog.append(_sample);
+    exportHistory();
+  }
+#endif  // SENSOR_TRACE_REPLAY
+
+  log_d("[Data Json Document]: %s", json.c_str());
+  AllocTracker::enter(AllocTracker::CYCLE);
+}
+
+/**
+ * @brief Publish the cycle according to the publish mode
+ * @note With report by exception only channels that left their deadband, or
+ * whose heartbeat expired, count as changed. The batched document goes out
+ * when anything changed, per sensor topics only for their own channels.
+ * @note Channels only count as reported once their message was published or
+ * queued, a cycle dropped while disconnected is sent again next cycle.
+ */
+void AccumulateData::publish(const CycleArena::String& json) {
+  Project_Config::MQTTConfig_t& mqtt = _config.getMQTTConfig();
+  uint32_t changed = changedChannels();
+  if (changed == 0) {
+    log_d("[Accumulate Data]: No channel left its deadband, nothing sent");
+    return;
+  }
+
+  //* One message for the whole cycle, queued while disconnected
+  bool sent = false;
+  if (mqtt.publish_mode != GreenHouseConfig::MqttPublish_t::PER_SENSOR) {
+    if (mqtt.encoding == GreenHouseConfig::Encoding_t::ENCODING_CBOR)
+      sent = _mqtt.publishCycle(reinterpret_cast<const char*>(_cbor),
+                                _cborLength, _sample.timestamp);
+    else
+      sent = _mqtt.publishCycle(json.c_str(), json.length(),
+                                _sample.timestamp);
+  }
 
-    //* build the json string
-    json.append(Helpers::format_string(
-        "%s", _stringSensorSerializer.serializedData.c_str()));
+  if (mqtt.publish_mode == GreenHouseConfig::MqttPublish_t::BATCHED ||
+      !_mqtt.mqttConnected()) {
+    if (sent)
+      markReported(changed);
+    return;
+  }
+
+  log_d("[Accumulate Data]: NTPTimer MQTT");
+  _mqtt.dataHandler(_mqtt.getTopics().get(Topics::NTP),
+                    _stringSensorSerializer.value);
+
+  if (changed & (1UL << Telemetry::TOWER_TEMP)) {
+    log_d("[Accumulate Data]: Tower MQTT");
+    _mqtt.dataHandler(_mqtt.getTopics().get(Topics::TEMPERATURE),
+                      _vectorFloatSensorSerializer.serializedData);
+  }
+
+  const uint32_t humidityChannels =
+      (1UL << Telemetry::DHT_HUM) | (1UL << Telemetry::DHT_TEMP) |
+      (1UL << Telemetry::SHT31_1_HUM) | (1UL << Telemetry::SHT31_1_TEMP) |
+      (1UL << Telemetry::SHT31_2_HUM) | (1UL << Telemetry::SHT31_2_TEMP);
+  if (changed & humidityChannels) {
+    log_d("[Accumulate Data]: Humidity MQTT");
+    _mqtt.dataHandler(_mqtt.getTopics().get(Topics::HUMIDITY),
+                      _humiditySerializer.serializedData);
+  }
 
-    json.append(",");
+  for (auto&& sensor : _sensors) {
+    if (changed & (1UL << sensor.channel)) {
+      log_d("[Accumulate Data]: Sensors MQTT");
+      _mqtt.dataHandler(_mqtt.getTopics().get(sensor.topic),
+                        _sample.values[sensor.channel], sensor.precision);
+    }
+  }
+  markReported(changed);
+}
 
-    //* Serialize the temperature vector
-    json.append(Helpers::format_string(
-        "%s", _vectorFloatSensorSerializer.serializedData.c_str()));
+/**
+ * @brief Channels of the cycle sample worth reporting, as a bit mask
+ * @note Every channel counts as changed when report by exception is off.
+ * Compares against the last reported value, see markReported().
+ */
+uint32_t AccumulateData::changedChannels() {
+  Project_Config::MQTTConfig_t& mqtt = _config.getMQTTConfig();
+  if (!mqtt.report_by_exception)
+    return (1UL << Telemetry::CHANNEL_COUNT) - 1;
 
-    json.append(",");
+  if (_deadbandRevision != _config.getRevision()) {
+    _deadbandRevision = _config.getRevision();
+    loadDeadbands(mqtt.deadbands);
+  }
 
-    //* Serialize the humidity
-    json.append(Helpers::format_string(
-        "%s", _humiditySerializer.serializedData.c_str()));
+  uint32_t now = _clock.millis();
+  uint32_t heartbeat = mqtt.heartbeat_s * 1000UL;
+  uint32_t changed = 0;
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    float value = _sample.values[c];
+    float last = _reported[c].value;
+    bool report;
+    if (isnan(value) || isnan(last)) {
+      report = isnan(value) != isnan(last);
+    } else {
+      float band = std::max(_deadbands[c].absolute,
+                            _deadbands[c].relative * fabsf(last));
+      report = fabsf(value - last) > band;
+    }
+    if (!report && !(isnan(value) && isnan(last)))
+      report = now - _reported[c].time >= heartbeat;
 
-    json.append(",");
+    if (report)
+      changed |= 1UL << c;
+  }
+  return changed;
+}
 
-    //* Generate JSON for the sensors
-    for (auto it = _sensors.begin(); it != _sensors.end(); ++it) {
-      //* serialize the data
-      log_d("[Accumulate Data]: Sensors");
-      (*it)->accept(_floatSensorSerializer);
+/**
+ * @brief Remember the cycle values of channels that were delivered
+ * @note Only reported channels move their baseline, so a slow drift still
+ * crosses the band eventually
+ */
+void AccumulateData::markReported(uint32_t channels) {
+  uint32_t now = _clock.millis();
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    if (channels & (1UL << c)) {
+      _reported[c].value = _sample.values[c];
+      _reported[c].time = now;
+    }
+  }
+}
 
-      //* add the data to the json string
-      json.append(Helpers::format_string(
-          "%s", _floatSensorSerializer.serializedData.c_str()));
+/**
+ * @brief Default deadbands, then the configured overrides
+ * @note Overrides are channel:absolute:relative entries separated by ';',
+ * e.g. "temperature:0.5:0;ldr:0:0.1"
+ */
+void AccumulateData::loadDeadbands(const std::string& overrides) {
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    _deadbands[c] = default_deadbands[c];
+  }
 
-      if (it != _sensors.end() - 1)
-        json.append(",");
+  size_t start = 0;
+  while (start < overrides.length()) {
+    size_t end = overrides.find(';', start);
+    if (end == std::string::npos)
+      end = overrides.length();
+    size_t first = overrides.find(':', start);
+    size_t second =
+        first < end ? overrides.find(':', first + 1) : std::string::npos;
+    if (second < end) {
+      Telemetry::Channel_e channel = Telemetry::channelFromName(
+          overrides.c_str() + start, first - start);
+      if (channel != Telemetry::CHANNEL_COUNT) {
+        _deadbands[channel].absolute = atof(overrides.c_str() + first + 1);
+        _deadbands[channel].relative = atof(overrides.c_str() + second + 1);
+      }
+    }
+    start = end + 1;
+  }
+}
 
-      //* Pass the data to the mqtt client
-      if (_mqtt.mqttConnected())
-        log_d("[Accumulate Data]: Sensors MQTT");
-      _mqtt.dataHandler(_floatSensorSerializer.sensorName,
-                        _floatSensorSerializer.value);
+/**
+ * @brief Fill the vector and map valued channels of the cycle sample
+ * @note The scalar sensors are written while they are serialized
+ */
+void AccumulateData::buildSample() {
+  //* Tower temperature is the mean of all DS18B20 probes
+  const Temp_Array_t& temps = _vectorFloatSensorSerializer.value;
+  if (!temps.empty()) {
+    float sum = 0;
+    for (auto&& temp : temps) {
+      sum += temp;
     }
+    _sample.values[Telemetry::TOWER_TEMP] = sum / temps.size();
+  }
+
+  for (auto&& kv : _humiditySerializer.value) {
+    Telemetry::Channel_e channel = Telemetry::channelFromName(kv.first);
+    if (channel != Telemetry::CHANNEL_COUNT)
+      _sample.values[channel] = kv.second;
+  }
+}
+
+//* Give the serializers' arena buffers back before CycleArena::reset()
+void AccumulateData::releaseBuffers() {
+  _floatSensorSerializer.release();
+  _stringSensorSerializer.release();
+  _vectorStringSensorSerializer.release();
+  _vectorFloatSensorSerializer.release();
+  _humiditySerializer.release();
+}
+
+const Telemetry::Sample_t& AccumulateData::getSample() {
+  return _sample;
+}
 
-    json.append("}");
-    _deviceConfig.getDeviceDataJson().deviceJson.assign(json);
+/**
+ * @brief Publish the last complete hour of raw history, compressed
+ * @note One Gorilla stream per channel on <prefix>/history/<channel>, sent
+ * once per hour when history export is enabled
+ */
+void AccumulateData::exportHistory() {
+  uint32_t hour = _sample.timestamp / 3600;
+  if (!_config.getMQTTConfig().history_export || hour == _lastExportHour ||
+      !_mqtt.mqttConnected())
+    return;
+
+  //* First cycle after boot only arms the export
+  if (_lastExportHour == 0) {
+    _lastExportHour = hour;
+    return;
+  }
+  _lastExportHour = hour;
 
-    log_d("[Data Json Document]: %s", json.c_str());
-    _gatherDataTimer.start();
+  uint32_t to = hour * 3600 - 1;
+  uint32_t from = to - 3599;
+  std::vector<uint8_t> buffer(GorillaEncoder::maxSize(HISTORY_RAW_SLOTS));
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    Telemetry::Channel_e channel = static_cast<Telemetry::Channel_e>(c);
+    GorillaEncoder encoder(buffer.data(), buffer.size());
+    if (_history.encode(channel, History::RAW, from, to, encoder) == 0)
+      continue;
+    size_t length = encoder.finish();
+    log_d("[Accumulate Data]: History export %s - %u points in %u bytes",
+          Telemetry::channelName(channel), encoder.getCount(), length);
+    _mqtt.dataHandler(_mqtt.getTopics().history(channel), buffer.data(),
+                      length);
   }
 }
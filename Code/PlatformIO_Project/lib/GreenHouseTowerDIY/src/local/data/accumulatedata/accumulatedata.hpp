@@ -1,11 +1,20 @@
 #ifndef ACCUMULATEDATA_HPP
 #define ACCUMULATEDATA_HPP
+#include <atomic>
 
 //* Network Includes
 #include "local/network/mqtt/basic/basicmqtt.hpp"
 
 //* Data Struct
+#include <local/data/alloctrack/alloctracker.hpp>
+#include <local/data/arena/cyclearena.hpp>
+#include <local/data/clock/clock.hpp>
+#include <local/data/codec/cbor.hpp>
 #include <local/data/config/config.hpp>
+#include <local/data/history/flashlog.hpp>
+#include <local/data/history/historystore.hpp>
+#include <local/data/snapshot/datasnapshot.hpp>
+#include <local/data/telemetry/telemetry.hpp>
 #include "local/Serializers/SensorSerializer/sensorserializer.hpp"
 #include "local/data/visitor.hpp"
 
@@ -19,6 +28,29 @@
 #include <local/network/ntp/ntp.hpp>
 
 class AccumulateData {
+ public:
+  struct Deadband_t {
+    float absolute;
+    float relative;  // fraction of the last reported value
+  };
+
+ private:
+  //* Last reported value per channel, for report by exception
+  struct Reported_t {
+    float value;
+    uint32_t time;  // clock ms
+  };
+
+  static const Deadband_t default_deadbands[Telemetry::CHANNEL_COUNT];
+
+  struct SensorChannel_t {
+    Element<Visitor<SensorInterface<float>>>* sensor;
+    Telemetry::Channel_e channel;
+    Topics::Topic_e topic;
+    uint8_t precision;  // taken from the sensor on each read
+    AllocTracker::Scope_e scope;
+  };
+
   GreenHouseConfig& _config;
   ProjectConfig& _deviceConfig;
   LDR& _ldr;
@@ -33,12 +65,48 @@ class AccumulateData {
   SensorSerializer<Temp_Array_t> _vectorFloatSensorSerializer;
   SensorSerializer<Humidity_Return_t> _humiditySerializer;
   BaseMQTT& _mqtt;
-  timeObj _gatherDataTimer;
+  DataSnapshot& _snapshot;
+  HistoryStore& _history;
+  FlashLog& _flashLog;
+  Clock& _clock;
+  uint32_t _gatherInterval;  // ms
+  uint32_t _lastGather;
+
+  //* Cost of the last cycle, hardware time and free heap it kept
+  uint32_t _cycles;
+  uint32_t _cycleMicros;
+  int32_t _cycleHeap;
 
   // Stack Data to send
   int _maxTemp;
   int _numTempSensors;
-  std::vector<Element<Visitor<SensorInterface<float>>>*> _sensors;
+  std::vector<SensorChannel_t> _sensors;
+  Telemetry::Sample_t _sample;
+  uint32_t _lastExportHour;
+
+  //* Written from the MQTT task by the command handlers
+  std::atomic<bool> _readRequested;
+  std::atomic<uint32_t> _pendingInterval;
+#if ALLOC_TRACKING
+  std::atomic<bool> _heapReportRequested;
+#endif  // ALLOC_TRACKING
+
+  Deadband_t _deadbands[Telemetry::CHANNEL_COUNT];
+  Reported_t _reported[Telemetry::CHANNEL_COUNT];
+  uint32_t _deadbandRevision;
+
+  //* Binary form of the cycle, see TelemetryCbor
+  uint8_t _cbor[TELEMETRY_CBOR_SIZE];
+  size_t _cborLength;
+
+  void cycle();
+  void buildSample();
+  void publish(const CycleArena::String& json);
+  uint32_t changedChannels();
+  void markReported(uint32_t channels);
+  void loadDeadbands(const std::string& overrides);
+  void exportHistory();
+  void releaseBuffers();
 
  public:
   AccumulateData(GreenHouseConfig& config,
@@ -48,10 +116,18 @@ class AccumulateData {
                  Humidity& humidity,
                  WaterLevelSensor& waterlevelsensor,
                  NetworkNTP& ntp,
-                 BaseMQTT& mqtt);
+                 BaseMQTT& mqtt,
+                 DataSnapshot& snapshot,
+                 HistoryStore& history,
+                 FlashLog& flashLog,
+                 Clock& clock);
   virtual ~AccumulateData();
 
   void begin();
   void loop();
+  const Telemetry::Sample_t& getSample();
+  uint32_t getCycleCount() const { return _cycles; }
+  uint32_t getCycleMicros() const { return _cycleMicros; }
+  int32_t getCycleHeap() const { return _cycleHeap; }
 };
 #endif
@@ -0,0 +1,257 @@
+#include "alloctracker.hpp"
+
+#if ALLOC_TRACKING
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include <esp_heap_trace.h>
+
+//* Blocks traced per cycle, the ones still held at its end are its leaks
+#ifndef ALLOC_TRACE_RECORDS
+#define ALLOC_TRACE_RECORDS 64
+#endif  // ALLOC_TRACE_RECORDS
+#endif  // CONFIG_HEAP_TRACING_STANDALONE
+
+namespace AllocTracker {
+  //* Must follow AllocTracker::Scope_e
+  static const char* const scope_names[SCOPE_COUNT] = {
+      "other",
+      "cycle",
+      "ntp",
+      "temperature",
+      "humidity",
+      "ldr",
+      "water_level_sensor",
+      "water_level_percentage",
+      "document",
+      "encode",
+      "snapshot",
+      "publish",
+      "history",
+  };
+
+  //* Running totals, written from any task
+  static std::atomic<uint32_t> allocs[SCOPE_COUNT];
+  static std::atomic<uint32_t> frees[SCOPE_COUNT];
+  static std::atomic<uint32_t> bytes[SCOPE_COUNT];
+
+  //* Scope of the owner task, only that task moves it
+  static volatile Scope_e current = OTHER;
+  static volatile TaskHandle_t owner = nullptr;
+
+  static Counter_t start[SCOPE_COUNT];
+  static Counter_t cycle[SCOPE_COUNT];
+  static uint32_t leaks = 0;
+
+  static Trend_t trend[ALLOC_TREND_SLOTS];
+  static size_t trendHead = 0;
+  static size_t trendCount = 0;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+  static heap_trace_record_t records[ALLOC_TRACE_RECORDS];
+  static bool tracing = false;
+#endif  // CONFIG_HEAP_TRACING_STANDALONE
+
+  static inline Scope_e charged() {
+    return xTaskGetCurrentTaskHandle() == owner ? current : OTHER;
+  }
+
+  static void onAlloc(size_t size) {
+    Scope_e scope = charged();
+    allocs[scope]++;
+    bytes[scope] += size;
+  }
+
+  static void onFree() {
+    frees[charged()]++;
+  }
+
+  /**
+   * @brief Start counting a cycle on the calling task
+   * @note Everything it allocates goes to CYCLE until enter() narrows it
+   */
+  void beginCycle() {
+    owner = xTaskGetCurrentTaskHandle();
+    for (uint8_t s = 0; s < SCOPE_COUNT; s++) {
+      start[s] = {allocs[s], frees[s], bytes[s]};
+    }
+    current = CYCLE;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (!tracing)
+      tracing = heap_trace_init_standalone(records, ALLOC_TRACE_RECORDS) ==
+                ESP_OK;
+    if (tracing)
+      heap_trace_start(HEAP_TRACE_LEAKS);
+#endif  // CONFIG_HEAP_TRACING_STANDALONE
+  }
+
+  void enter(Scope_e scope) {
+    current = scope;
+  }
+
+  //* Close the cycle, keep its counts and sample the heap
+  void endCycle(uint32_t now) {
+    current = OTHER;
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (tracing) {
+      heap_trace_stop();
+      leaks = heap_trace_get_count();
+    }
+#endif  // CONFIG_HEAP_TRACING_STANDALONE
+
+    for (uint8_t s = 0; s < SCOPE_COUNT; s++) {
+      cycle[s] = {allocs[s] - start[s].allocs, frees[s] - start[s].frees,
+                  bytes[s] - start[s].bytes};
+    }
+
+    uint32_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    Trend_t* last =
+        trendCount ? &trend[(trendHead + ALLOC_TREND_SLOTS - 1) %
+                            ALLOC_TREND_SLOTS]
+                   : nullptr;
+    if (!last || now - last->time >= ALLOC_TREND_PERIOD_MS) {
+      trend[trendHead] = {now, freeHeap, largest};
+      trendHead = (trendHead + 1) % ALLOC_TREND_SLOTS;
+      if (trendCount < ALLOC_TREND_SLOTS)
+        trendCount++;
+    } else {
+      last->freeHeap = std::min(last->freeHeap, freeHeap);
+      last->largestBlock = std::min(last->largestBlock, largest);
+    }
+
+    Counter_t total = getCycleTotal();
+    log_d(
+        "[Alloc Tracker]: Cycle %u allocs, %u frees, %u bytes, %u leaked, "
+        "largest block %u of %u free",
+        total.allocs, total.frees, total.bytes, leaks, largest, freeHeap);
+  }
+
+  const char* scopeName(Scope_e scope) {
+    return scope < SCOPE_COUNT ? scope_names[scope] : "unknown";
+  }
+
+  Counter_t getCycle(Scope_e scope) {
+    return scope < SCOPE_COUNT ? cycle[scope] : Counter_t{0, 0, 0};
+  }
+
+  //* Every scope but OTHER, i.e. what the cycle's own task did
+  Counter_t getCycleTotal() {
+    Counter_t total = {0, 0, 0};
+    for (uint8_t s = CYCLE; s < SCOPE_COUNT; s++) {
+      total.allocs += cycle[s].allocs;
+      total.frees += cycle[s].frees;
+      total.bytes += cycle[s].bytes;
+    }
+    return total;
+  }
+
+  uint32_t getCycleLeaks() {
+    return leaks;
+  }
+
+  //* Oldest period first
+  size_t getTrend(Trend_t* out, size_t capacity) {
+    size_t count = std::min(capacity, trendCount);
+    for (size_t i = 0; i < count; i++) {
+      out[i] = trend[(trendHead + ALLOC_TREND_SLOTS - count + i) %
+                     ALLOC_TREND_SLOTS];
+    }
+    return count;
+  }
+
+  /**
+   * @brief Last cycle per scope and the heap trend
+   * @note {"cycle":{"allocs":..,"frees":..,"bytes":..},"leaks":..,
+   * "scopes":{"ntp":[allocs,frees,bytes],..},"trend":[[ms,free,largest],..]}
+   * Scopes without traffic are left out.
+   */
+  std::string toJson() {
+    Counter_t total = getCycleTotal();
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer),
+             "{\"cycle\":{\"allocs\":%u,\"frees\":%u,\"bytes\":%u},"
+             "\"leaks\":%u,\"scopes\":{",
+             total.allocs, total.frees, total.bytes, leaks);
+    std::string json(buffer);
+
+    bool first = true;
+    for (uint8_t s = 0; s < SCOPE_COUNT; s++) {
+      if (cycle[s].allocs == 0 && cycle[s].frees == 0)
+        continue;
+      snprintf(buffer, sizeof(buffer), "%s\"%s\":[%u,%u,%u]",
+               first ? "" : ",", scope_names[s], cycle[s].allocs,
+               cycle[s].frees, cycle[s].bytes);
+      json.append(buffer);
+      first = false;
+    }
+
+    json.append("},\"trend\":[");
+    Trend_t periods[ALLOC_TREND_SLOTS];
+    size_t count = getTrend(periods, ALLOC_TREND_SLOTS);
+    for (size_t i = 0; i < count; i++) {
+      snprintf(buffer, sizeof(buffer), "%s[%u,%u,%u]", i ? "," : "",
+               periods[i].time, periods[i].freeHeap, periods[i].largestBlock);
+      json.append(buffer);
+    }
+    json.append("]}");
+    return json;
+  }
+}  // namespace AllocTracker
+
+//* Replaceable global allocation functions, everything else routes here
+void* operator new(size_t size) {
+  void* block = malloc(size ? size : 1);
+  if (!block)
+    abort();
+  AllocTracker::onAlloc(size);
+  return block;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  void* block = malloc(size ? size : 1);
+  if (block)
+    AllocTracker::onAlloc(size);
+  return block;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* block) noexcept {
+  if (!block)
+    return;
+  AllocTracker::onFree();
+  free(block);
+}
+
+void operator delete[](void* block) noexcept {
+  operator delete(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+  operator delete(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+  operator delete(block);
+}
+
+#if __cpp_sized_deallocation
+void operator delete(void* block, size_t size) noexcept {
+  operator delete(block);
+}
+
+void operator delete[](void* block, size_t size) noexcept {
+  operator delete(block);
+}
+#endif  // __cpp_sized_deallocation
+#endif  // ALLOC_TRACKING
@@ -0,0 +1,84 @@
+#ifndef ALLOCTRACKER_HPP
+#define ALLOCTRACKER_HPP
+#include <Arduino.h>
+#include <string>
+
+//* Build with -DALLOC_TRACKING=1 to count heap traffic
+#ifndef ALLOC_TRACKING
+#define ALLOC_TRACKING 0
+#endif  // ALLOC_TRACKING
+
+//* Largest free block history, one minimum per period
+#ifndef ALLOC_TREND_SLOTS
+#define ALLOC_TREND_SLOTS 48
+#endif  // ALLOC_TREND_SLOTS
+
+#ifndef ALLOC_TREND_PERIOD_MS
+#define ALLOC_TREND_PERIOD_MS 3600000UL
+#endif  // ALLOC_TREND_PERIOD_MS
+
+/**
+ * @brief Heap traffic per acquisition phase and per sensor
+ * @note With ALLOC_TRACKING the global operator new and delete are replaced
+ * by counting ones. Allocations of the task that opened a scope are charged
+ * to that scope, those of every other task (network, web server) to OTHER.
+ * When the IDF was built with standalone heap tracing, malloc is traced
+ * during the cycle as well and the blocks it still holds are reported.
+ * @note The free heap and the largest free block are sampled after every
+ * cycle, their minimum per ALLOC_TREND_PERIOD_MS is kept for the last
+ * ALLOC_TREND_SLOTS periods. A largest block shrinking while the free heap
+ * holds steady is fragmentation.
+ * @note Without ALLOC_TRACKING the cycle marks compile to nothing.
+ */
+namespace AllocTracker {
+  enum Scope_e : uint8_t {
+    OTHER,
+    CYCLE,
+    NTP,
+    TOWER_TEMP,
+    HUMIDITY,
+    LDR,
+    WATER_LEVEL,
+    WATER_LEVEL_PERCENTAGE,
+    DOCUMENT,
+    ENCODE,
+    SNAPSHOT,
+    PUBLISH,
+    HISTORY,
+    SCOPE_COUNT
+  };
+
+  struct Counter_t {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t bytes;  // requested, frees are not sized
+  };
+
+  struct Trend_t {
+    uint32_t time;  // clock ms at the start of the period
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+  };
+
+#if ALLOC_TRACKING
+  void beginCycle();
+  //* Charge what the cycle's task allocates from now on to scope
+  void enter(Scope_e scope);
+  void endCycle(uint32_t now);
+
+  const char* scopeName(Scope_e scope);
+  //* Counts of the last complete cycle
+  Counter_t getCycle(Scope_e scope);
+  Counter_t getCycleTotal();
+  //* malloc blocks the last cycle still held, 0 without heap tracing
+  uint32_t getCycleLeaks();
+  size_t getTrend(Trend_t* out, size_t capacity);
+  std::string toJson();
+#else
+  inline void beginCycle() {}
+  inline void enter(Scope_e scope) {}
+  inline void endCycle(uint32_t now) {}
+#endif  // ALLOC_TRACKING
+}  // namespace AllocTracker
+
+#endif  // ALLOCTRACKER_HPP
@@ -0,0 +1,104 @@
+#include "cyclearena.hpp"
+#include <stdarg.h>
+#include <new>
+
+namespace CycleArena {
+  //* Every block starts on this boundary
+  static const size_t ALIGNMENT = 8;
+
+  alignas(ALIGNMENT) static uint8_t buffer[CYCLE_ARENA_SIZE];
+  static size_t top = 0;
+  static size_t peak = 0;
+  static size_t cycleUsed = 0;
+  static size_t highWater = 0;
+  static uint32_t overflows = 0;
+  static uint32_t cycleOverflows = 0;
+  //* Task bound by begin(), the only one served from the buffer
+  static TaskHandle_t owner = nullptr;
+
+  static inline bool owns(const void* block) {
+    return block >= buffer && block < buffer + CYCLE_ARENA_SIZE;
+  }
+
+  void begin() {
+    owner = xTaskGetCurrentTaskHandle();
+  }
+
+  void* allocate(size_t size) {
+    size_t rounded = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (owner == nullptr || xTaskGetCurrentTaskHandle() != owner)
+      return ::operator new(size);
+    if (rounded > CYCLE_ARENA_SIZE - top) {
+      cycleOverflows++;
+      return ::operator new(size);
+    }
+    void* block = buffer + top;
+    top += rounded;
+    if (top > peak)
+      peak = top;
+    if (peak > highWater)
+      highWater = peak;
+    return block;
+  }
+
+  void deallocate(void* block, size_t size) {
+    if (!owns(block)) {
+      ::operator delete(block);
+      return;
+    }
+    //* Only the most recent block can be taken back before reset()
+    size_t rounded = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (static_cast<uint8_t*>(block) + rounded == buffer + top)
+      top -= rounded;
+  }
+
+  void reset() {
+    if (cycleOverflows != 0) {
+      log_w("[Cycle Arena]: %u requests went to the heap, high water %u of %u",
+            cycleOverflows, highWater, CYCLE_ARENA_SIZE);
+      overflows += cycleOverflows;
+      cycleOverflows = 0;
+    }
+    log_d("[Cycle Arena]: Cycle used %u bytes, high water %u", peak, highWater);
+    cycleUsed = peak;
+    peak = 0;
+    top = 0;
+  }
+
+  size_t getUsed() {
+    return top;
+  }
+
+  size_t getCycleUsed() {
+    return cycleUsed;
+  }
+
+  size_t getHighWater() {
+    return highWater;
+  }
+
+  uint32_t getOverflows() {
+    return overflows;
+  }
+
+  void appendf(String& out, const char* fmt, ...) {
+    char small[64];
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(small, sizeof(small), fmt, args);
+    va_end(args);
+    if (length < 0)
+      return;
+    if ((size_t)length < sizeof(small)) {
+      out.append(small, length);
+      return;
+    }
+
+    //* Longer results are printed straight into the string
+    size_t at = out.size();
+    out.resize(at + length);
+    va_start(args, fmt);
+    vsnprintf(&out[at], length + 1, fmt, args);
+    va_end(args);
+  }
+}  // namespace CycleArena
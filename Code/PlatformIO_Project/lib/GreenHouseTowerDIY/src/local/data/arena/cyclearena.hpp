@@ -0,0 +1,75 @@
+#ifndef CYCLEARENA_HPP
+#define CYCLEARENA_HPP
+#include <Arduino.h>
+#include <string>
+
+//* Bytes handed out per acquisition cycle before falling back to the heap
+#ifndef CYCLE_ARENA_SIZE
+#define CYCLE_ARENA_SIZE 4096
+#endif  // CYCLE_ARENA_SIZE
+
+/**
+ * @brief Bump allocator for the transient buffers of one acquisition cycle
+ * @note Blocks come from a static buffer and are only given back by reset(),
+ * which AccumulateData calls at the end of every cycle. Freeing the most
+ * recent block rolls the top back, which only helps short lived temporaries:
+ * a growing string allocates its new buffer before freeing the old one, so
+ * every buffer it outgrew stays used until reset(). Reserve up front.
+ * @note begin() binds the arena to the calling task. Requests that do not
+ * fit, made before begin() or from any other task are served by the heap and
+ * freed normally.
+ * @note Nothing allocated from the arena may outlive the cycle, containers
+ * holding arena memory have to be emptied before reset().
+ */
+namespace CycleArena {
+  void begin();
+  void* allocate(size_t size);
+  void deallocate(void* block, size_t size);
+  void reset();
+
+  //* Bytes in use now
+  size_t getUsed();
+  //* Most bytes in use at once during the last completed cycle
+  size_t getCycleUsed();
+  //* Most bytes any cycle used since boot, for sizing CYCLE_ARENA_SIZE
+  size_t getHighWater();
+  //* Requests of completed cycles that went to the heap, the arena was full
+  uint32_t getOverflows();
+
+  /**
+   * @brief std allocator adapter, all instances share the one arena
+   */
+  template <typename T>
+  struct Allocator {
+    typedef T value_type;
+
+    Allocator() {}
+    template <typename U>
+    Allocator(const Allocator<U>&) {}
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(CycleArena::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* block, size_t n) {
+      CycleArena::deallocate(block, n * sizeof(T));
+    }
+  };
+
+  template <typename T, typename U>
+  bool operator==(const Allocator<T>&, const Allocator<U>&) {
+    return true;
+  }
+  template <typename T, typename U>
+  bool operator!=(const Allocator<T>&, const Allocator<U>&) {
+    return false;
+  }
+
+  typedef std::basic_string<char, std::char_traits<char>, Allocator<char>>
+      String;
+
+  //* printf into the arena string, appended to what it holds
+  void appendf(String& out, const char* fmt, ...)
+      __attribute__((format(printf, 2, 3)));
+}  // namespace CycleArena
+
+#endif  // CYCLEARENA_HPP
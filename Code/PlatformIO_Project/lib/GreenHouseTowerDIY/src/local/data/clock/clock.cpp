@@ -0,0 +1,15 @@
+#include "clock.hpp"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+uint32_t SystemClock::millis() {
+  return ::millis();
+}
+
+uint64_t SystemClock::micros() {
+  return esp_timer_get_time();
+}
+
+void SystemClock::delay(uint32_t ms) {
+  ::delay(ms);
+}
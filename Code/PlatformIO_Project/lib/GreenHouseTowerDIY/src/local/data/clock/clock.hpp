@@ -0,0 +1,55 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Time source for everything that schedules work
+ * @note Modules take a Clock& instead of calling millis(), delay() or
+ * esp_timer_get_time() directly, so the same code runs on the hardware
+ * clock or on a VirtualClock driven by a host simulation.
+ * @note millis() wraps after ~49 days like the Arduino one, compare with
+ * now - start >= interval.
+ */
+class Clock {
+ public:
+  virtual ~Clock() {}
+
+  virtual uint32_t millis() = 0;
+  //* Monotonic, does not wrap
+  virtual uint64_t micros() = 0;
+  //* Blocks the caller for ms milliseconds of this clock
+  virtual void delay(uint32_t ms) = 0;
+};
+
+/**
+ * @brief Hardware clock, esp_timer since boot
+ */
+class SystemClock : public Clock {
+ public:
+  uint32_t millis() override;
+  uint64_t micros() override;
+  void delay(uint32_t ms) override;
+};
+
+/**
+ * @brief Clock that only moves when told to
+ * @note delay() advances the time instead of blocking, a sensor waiting
+ * between reads costs nothing, and a host loop calling advance() runs weeks
+ * of schedules in seconds. Readable from other tasks, e.g. the SNTP callback.
+ */
+class VirtualClock : public Clock {
+  std::atomic<uint64_t> _now;  // us
+
+ public:
+  explicit VirtualClock(uint64_t start = 0) : _now(start) {}
+
+  uint32_t millis() override { return _now / 1000; }
+  uint64_t micros() override { return _now; }
+  void delay(uint32_t ms) override { advance(ms); }
+
+  void advance(uint32_t ms) { _now += (uint64_t)ms * 1000; }
+  void set(uint64_t us) { _now = us; }
+};
+
+#endif  // CLOCK_HPP
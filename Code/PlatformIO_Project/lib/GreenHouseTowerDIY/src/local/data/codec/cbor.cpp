@@ -0,0 +1,135 @@
+#include "cbor.hpp"
+
+CborWriter::CborWriter(uint8_t* buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _length(0), _overflow(false) {}
+
+void CborWriter::put(const uint8_t* data, size_t length) {
+  if (_overflow || _length + length > _capacity) {
+    _overflow = true;
+    return;
+  }
+  memcpy(_buffer + _length, data, length);
+  _length += length;
+}
+
+//* Major type and argument in the shortest form
+void CborWriter::head(uint8_t major, uint32_t value) {
+  uint8_t bytes[5];
+  size_t length;
+  major <<= 5;
+  if (value < 24) {
+    bytes[0] = major | value;
+    length = 1;
+  } else if (value <= 0xFF) {
+    bytes[0] = major | 24;
+    bytes[1] = value;
+    length = 2;
+  } else if (value <= 0xFFFF) {
+    bytes[0] = major | 25;
+    bytes[1] = value >> 8;
+    bytes[2] = value;
+    length = 3;
+  } else {
+    bytes[0] = major | 26;
+    bytes[1] = value >> 24;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 8;
+    bytes[4] = value;
+    length = 5;
+  }
+  put(bytes, length);
+}
+
+void CborWriter::map(size_t pairs) {
+  head(5, pairs);
+}
+
+void CborWriter::array(size_t items) {
+  head(4, items);
+}
+
+void CborWriter::unsignedInt(uint32_t value) {
+  head(0, value);
+}
+
+void CborWriter::signedInt(int32_t value) {
+  if (value >= 0)
+    head(0, value);
+  else
+    head(1, static_cast<uint32_t>(-1 - value));
+}
+
+void CborWriter::float32(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint8_t bytes[5] = {
+      0xFA,
+      static_cast<uint8_t>(bits >> 24),
+      static_cast<uint8_t>(bits >> 16),
+      static_cast<uint8_t>(bits >> 8),
+      static_cast<uint8_t>(bits),
+  };
+  put(bytes, sizeof(bytes));
+}
+
+void CborWriter::text(const char* value, size_t length) {
+  head(3, length);
+  put(reinterpret_cast<const uint8_t*>(value), length);
+}
+
+void CborWriter::null() {
+  uint8_t byte = 0xF6;
+  put(&byte, 1);
+}
+
+namespace TelemetryCbor {
+  /**
+   * @brief Encode a cycle into buffer
+   * @return the encoded length, 0 when the buffer is too small
+   */
+  size_t encode(const Telemetry::Sample_t& sample,
+                const std::vector<float>& probes,
+                uint8_t* buffer,
+                size_t capacity) {
+    CborWriter writer(buffer, capacity);
+
+    size_t channels = 0;
+    for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+      if (!isnan(sample.values[c]))
+        channels++;
+    }
+
+    uint32_t millis = sample.timestamp_ms % 1000;
+    writer.map(4 + !probes.empty() + (millis != 0));
+    writer.unsignedInt(KEY_VERSION);
+    writer.unsignedInt(VERSION);
+    writer.unsignedInt(KEY_TIMESTAMP);
+    writer.unsignedInt(sample.timestamp);
+
+    writer.unsignedInt(KEY_CHANNELS);
+    writer.map(channels);
+    for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+      if (isnan(sample.values[c]))
+        continue;
+      writer.unsignedInt(c);
+      writer.float32(sample.values[c]);
+    }
+
+    if (!probes.empty()) {
+      writer.unsignedInt(KEY_PROBES);
+      writer.array(probes.size());
+      for (auto&& probe : probes) {
+        writer.float32(probe);
+      }
+    }
+
+    if (millis != 0) {
+      writer.unsignedInt(KEY_MILLIS);
+      writer.unsignedInt(millis);
+    }
+
+    writer.unsignedInt(KEY_UPTIME);
+    writer.unsignedInt(sample.uptime);
+    return writer.ok() ? writer.getLength() : 0;
+  }
+}  // namespace TelemetryCbor
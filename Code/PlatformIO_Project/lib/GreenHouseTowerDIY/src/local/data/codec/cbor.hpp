@@ -0,0 +1,81 @@
+#ifndef CBOR_HPP
+#define CBOR_HPP
+#include <Arduino.h>
+#include <vector>
+#include "local/data/telemetry/telemetry.hpp"
+
+//* Tower temperature probes an encoded cycle has room for
+#ifndef TELEMETRY_CBOR_MAX_PROBES
+#define TELEMETRY_CBOR_MAX_PROBES 32
+#endif  // TELEMETRY_CBOR_MAX_PROBES
+
+//* Worst case size of an encoded cycle, see TelemetryCbor::encode(). Every
+//* channel and the header take at most 84 bytes, a probe 5.
+#ifndef TELEMETRY_CBOR_SIZE
+#define TELEMETRY_CBOR_SIZE (96 + 5 * TELEMETRY_CBOR_MAX_PROBES)
+#endif  // TELEMETRY_CBOR_SIZE
+
+/**
+ * @brief Minimal CBOR (RFC 8949) writer over a caller owned buffer
+ * @note Only the definite length items the telemetry schema needs. Nothing is
+ * allocated, once the buffer is full every further write is dropped and ok()
+ * turns false.
+ */
+class CborWriter {
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _length;
+  bool _overflow;
+
+  void head(uint8_t major, uint32_t value);
+  void put(const uint8_t* data, size_t length);
+
+ public:
+  CborWriter(uint8_t* buffer, size_t capacity);
+
+  void map(size_t pairs);
+  void array(size_t items);
+  void unsignedInt(uint32_t value);
+  void signedInt(int32_t value);
+  void float32(float value);
+  void text(const char* value, size_t length);
+  void null();
+
+  size_t getLength() const { return _length; }
+  bool ok() const { return !_overflow; }
+};
+
+/**
+ * @brief Binary form of one acquisition cycle
+ * @note Stable schema - a map with integer keys, new keys may be added but
+ * existing ones never change meaning:
+ *
+ *   0: schema version (uint)
+ *   1: timestamp, epoch seconds (uint)
+ *   2: map of Telemetry channel id (uint) -> value (float32), missing
+ *      channels are omitted
+ *   3: array of tower temperature probes (float32)
+ *   4: milliseconds within the timestamp second (uint), omitted when 0
+ *   5: seconds since boot (uint), dates cycles taken before an NTP sync
+ *
+ * tools/decode_cbor.py decodes it on the host.
+ */
+namespace TelemetryCbor {
+  const uint8_t VERSION = 1;
+
+  enum Key_e : uint8_t {
+    KEY_VERSION,
+    KEY_TIMESTAMP,
+    KEY_CHANNELS,
+    KEY_PROBES,
+    KEY_MILLIS,
+    KEY_UPTIME,
+  };
+
+  size_t encode(const Telemetry::Sample_t& sample,
+                const std::vector<float>& probes,
+                uint8_t* buffer,
+                size_t capacity);
+}  // namespace TelemetryCbor
+
+#endif
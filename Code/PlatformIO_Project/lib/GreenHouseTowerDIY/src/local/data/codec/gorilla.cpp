@@ -0,0 +1,250 @@
+#include "gorilla.hpp"
+#include <algorithm>
+
+//**********************************************************************************************************************
+//*
+//!                                                Bit Streams
+//*
+//**********************************************************************************************************************
+
+BitWriter::BitWriter(uint8_t* buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _bits(0) {}
+
+bool BitWriter::write(uint32_t value, uint8_t bits) {
+  if (_bits + bits > _capacity * 8)
+    return false;
+  while (bits > 0) {
+    size_t byte = _bits / 8;
+    uint8_t space = 8 - (_bits % 8);
+    uint8_t take = std::min(space, bits);
+    uint8_t chunk = (value >> (bits - take)) & ((1U << take) - 1);
+    if (space == 8)
+      _buffer[byte] = 0;
+    _buffer[byte] |= chunk << (space - take);
+    _bits += take;
+    bits -= take;
+  }
+  return true;
+}
+
+BitReader::BitReader(const uint8_t* data, size_t length)
+    : _data(data), _length(length), _bits(0) {}
+
+bool BitReader::read(uint32_t& value, uint8_t bits) {
+  if (_bits + bits > _length * 8)
+    return false;
+  value = 0;
+  while (bits > 0) {
+    size_t byte = _bits / 8;
+    uint8_t space = 8 - (_bits % 8);
+    uint8_t take = std::min(space, bits);
+    uint8_t chunk = (_data[byte] >> (space - take)) & ((1U << take) - 1);
+    value = (value << take) | chunk;
+    _bits += take;
+    bits -= take;
+  }
+  return true;
+}
+
+//* Sign extend the low bits of value
+static int32_t signExtend(uint32_t value, uint8_t bits) {
+  if (bits >= 32)
+    return static_cast<int32_t>(value);
+  return static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+}
+
+static uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//**********************************************************************************************************************
+//*
+//!                                                Encoder
+//*
+//**********************************************************************************************************************
+
+GorillaEncoder::GorillaEncoder(uint8_t* buffer, size_t capacity)
+    : _writer(buffer, capacity),
+      _count(0),
+      _timestamp(0),
+      _delta(0),
+      _value(0),
+      _leading(0xFF),
+      _trailing(0),
+      _overflow(false) {
+  //* Room for the point count, patched in finish()
+  _overflow = !_writer.write(0, 16);
+}
+
+/**
+ * @brief Add one point, timestamps must not decrease
+ * @return false once the buffer is full, the stream stays decodable
+ */
+bool GorillaEncoder::append(uint32_t timestamp, float value) {
+  if (_overflow || _count == UINT16_MAX)
+    return false;
+
+  uint32_t bits = floatBits(value);
+  if (_count == 0) {
+    if (!_writer.write(timestamp, 32) || !_writer.write(bits, 32)) {
+      _overflow = true;
+      return false;
+    }
+  } else {
+    //* Roll back a partially written point on overflow
+    BitWriter checkpoint = _writer;
+    int32_t delta = _delta;
+    uint8_t leading = _leading;
+    uint8_t trailing = _trailing;
+    if (!writeTimestamp(timestamp) || !writeValue(bits)) {
+      _writer = checkpoint;
+      _delta = delta;
+      _leading = leading;
+      _trailing = trailing;
+      _overflow = true;
+      return false;
+    }
+  }
+  _timestamp = timestamp;
+  _value = bits;
+  _count++;
+  return true;
+}
+
+bool GorillaEncoder::writeTimestamp(uint32_t timestamp) {
+  int32_t delta = static_cast<int32_t>(timestamp - _timestamp);
+  int32_t dod = delta - _delta;
+  _delta = delta;
+
+  if (dod == 0)
+    return _writer.write(0b0, 1);
+  if (dod >= -64 && dod <= 63)
+    return _writer.write(0b10, 2) && _writer.write(dod & 0x7F, 7);
+  if (dod >= -256 && dod <= 255)
+    return _writer.write(0b110, 3) && _writer.write(dod & 0x1FF, 9);
+  if (dod >= -2048 && dod <= 2047)
+    return _writer.write(0b1110, 4) && _writer.write(dod & 0xFFF, 12);
+  return _writer.write(0b1111, 4) && _writer.write(dod, 32);
+}
+
+bool GorillaEncoder::writeValue(uint32_t value) {
+  uint32_t xored = value ^ _value;
+  if (xored == 0)
+    return _writer.write(0b0, 1);
+
+  uint8_t leading = std::min(__builtin_clz(xored), 31);
+  uint8_t trailing = __builtin_ctz(xored);
+
+  //* Reuse the previous window when the meaningful bits fit in it
+  if (_leading != 0xFF && leading >= _leading && trailing >= _trailing) {
+    uint8_t length = 32 - _leading - _trailing;
+    return _writer.write(0b10, 2) &&
+           _writer.write(xored >> _trailing, length);
+  }
+
+  uint8_t length = 32 - leading - trailing;
+  _leading = leading;
+  _trailing = trailing;
+  return _writer.write(0b11, 2) && _writer.write(leading, 5) &&
+         _writer.write(length - 1, 5) && _writer.write(xored >> trailing, length);
+}
+
+/**
+ * @brief Close the stream
+ * @return the number of bytes used in the buffer
+ */
+size_t GorillaEncoder::finish() {
+  if (_writer.getBits() < 16)
+    return 0;
+  uint8_t* buffer = _writer.getBuffer();
+  buffer[0] = _count >> 8;
+  buffer[1] = _count & 0xFF;
+  return _writer.getBytes();
+}
+
+//**********************************************************************************************************************
+//*
+//!                                                Decoder
+//*
+//**********************************************************************************************************************
+
+GorillaDecoder::GorillaDecoder(const uint8_t* data, size_t length)
+    : _reader(data, length),
+      _count(0),
+      _index(0),
+      _timestamp(0),
+      _delta(0),
+      _value(0),
+      _leading(0),
+      _trailing(0) {
+  uint32_t count = 0;
+  if (_reader.read(count, 16))
+    _count = count;
+}
+
+bool GorillaDecoder::next(uint32_t& timestamp, float& value) {
+  if (_index >= _count)
+    return false;
+
+  uint32_t bits = 0;
+  if (_index == 0) {
+    if (!_reader.read(_timestamp, 32) || !_reader.read(_value, 32))
+      return false;
+  } else {
+    //* Delta-of-delta prefix, up to four ones
+    uint8_t prefix = 0;
+    while (prefix < 4) {
+      if (!_reader.read(bits, 1))
+        return false;
+      if (bits == 0)
+        break;
+      prefix++;
+    }
+    static const uint8_t widths[5] = {0, 7, 9, 12, 32};
+    int32_t dod = 0;
+    if (prefix > 0) {
+      if (!_reader.read(bits, widths[prefix]))
+        return false;
+      dod = signExtend(bits, widths[prefix]);
+    }
+    _delta += dod;
+    _timestamp += _delta;
+
+    //* Value xor
+    if (!_reader.read(bits, 1))
+      return false;
+    if (bits == 1) {
+      if (!_reader.read(bits, 1))
+        return false;
+      if (bits == 1) {
+        uint32_t leading, length;
+        if (!_reader.read(leading, 5) || !_reader.read(length, 5))
+          return false;
+        //* A corrupt window would shift past the value, stop decoding
+        if (leading + length + 1 > 32) {
+          _index = _count;
+          return false;
+        }
+        _leading = leading;
+        _trailing = 32 - leading - (length + 1);
+      }
+      uint8_t length = 32 - _leading - _trailing;
+      if (!_reader.read(bits, length))
+        return false;
+      _value ^= bits << _trailing;
+    }
+  }
+
+  _index++;
+  timestamp = _timestamp;
+  value = bitsFloat(_value);
+  return true;
+}
@@ -0,0 +1,82 @@
+#ifndef GORILLA_HPP
+#define GORILLA_HPP
+#include <Arduino.h>
+
+/**
+ * @brief Gorilla time-series codec
+ * @note Timestamps are stored as delta-of-delta and values as the XOR with
+ * the previous value, following Pelkonen et al. "Gorilla: A Fast, Scalable,
+ * In-Memory Time Series Database" adapted to 32 bit timestamps and floats.
+ * A steady 60 s cadence costs one bit per timestamp and an unchanged reading
+ * one bit per value.
+ *
+ * Stream layout (bits, most significant first):
+ *   count u16 | t0 u32 | v0 f32 |
+ *   then per point:
+ *     delta-of-delta: '0' | '10' s7 | '110' s9 | '1110' s12 | '1111' s32
+ *     value xor:      '0' | '10' meaningful bits in the previous window |
+ *                     '11' leading u5 | length-1 u5 | meaningful bits
+ */
+class BitWriter {
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _bits;
+
+ public:
+  BitWriter(uint8_t* buffer, size_t capacity);
+  bool write(uint32_t value, uint8_t bits);
+  size_t getBits() const { return _bits; }
+  size_t getBytes() const { return (_bits + 7) / 8; }
+  uint8_t* getBuffer() { return _buffer; }
+};
+
+class BitReader {
+  const uint8_t* _data;
+  size_t _length;
+  size_t _bits;
+
+ public:
+  BitReader(const uint8_t* data, size_t length);
+  bool read(uint32_t& value, uint8_t bits);
+};
+
+class GorillaEncoder {
+  BitWriter _writer;
+  uint16_t _count;
+  uint32_t _timestamp;
+  int32_t _delta;
+  uint32_t _value;
+  uint8_t _leading;
+  uint8_t _trailing;
+  bool _overflow;
+
+  bool writeTimestamp(uint32_t timestamp);
+  bool writeValue(uint32_t value);
+
+ public:
+  GorillaEncoder(uint8_t* buffer, size_t capacity);
+  bool append(uint32_t timestamp, float value);
+  size_t finish();
+  uint16_t getCount() const { return _count; }
+
+  //* Worst case size of a stream of count points
+  static size_t maxSize(size_t count) { return 10 + count * 10; }
+};
+
+class GorillaDecoder {
+  BitReader _reader;
+  uint16_t _count;
+  uint16_t _index;
+  uint32_t _timestamp;
+  int32_t _delta;
+  uint32_t _value;
+  uint8_t _leading;
+  uint8_t _trailing;
+
+ public:
+  GorillaDecoder(const uint8_t* data, size_t length);
+  bool next(uint32_t& timestamp, float& value);
+  uint16_t getCount() const { return _count; }
+};
+
+#endif
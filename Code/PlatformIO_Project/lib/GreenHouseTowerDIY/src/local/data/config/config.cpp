@@ -1,7 +1,9 @@
 #include "config.hpp"
+#include <algorithm>
+#include "local/network/mqtt/topics/topicfilter.hpp"
 
 GreenHouseConfig::GreenHouseConfig(ProjectConfig& projectConfig)
-    : projectConfig(projectConfig) {
+    : projectConfig(projectConfig), revision(0) {
   initConfig();
 }
 
@@ -13,6 +15,7 @@ void GreenHouseConfig::initConfig() {
       .reconnect_mqtt = true,
       .reconnect_tries = 10,
       .reconnect_time_ms = 10000,
+      .backoff_max_ms = 60000,
       .broker = "",
       .port = 1883,
       .auth = MqttSecure_t::INSECURE_MQTT,
@@ -27,7 +30,73 @@ void GreenHouseConfig::initConfig() {
       .pub_topics = {},
       .sub_topics = {},
       .mqtt_task_stack_size = 7168,
+      .history_export = false,
+      .publish_mode = MqttPublish_t::PER_SENSOR,
+      .device_topic = "",
+      .default_qos = 0,
+      .default_retain = false,
+      .topic_policies =
+          {
+              {"+/+/status", 1, true},
+              {"+/+/state/#", 1, true},
+              {"+/+/history/#", 1, false},
+          },
+      .outbox_policy = OutboxPolicy_t::OUTBOX_DROP_OLDEST,
+      .outbox_spill = false,
+      .outbox_drain_ms = 250,
+      .tower_id = "0",
+      .report_by_exception = false,
+      .heartbeat_s = 900,
+      .deadbands = "",
+      .encoding = Encoding_t::ENCODING_JSON,
+      .hass_discovery = false,
+      .brokers = "",
+      .broker_spread = false,
+      .discovered_broker = "",
   };
+  this->revision++;
+}
+
+//* filter:qos:retain entries separated by ';', e.g. "+/+/status:1:1;a/#:0:0"
+//* An empty string is a valid, empty list
+static std::string encodePolicies(
+    const std::vector<Project_Config::MQTTTopicPolicy_t>& policies) {
+  std::string encoded;
+  for (auto& policy : policies) {
+    if (!encoded.empty())
+      encoded += ";";
+    encoded += Helpers::format_string("%s:%u:%u", policy.filter.c_str(),
+                                      policy.qos, policy.retain ? 1 : 0);
+  }
+  return encoded;
+}
+
+//* Read back when topic_pols is missing from NVS, never produced by encode
+static const char* const UNSAVED_POLICIES = "-";
+
+static void decodePolicies(
+    const std::string& encoded,
+    std::vector<Project_Config::MQTTTopicPolicy_t>& policies) {
+  policies.clear();
+  size_t start = 0;
+  while (start < encoded.length()) {
+    size_t end = encoded.find(';', start);
+    if (end == std::string::npos)
+      end = encoded.length();
+    std::string entry = encoded.substr(start, end - start);
+    start = end + 1;
+
+    size_t retain = entry.rfind(':');
+    size_t qos = retain == std::string::npos || retain == 0
+                     ? std::string::npos
+                     : entry.rfind(':', retain - 1);
+    if (qos == std::string::npos || qos == 0)
+      continue;
+    policies.push_back(
+        {entry.substr(0, qos),
+         static_cast<uint8_t>(std::min(atoi(entry.c_str() + qos + 1), 2)),
+         atoi(entry.c_str() + retain + 1) != 0});
+  }
 }
 
 //**********************************************************************************************************************
@@ -39,6 +108,7 @@ void GreenHouseConfig::initConfig() {
 void GreenHouseConfig::load() {
   loadMQTT();
   loadFeatures();
+  this->revision++;
 }
 
 void GreenHouseConfig::loadMQTT() {
@@ -53,6 +123,7 @@ void GreenHouseConfig::loadMQTT() {
   this->mqtt.reconnect_mqtt = projectConfig.getBool("rc_mqtt", true);
   this->mqtt.reconnect_tries = projectConfig.getInt("rc_tries", 10);
   this->mqtt.reconnect_time_ms = projectConfig.getInt("rc_time_ms", 10000);
+  this->mqtt.backoff_max_ms = projectConfig.getInt("backoff_max", 60000);
   this->mqtt.auth = (MqttSecure_t)projectConfig.getBool("mqtt_auth", false);
   this->mqtt.enable_certs = projectConfig.getBool("enable_certs", false);
   this->mqtt.ca_file.assign(
@@ -65,6 +136,37 @@ void GreenHouseConfig::loadMQTT() {
   this->mqtt.websocket_path.assign(
       projectConfig.getString("ws_path", "/").c_str());
   this->mqtt.mqtt_task_stack_size = projectConfig.getInt("mqtt_size", 7168);
+  this->mqtt.history_export = projectConfig.getBool("hist_export", false);
+  this->mqtt.publish_mode = (MqttPublish_t)projectConfig.getInt(
+      "pub_mode", MqttPublish_t::PER_SENSOR);
+  this->mqtt.device_topic.assign(
+      projectConfig.getString("dev_topic", "").c_str());
+  this->mqtt.default_qos = projectConfig.getInt("def_qos", 0);
+  this->mqtt.default_retain = projectConfig.getBool("def_retain", false);
+  //* Keep the defaults only when no list was ever saved
+  std::string policies(
+      projectConfig.getString("topic_pols", UNSAVED_POLICIES).c_str());
+  if (policies != UNSAVED_POLICIES) {
+    std::vector<Project_Config::MQTTTopicPolicy_t> decoded;
+    decodePolicies(policies, decoded);
+    std::lock_guard<std::mutex> lock(policyMutex);
+    this->mqtt.topic_policies.swap(decoded);
+  }
+  this->mqtt.outbox_policy = (OutboxPolicy_t)projectConfig.getInt(
+      "ob_policy", OutboxPolicy_t::OUTBOX_DROP_OLDEST);
+  this->mqtt.outbox_spill = projectConfig.getBool("ob_spill", false);
+  this->mqtt.outbox_drain_ms = projectConfig.getInt("ob_drain_ms", 250);
+  this->mqtt.tower_id.assign(projectConfig.getString("tower_id", "0").c_str());
+  this->mqtt.report_by_exception = projectConfig.getBool("rbe", false);
+  this->mqtt.heartbeat_s = projectConfig.getInt("heartbeat_s", 900);
+  this->mqtt.deadbands.assign(projectConfig.getString("deadbands", "").c_str());
+  this->mqtt.encoding =
+      (Encoding_t)projectConfig.getInt("encoding", Encoding_t::ENCODING_JSON);
+  this->mqtt.hass_discovery = projectConfig.getBool("hass_disc", false);
+  this->mqtt.brokers.assign(projectConfig.getString("brokers", "").c_str());
+  this->mqtt.broker_spread = projectConfig.getBool("brk_spread", false);
+  this->mqtt.discovered_broker.assign(
+      projectConfig.getString("mdns_broker", "").c_str());
 
   // TODO: sub_topics - use for loops
 }
@@ -101,6 +203,7 @@ void GreenHouseConfig::saveMQTT() {
   projectConfig.putBool("rc_mqtt", this->mqtt.reconnect_mqtt);
   projectConfig.putInt("rc_tries", this->mqtt.reconnect_tries);
   projectConfig.putInt("rc_time_ms", this->mqtt.reconnect_time_ms);
+  projectConfig.putInt("backoff_max", this->mqtt.backoff_max_ms);
   projectConfig.putInt("mqtt_auth", this->mqtt.auth);
   projectConfig.putBool("enable_certs", this->mqtt.enable_certs);
   projectConfig.putString("ca_file", this->mqtt.ca_file.c_str());
@@ -109,6 +212,23 @@ void GreenHouseConfig::saveMQTT() {
   projectConfig.putBool("en_ws", this->mqtt.enabled_websocket);
   projectConfig.putString("ws_path", this->mqtt.websocket_path.c_str());
   projectConfig.putInt("mqtt_size", this->mqtt.mqtt_task_stack_size);
+  projectConfig.putBool("hist_export", this->mqtt.history_export);
+  projectConfig.putInt("pub_mode", this->mqtt.publish_mode);
+  projectConfig.putString("dev_topic", this->mqtt.device_topic.c_str());
+  projectConfig.putInt("def_qos", this->mqtt.default_qos);
+  projectConfig.putBool("def_retain", this->mqtt.default_retain);
+  projectConfig.putString("topic_pols", encodeTopicPolicies().c_str());
+  projectConfig.putInt("ob_policy", this->mqtt.outbox_policy);
+  projectConfig.putBool("ob_spill", this->mqtt.outbox_spill);
+  projectConfig.putInt("ob_drain_ms", this->mqtt.outbox_drain_ms);
+  projectConfig.putString("tower_id", this->mqtt.tower_id.c_str());
+  projectConfig.putBool("rbe", this->mqtt.report_by_exception);
+  projectConfig.putInt("heartbeat_s", this->mqtt.heartbeat_s);
+  projectConfig.putString("deadbands", this->mqtt.deadbands.c_str());
+  projectConfig.putInt("encoding", this->mqtt.encoding);
+  projectConfig.putBool("hass_disc", this->mqtt.hass_discovery);
+  projectConfig.putString("brokers", this->mqtt.brokers.c_str());
+  projectConfig.putBool("brk_spread", this->mqtt.broker_spread);
   // TODO: pub_topics and sub_topics - use for loops
 }
 
@@ -207,18 +327,38 @@ std::string GreenHouseConfig::toRepresentation() {
   std::string mqtt_json = Helpers::format_string(
       "\"mqtt\": {\"broker\": \"%s\", \"port\": %d, \"username\": \"%s\", "
       "\"password\": \"%s\", \"enabled\": %s, \"reconnect_mqtt\": %s, "
-      "\"reconnect_tries\": %d, \"reconnect_time_ms\": %d, \"auth\": %s, "
+      "\"reconnect_tries\": %d, \"reconnect_time_ms\": %d, "
+      "\"backoff_max_ms\": %d, \"auth\": %s, "
       "\"enable_certs\": %s, \"ca_file\": \"%s\", \"cert_file\": \"%s\", "
       "\"key_file\": \"%s\", \"enabled_websocket\": %s, \"websocket_path\": "
-      "\"%s\", \"mqtt_task_stack_size\": %d}",
+      "\"%s\", \"mqtt_task_stack_size\": %d, \"history_export\": %s, "
+      "\"publish_mode\": %d, \"device_topic\": \"%s\", "
+      "\"default_qos\": %d, \"default_retain\": %s, "
+      "\"topic_policies\": \"%s\", \"outbox_policy\": %d, "
+      "\"outbox_spill\": %s, \"outbox_drain_ms\": %d, \"tower_id\": "
+      "\"%s\", \"report_by_exception\": %s, \"heartbeat_s\": %d, "
+      "\"deadbands\": \"%s\", \"encoding\": \"%s\", \"hass_discovery\": "
+      "%s, \"brokers\": \"%s\", \"broker_spread\": %s}",
       this->mqtt.broker.c_str(), this->mqtt.port, this->mqtt.username.c_str(),
       this->mqtt.password.c_str(), this->mqtt.enabled ? "true" : "false",
       this->mqtt.reconnect_mqtt ? "true" : "false", this->mqtt.reconnect_tries,
-      this->mqtt.reconnect_time_ms, this->mqtt.auth ? "true" : "false",
+      this->mqtt.reconnect_time_ms, this->mqtt.backoff_max_ms,
+      this->mqtt.auth ? "true" : "false",
       this->mqtt.enable_certs ? "true" : "false", this->mqtt.ca_file.c_str(),
       this->mqtt.cert_file.c_str(), this->mqtt.key_file.c_str(),
       this->mqtt.enabled_websocket ? "true" : "false",
-      this->mqtt.websocket_path.c_str(), this->mqtt.mqtt_task_stack_size);
+      this->mqtt.websocket_path.c_str(), this->mqtt.mqtt_task_stack_size,
+      this->mqtt.history_export ? "true" : "false", this->mqtt.publish_mode,
+      this->mqtt.device_topic.c_str(), this->mqtt.default_qos,
+      this->mqtt.default_retain ? "true" : "false",
+      encodeTopicPolicies().c_str(), this->mqtt.outbox_policy,
+      this->mqtt.outbox_spill ? "true" : "false",
+      this->mqtt.outbox_drain_ms, this->mqtt.tower_id.c_str(),
+      this->mqtt.report_by_exception ? "true" : "false", this->mqtt.heartbeat_s,
+      this->mqtt.deadbands.c_str(),
+      this->mqtt.encoding == Encoding_t::ENCODING_CBOR ? "cbor" : "json",
+      this->mqtt.hass_discovery ? "true" : "false",
+      this->mqtt.brokers.c_str(), this->mqtt.broker_spread ? "true" : "false");
 
   //* Return formatted json string
   return Helpers::format_string("{%s, %s, %s}", mqtt_json.c_str(),
@@ -233,11 +373,55 @@ void GreenHouseConfig::setMQTTConfig(const std::string& broker,
   this->mqtt.password.assign(password);
   this->mqtt.port = port;
   this->mqtt.broker.assign(broker);
+  this->revision++;
 }
 
 void GreenHouseConfig::setMQTTBroker(const std::string& broker, uint16_t port) {
   this->mqtt.port = port;
   this->mqtt.broker.assign(broker);
+  this->revision++;
+}
+
+/**
+ * @brief Turn the history export on or off
+ * @note Persisted right away, for commands that arrive over MQTT
+ */
+void GreenHouseConfig::setHistoryExport(bool enabled) {
+  this->mqtt.history_export = enabled;
+  projectConfig.putBool("hist_export", enabled);
+  this->revision++;
+}
+
+/**
+ * @brief Turn Home Assistant discovery on or off
+ * @note Persisted right away, for commands that arrive over MQTT
+ */
+void GreenHouseConfig::setHassDiscovery(bool enabled) {
+  this->mqtt.hass_discovery = enabled;
+  projectConfig.putBool("hass_disc", enabled);
+  this->revision++;
+}
+
+/**
+ * @brief Select how acquisition cycles are published
+ * @note Persisted right away, for commands that arrive over MQTT
+ */
+void GreenHouseConfig::setPublishMode(MqttPublish_t mode) {
+  this->mqtt.publish_mode = mode;
+  projectConfig.putInt("pub_mode", mode);
+  this->revision++;
+}
+
+/**
+ * @brief Remember the broker reached through mDNS, as host:port
+ * @note A cache rather than configuration, the revision is not bumped and
+ * NVS is only written when the broker changed
+ */
+void GreenHouseConfig::setDiscoveredBroker(const std::string& broker) {
+  if (broker == this->mqtt.discovered_broker)
+    return;
+  this->mqtt.discovered_broker.assign(broker);
+  projectConfig.putString("mdns_broker", broker.c_str());
 }
 
 //**********************************************************************************************************************
@@ -260,6 +444,27 @@ IPAddress GreenHouseConfig::getBroker() {
   return broker_ip.fromString(mqttConfig.broker.c_str());
 }
 
+/**
+ * @brief QoS and retain flag to publish a topic with
+ * @note Falls back to default_qos and default_retain when no filter matches
+ * @note Runs for every publish, possibly while the config task reloads the
+ * policies, so the match is made under the lock and returned by value
+ */
+Project_Config::MQTTDelivery_t GreenHouseConfig::getTopicPolicy(
+    std::string_view topic) {
+  std::lock_guard<std::mutex> lock(policyMutex);
+  for (auto& policy : this->mqtt.topic_policies) {
+    if (Topics::matches(policy.filter, topic))
+      return {policy.qos, policy.retain};
+  }
+  return {this->mqtt.default_qos, this->mqtt.default_retain};
+}
+
+std::string GreenHouseConfig::encodeTopicPolicies() {
+  std::lock_guard<std::mutex> lock(policyMutex);
+  return encodePolicies(this->mqtt.topic_policies);
+}
+
 Project_Config::EnabledFeatures_t& GreenHouseConfig::getEnabledFeatures() {
   return this->enabled_features;
 }
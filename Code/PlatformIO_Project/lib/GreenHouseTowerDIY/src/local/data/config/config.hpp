@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include <timeObj.h>
 #include <data/config/project_config.hpp>
+#include <atomic>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
 
 namespace Project_Config {
@@ -40,6 +43,13 @@ namespace Project_Config {
     };
 
     enum Mqtt_Secure_e : uint8_t { SECURE_MQTT, INSECURE_MQTT };
+    enum Mqtt_Publish_e : uint8_t {
+      PER_SENSOR,
+      BATCHED,
+      BATCHED_AND_PER_SENSOR
+    };
+    enum Outbox_Policy_e : uint8_t { OUTBOX_DROP_OLDEST, OUTBOX_DOWNSAMPLE };
+    enum Encoding_e : uint8_t { ENCODING_JSON, ENCODING_CBOR };
 
     Humidity_Features_e humidity_features;
     DHT_Features_e dht_features;
@@ -49,11 +59,28 @@ namespace Project_Config {
     uint8_t dht_pin;
   };
 
+  /**
+   * @brief Delivery policy for the topics matching an MQTT topic filter
+   * @note Filters support the + and # wildcards, the first match wins
+   */
+  struct MQTTTopicPolicy_t {
+    std::string filter;
+    uint8_t qos;
+    bool retain;
+  };
+
+  //* What a topic policy resolves to for one publish
+  struct MQTTDelivery_t {
+    uint8_t qos;
+    bool retain;
+  };
+
   struct MQTTConfig_t {
     bool enabled;
     bool reconnect_mqtt;
     int reconnect_tries;
-    int reconnect_time_ms;
+    int reconnect_time_ms;  // time allowed for one connect attempt
+    int backoff_max_ms;     // ceiling of the delay between attempts
     std::string broker;
     uint16_t port;
     Project_Config::EnabledFeatures_t::Mqtt_Secure_e auth;
@@ -68,6 +95,26 @@ namespace Project_Config {
     std::vector<std::string> pub_topics;
     std::vector<std::string> sub_topics;
     int mqtt_task_stack_size;
+    bool history_export;
+    Project_Config::EnabledFeatures_t::Mqtt_Publish_e publish_mode;
+    std::string device_topic;
+    uint8_t default_qos;
+    bool default_retain;
+    std::vector<MQTTTopicPolicy_t> topic_policies;
+    Project_Config::EnabledFeatures_t::Outbox_Policy_e outbox_policy;
+    bool outbox_spill;
+    int outbox_drain_ms;
+    std::string tower_id;
+    bool report_by_exception;
+    int heartbeat_s;
+    std::string deadbands;
+    Project_Config::EnabledFeatures_t::Encoding_e encoding;
+    bool hass_discovery;
+    std::string brokers;
+    bool broker_spread;
+    //* Last broker reached through mDNS, host:port. A cache kept apart from
+    //* the configured brokers, only written by setDiscoveredBroker()
+    std::string discovered_broker;
   };
 
   class GreenHouseConfig_t : ProjectConfig_t {
@@ -80,6 +127,14 @@ namespace Project_Config {
 class GreenHouseConfig : public CustomConfigInterface,
                          private Project_Config::GreenHouseConfig_t {
   ProjectConfig& projectConfig;
+  //* Bumped on every load or setter call, lets consumers cache derived state
+  //* Setters may run on the MQTT task, the revision is read on the loop task
+  std::atomic<uint32_t> revision;
+  //* Guards mqtt.topic_policies, loaded on the config task and matched on
+  //* every publish
+  std::mutex policyMutex;
+
+  std::string encodeTopicPolicies();
 
  public:
   GreenHouseConfig(ProjectConfig& projectConfig);
@@ -106,11 +161,18 @@ class GreenHouseConfig : public CustomConfigInterface,
                      uint16_t port = 1883);
 
   void setMQTTBroker(const std::string& broker, uint16_t port = 1883);
+  void setHistoryExport(bool enabled);
+  void setHassDiscovery(bool enabled);
+  void setPublishMode(
+      Project_Config::EnabledFeatures_t::Mqtt_Publish_e mode);
+  void setDiscoveredBroker(const std::string& broker);
 
   Project_Config::MQTTConfig_t& getMQTTConfig();
+  uint32_t getRevision() const { return revision; }
   Project_Config::EnabledFeatures_t& getEnabledFeatures();
 
   IPAddress getBroker();
+  Project_Config::MQTTDelivery_t getTopicPolicy(std::string_view topic);
 
   /* Types */
   typedef Project_Config::EnabledFeatures_t::Humidity_Features_e
@@ -121,6 +183,9 @@ class GreenHouseConfig : public CustomConfigInterface,
   typedef Project_Config::EnabledFeatures_t::Water_Level_Features_e
       WaterLevelFeatures_t;
   typedef Project_Config::EnabledFeatures_t::Mqtt_Secure_e MqttSecure_t;
+  typedef Project_Config::EnabledFeatures_t::Mqtt_Publish_e MqttPublish_t;
+  typedef Project_Config::EnabledFeatures_t::Outbox_Policy_e OutboxPolicy_t;
+  typedef Project_Config::EnabledFeatures_t::Encoding_e Encoding_t;
 };
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef FIXEDSTRING_HPP
+#define FIXEDSTRING_HPP
+#include <Arduino.h>
+#include <string.h>
+#include <algorithm>
+#include <string_view>
+
+/**
+ * @brief String of at most N characters, stored inline
+ * @note Never allocates and needs no static initialisation guard, a copy is
+ * one memcpy. The text is always null terminated, so c_str() goes straight
+ * to the C APIs of the MQTT client and printf.
+ * @note Text that does not fit is truncated, assign() and append() return
+ * false when that happened.
+ */
+template <size_t N>
+class FixedString {
+  char _data[N + 1];
+  size_t _length;
+
+ public:
+  FixedString() : _length(0) { _data[0] = '\0'; }
+  explicit FixedString(std::string_view text) : _length(0) {
+    _data[0] = '\0';
+    append(text);
+  }
+
+  bool assign(std::string_view text) {
+    clear();
+    return append(text);
+  }
+
+  bool append(std::string_view text) {
+    size_t count = std::min(text.size(), N - _length);
+    if (count != 0)
+      memcpy(_data + _length, text.data(), count);
+    _length += count;
+    _data[_length] = '\0';
+    return count == text.size();
+  }
+
+  void clear() {
+    _length = 0;
+    _data[0] = '\0';
+  }
+
+  const char* c_str() const { return _data; }
+  const char* data() const { return _data; }
+  size_t size() const { return _length; }
+  size_t length() const { return _length; }
+  bool empty() const { return _length == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  std::string_view view() const { return std::string_view(_data, _length); }
+  operator std::string_view() const { return view(); }
+
+  bool operator==(std::string_view other) const { return view() == other; }
+  bool operator!=(std::string_view other) const { return view() != other; }
+};
+
+#endif  // FIXEDSTRING_HPP
@@ -0,0 +1,123 @@
+#include "downsample.hpp"
+
+namespace Downsample {
+  //* Input already small enough, pass the means through
+  static size_t copy(const History::Point_t* in, size_t count, Point_t* out) {
+    for (size_t i = 0; i < count; i++) {
+      out[i] = {in[i].timestamp, in[i].mean};
+    }
+    return count;
+  }
+
+  size_t lttb(const History::Point_t* in,
+              size_t count,
+              Point_t* out,
+              size_t threshold) {
+    if (threshold >= count)
+      return copy(in, count, out);
+    if (threshold < 3)
+      return 0;
+
+    //* Times relative to the first point keep float precision
+    uint32_t origin = in[0].timestamp;
+    float every = static_cast<float>(count - 2) / (threshold - 2);
+    size_t written = 0;
+    size_t a = 0;
+    out[written++] = {in[0].timestamp, in[0].mean};
+
+    for (size_t i = 0; i < threshold - 2; i++) {
+      //* Average of the next bucket, the last point for the final bucket
+      size_t nextStart = static_cast<size_t>((i + 1) * every) + 1;
+      size_t nextEnd = std::min(static_cast<size_t>((i + 2) * every) + 1, count);
+      float avgX = 0;
+      float avgY = 0;
+      for (size_t j = nextStart; j < nextEnd; j++) {
+        avgX += in[j].timestamp - origin;
+        avgY += in[j].mean;
+      }
+      size_t span = nextEnd - nextStart;
+      if (span == 0) {
+        avgX = in[count - 1].timestamp - origin;
+        avgY = in[count - 1].mean;
+      } else {
+        avgX /= span;
+        avgY /= span;
+      }
+
+      size_t start = static_cast<size_t>(i * every) + 1;
+      size_t end = static_cast<size_t>((i + 1) * every) + 1;
+      float ax = in[a].timestamp - origin;
+      float ay = in[a].mean;
+      float best = -1;
+      size_t pick = start;
+      for (size_t j = start; j < end; j++) {
+        float area = fabsf((ax - avgX) * (in[j].mean - ay) -
+                           (ax - (in[j].timestamp - origin)) * (avgY - ay));
+        if (area > best) {
+          best = area;
+          pick = j;
+        }
+      }
+      out[written++] = {in[pick].timestamp, in[pick].mean};
+      a = pick;
+    }
+
+    out[written++] = {in[count - 1].timestamp, in[count - 1].mean};
+    return written;
+  }
+
+  size_t minMax(const History::Point_t* in,
+                size_t count,
+                Point_t* out,
+                size_t threshold) {
+    if (threshold >= count)
+      return copy(in, count, out);
+    size_t buckets = threshold / 2;
+    if (buckets == 0)
+      return 0;
+
+    size_t written = 0;
+    for (size_t b = 0; b < buckets; b++) {
+      size_t start = b * count / buckets;
+      size_t end = (b + 1) * count / buckets;
+      if (start == end)
+        continue;
+      size_t low = start;
+      size_t high = start;
+      for (size_t j = start + 1; j < end; j++) {
+        if (in[j].min < in[low].min)
+          low = j;
+        if (in[j].max > in[high].max)
+          high = j;
+      }
+      if (low == high) {
+        out[written++] = {in[low].timestamp, in[low].mean};
+      } else if (low < high) {
+        out[written++] = {in[low].timestamp, in[low].min};
+        out[written++] = {in[high].timestamp, in[high].max};
+      } else {
+        out[written++] = {in[high].timestamp, in[high].max};
+        out[written++] = {in[low].timestamp, in[low].min};
+      }
+    }
+    return written;
+  }
+
+  size_t run(Method_e method,
+             const History::Point_t* in,
+             size_t count,
+             Point_t* out,
+             size_t threshold) {
+    switch (method) {
+      case MIN_MAX:
+        return minMax(in, count, out, threshold);
+      case LTTB:
+      default:
+        return lttb(in, count, out, threshold);
+    }
+  }
+
+  const char* methodName(Method_e method) {
+    return method == MIN_MAX ? "minmax" : "lttb";
+  }
+}  // namespace Downsample
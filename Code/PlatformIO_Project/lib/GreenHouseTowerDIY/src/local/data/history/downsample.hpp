@@ -0,0 +1,52 @@
+#ifndef DOWNSAMPLE_HPP
+#define DOWNSAMPLE_HPP
+#include <Arduino.h>
+#include "local/data/history/historystore.hpp"
+
+/**
+ * @brief Downsampling kernels for charting history on a client
+ * @note Both kernels work on a time ordered array of history points and write
+ * at most threshold points, without allocating. When the input already fits
+ * the means are copied through unchanged.
+ */
+namespace Downsample {
+  enum Method_e : uint8_t {
+    LTTB,
+    MIN_MAX,
+  };
+
+  struct Point_t {
+    uint32_t timestamp;
+    float value;
+  };
+
+  /**
+   * @brief Largest-Triangle-Three-Buckets (Steinarsson, 2013)
+   * @note Keeps the first and last point and, per bucket, the point forming
+   * the largest triangle with the previous pick and the next bucket average.
+   * Follows the visual shape of the series.
+   */
+  size_t lttb(const History::Point_t* in,
+              size_t count,
+              Point_t* out,
+              size_t threshold);
+
+  /**
+   * @brief Min/max bucketing
+   * @note Emits the lowest and the highest point of each bucket in time order,
+   * using the rollup min and max so peaks survive any resolution.
+   */
+  size_t minMax(const History::Point_t* in,
+                size_t count,
+                Point_t* out,
+                size_t threshold);
+
+  size_t run(Method_e method,
+             const History::Point_t* in,
+             size_t count,
+             Point_t* out,
+             size_t threshold);
+  const char* methodName(Method_e method);
+}  // namespace Downsample
+
+#endif
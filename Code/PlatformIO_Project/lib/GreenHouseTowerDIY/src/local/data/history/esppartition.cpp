@@ -0,0 +1,35 @@
+#include "esppartition.hpp"
+
+EspPartition::EspPartition(const char* label)
+    : _label(label), _partition(nullptr) {}
+
+EspPartition::~EspPartition() {}
+
+bool EspPartition::begin() {
+  _partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, _label);
+  if (_partition == nullptr) {
+    log_e("[Flash Partition]: No '%s' partition", _label);
+    return false;
+  }
+  return true;
+}
+
+size_t EspPartition::size() const {
+  return _partition == nullptr ? 0 : _partition->size;
+}
+
+bool EspPartition::read(size_t offset, void* data, size_t length) {
+  return _partition != nullptr &&
+         esp_partition_read(_partition, offset, data, length) == ESP_OK;
+}
+
+bool EspPartition::write(size_t offset, const void* data, size_t length) {
+  return _partition != nullptr &&
+         esp_partition_write(_partition, offset, data, length) == ESP_OK;
+}
+
+bool EspPartition::erase(size_t offset, size_t length) {
+  return _partition != nullptr &&
+         esp_partition_erase_range(_partition, offset, length) == ESP_OK;
+}
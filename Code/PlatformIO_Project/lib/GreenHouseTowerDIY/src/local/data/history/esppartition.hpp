@@ -0,0 +1,25 @@
+#ifndef ESPPARTITION_HPP
+#define ESPPARTITION_HPP
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "local/data/history/flashpartition.hpp"
+
+/**
+ * @brief FlashPartition over the data partition with the given label
+ */
+class EspPartition : public FlashPartition {
+  const char* _label;
+  const esp_partition_t* _partition;
+
+ public:
+  explicit EspPartition(const char* label);
+  virtual ~EspPartition();
+
+  bool begin() override;
+  size_t size() const override;
+  bool read(size_t offset, void* data, size_t length) override;
+  bool write(size_t offset, const void* data, size_t length) override;
+  bool erase(size_t offset, size_t length) override;
+};
+
+#endif  // ESPPARTITION_HPP
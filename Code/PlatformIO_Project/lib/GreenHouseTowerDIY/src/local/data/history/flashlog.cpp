@@ -0,0 +1,246 @@
+#include "flashlog.hpp"
+#include <esp_rom_crc.h>
+#include <algorithm>
+#include <stddef.h>
+#include <vector>
+
+using namespace FlashLogFormat;
+
+FlashLog::FlashLog(FlashPartition& partition)
+    : _partition(partition),
+      _ready(false),
+      _sectors(0),
+      _sector(0),
+      _record(0),
+      _sequence(0),
+      _pending(0),
+      _tornRecords(0) {}
+
+FlashLog::~FlashLog() {}
+
+/**
+ * @brief Locate the partition and the write position
+ */
+bool FlashLog::begin() {
+  if (!_partition.begin()) {
+    log_e("[Flash Log]: No partition, history will not be persisted");
+    return false;
+  }
+  _sectors = _partition.size() / SECTOR_SIZE;
+  if (_sectors < 2) {
+    log_e("[Flash Log]: The partition needs at least two sectors");
+    return false;
+  }
+  _ready = true;
+  recover();
+  log_i("[Flash Log]: %u sectors, writing sector %u record %u (seq %u)",
+        _sectors, _sector, _record, _sequence);
+  return true;
+}
+
+//* Never written, as opposed to torn with a timestamp still reading 0xFFFFFFFF
+static bool erased(const Record_t& record) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+  for (size_t i = 0; i < sizeof(record); i++) {
+    if (bytes[i] != 0xFF)
+      return false;
+  }
+  return true;
+}
+
+size_t FlashLog::recordOffset(size_t sector, size_t record) {
+  return sector * SECTOR_SIZE + sizeof(SectorHeader_t) +
+         record * sizeof(Record_t);
+}
+
+bool FlashLog::readHeader(size_t sector, SectorHeader_t& header) {
+  if (!_partition.read(sector * SECTOR_SIZE, &header, sizeof(header)))
+    return false;
+  if (header.magic != MAGIC)
+    return false;
+  return header.crc == esp_rom_crc32_le(0,
+                                        reinterpret_cast<uint8_t*>(&header),
+                                        offsetof(SectorHeader_t, crc));
+}
+
+/**
+ * @brief Erase a sector and stamp it with a new header
+ */
+bool FlashLog::openSector(size_t sector, uint32_t sequence) {
+  if (!_partition.erase(sector * SECTOR_SIZE, SECTOR_SIZE)) {
+    log_e("[Flash Log]: Failed to erase sector %u", sector);
+    return false;
+  }
+
+  SectorHeader_t header = {
+      .magic = MAGIC,
+      .version = VERSION,
+      .channels = Telemetry::CHANNEL_COUNT,
+      .record_size = sizeof(Record_t),
+      .sequence = sequence,
+      .crc = 0,
+  };
+  header.crc = esp_rom_crc32_le(0, reinterpret_cast<uint8_t*>(&header),
+                                offsetof(SectorHeader_t, crc));
+  if (!_partition.write(sector * SECTOR_SIZE, &header, sizeof(header))) {
+    log_e("[Flash Log]: Failed to write header of sector %u", sector);
+    return false;
+  }
+
+  _sector = sector;
+  _sequence = sequence;
+  _record = 0;
+  return true;
+}
+
+/**
+ * @brief Find the newest sector and the first free record in it
+ * @note Only the headers and the tail sector are read
+ */
+void FlashLog::recover() {
+  bool found = false;
+  SectorHeader_t newest = {};
+  for (size_t s = 0; s < _sectors; s++) {
+    SectorHeader_t header;
+    if (!readHeader(s, header))
+      continue;
+    if (!found || header.sequence > newest.sequence) {
+      found = true;
+      newest = header;
+      _sector = s;
+    }
+  }
+
+  if (!found) {
+    log_i("[Flash Log]: Empty log, formatting sector 0");
+    openSector(0, 1);
+    return;
+  }
+
+  _sequence = newest.sequence;
+
+  //* Written by a firmware with another channel layout, start a new sector
+  if (newest.version != VERSION ||
+      newest.channels != Telemetry::CHANNEL_COUNT ||
+      newest.record_size != sizeof(Record_t)) {
+    _record = RECORDS_PER_SECTOR;
+    return;
+  }
+
+  //* Writes resume behind the last programmed slot, a failed write may have
+  //* left erased slots before it
+  _record = 0;
+  for (size_t r = 0; r < RECORDS_PER_SECTOR; r++) {
+    Record_t record;
+    if (!_partition.read(recordOffset(_sector, r), &record, sizeof(record))) {
+      _record = RECORDS_PER_SECTOR;
+      break;
+    }
+    if (erased(record))
+      continue;
+    _record = r + 1;
+    if (record.crc !=
+        esp_rom_crc32_le(0, reinterpret_cast<uint8_t*>(&record),
+                         offsetof(Record_t, crc))) {
+      _tornRecords++;
+      log_w("[Flash Log]: Torn record %u in sector %u", r, _sector);
+    }
+  }
+}
+
+/**
+ * @brief Queue one cycle for the log
+ * @note Records are written in batches of FLASH_LOG_BATCH to limit the number
+ * of flash program operations
+ */
+void FlashLog::append(const Telemetry::Sample_t& sample) {
+  if (!_ready)
+    return;
+
+  Record_t& record = _batch[_pending];
+  record.timestamp = sample.timestamp;
+  memcpy(record.values, sample.values, sizeof(record.values));
+  record.crc = esp_rom_crc32_le(0, reinterpret_cast<uint8_t*>(&record),
+                                offsetof(Record_t, crc));
+
+  if (++_pending >= FLASH_LOG_BATCH)
+    flush();
+}
+
+bool FlashLog::flush() {
+  if (!_ready || _pending == 0)
+    return true;
+  bool ok = write(_batch, _pending);
+  _pending = 0;
+  return ok;
+}
+
+bool FlashLog::write(const Record_t* records, size_t count) {
+  while (count > 0) {
+    if (_record >= RECORDS_PER_SECTOR &&
+        !openSector((_sector + 1) % _sectors, _sequence + 1))
+      return false;
+
+    size_t n = std::min(count, RECORDS_PER_SECTOR - _record);
+    if (!_partition.write(recordOffset(_sector, _record), records,
+                          n * sizeof(Record_t))) {
+      log_e("[Flash Log]: Failed to write %u records", n);
+      //* The slots may be partly programmed, never write them again
+      _record += n;
+      return false;
+    }
+    log_d("[Flash Log]: Wrote %u records to sector %u", n, _sector);
+    _record += n;
+    records += n;
+    count -= n;
+  }
+  return true;
+}
+
+/**
+ * @brief Load the logged samples back into the RAM history, oldest first
+ * @note Erased records are skipped rather than taken as the end of the log,
+ * a failed write leaves them in the middle of a sector.
+ * @return the number of samples replayed
+ */
+size_t FlashLog::replay(HistoryStore& history) {
+  if (!_ready)
+    return 0;
+
+  std::vector<std::pair<uint32_t, size_t>> order;
+  for (size_t s = 0; s < _sectors; s++) {
+    SectorHeader_t header;
+    if (readHeader(s, header) && header.version == VERSION &&
+        header.channels == Telemetry::CHANNEL_COUNT &&
+        header.record_size == sizeof(Record_t))
+      order.push_back({uint32_t(header.sequence), s});
+  }
+  std::sort(order.begin(), order.end());
+
+  size_t replayed = 0;
+  Telemetry::Sample_t sample;
+  for (auto& entry : order) {
+    for (size_t r = 0; r < RECORDS_PER_SECTOR; r++) {
+      Record_t record;
+      if (!_partition.read(recordOffset(entry.second, r), &record,
+                           sizeof(record)))
+        break;
+      if (erased(record) ||
+          record.crc !=
+          esp_rom_crc32_le(0, reinterpret_cast<uint8_t*>(&record),
+                           offsetof(Record_t, crc)))
+        continue;
+      sample.timestamp = record.timestamp;
+      sample.timestamp_ms = (uint64_t)record.timestamp * 1000;
+      memcpy(sample.values, record.values, sizeof(sample.values));
+      history.insert(sample);
+      replayed++;
+    }
+  }
+  log_i("[Flash Log]: Replayed %u samples into the history", replayed);
+  return replayed;
+}
+
+uint32_t FlashLog::getTornRecords() {
+  return _tornRecords;
+}
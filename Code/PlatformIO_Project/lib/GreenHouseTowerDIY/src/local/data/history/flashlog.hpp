@@ -0,0 +1,88 @@
+#ifndef FLASHLOG_HPP
+#define FLASHLOG_HPP
+#include <Arduino.h>
+#include "local/data/history/flashpartition.hpp"
+#include "local/data/history/historystore.hpp"
+#include "local/data/telemetry/telemetry.hpp"
+
+//* Samples buffered in RAM before they are written to flash
+#ifndef FLASH_LOG_BATCH
+#define FLASH_LOG_BATCH 10
+#endif  // FLASH_LOG_BATCH
+
+/**
+ * @brief Append-only sample log on a flash partition, "history" on the device
+ * @note Layout - the partition is a ring of 4KB erase sectors. Each sector
+ * starts with a CRC protected header carrying a sequence number that
+ * increases by one per sector, followed by fixed size records:
+ *
+ *   header  magic u32 | version u8 | channels u8 | record size u16 |
+ *           sequence u32 | crc32 u32
+ *   record  timestamp u32 | value f32 * channels | crc32 u32
+ *
+ * All fields are little endian. Erased flash reads 0xFF, so a record that is
+ * 0xFF throughout has never been written. Any other record
+ * that fails its CRC was torn by a power loss, it is skipped and its slot is
+ * never written again. A sector whose header fails its CRC was torn while
+ * being opened and is ignored.
+ * @note On boot only the sector headers and the newest sector are read to find
+ * the write position, behind the last programmed record. A write that failed
+ * leaves erased slots that are never filled, the replay skips them.
+ * tools/decode_history.py turns a dumped partition into CSV or JSON.
+ * @note The default partition table gives the log 64KB, 16 sectors of 85
+ * records, about 21 hours at the default 60 s interval.
+ */
+namespace FlashLogFormat {
+  const uint32_t MAGIC = 0x4C544847;  // "GHTL"
+  const uint8_t VERSION = 1;
+  const size_t SECTOR_SIZE = 4096;
+
+  struct __attribute__((packed)) SectorHeader_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t channels;
+    uint16_t record_size;
+    uint32_t sequence;
+    uint32_t crc;
+  };
+
+  struct __attribute__((packed)) Record_t {
+    uint32_t timestamp;
+    float values[Telemetry::CHANNEL_COUNT];
+    uint32_t crc;
+  };
+
+  const size_t RECORDS_PER_SECTOR =
+      (SECTOR_SIZE - sizeof(SectorHeader_t)) / sizeof(Record_t);
+}  // namespace FlashLogFormat
+
+class FlashLog {
+  FlashPartition& _partition;
+  bool _ready;
+  size_t _sectors;
+  size_t _sector;       // sector currently written
+  size_t _record;       // next record slot in that sector
+  uint32_t _sequence;   // sequence of the current sector
+  FlashLogFormat::Record_t _batch[FLASH_LOG_BATCH];
+  size_t _pending;
+  uint32_t _tornRecords;
+
+  bool readHeader(size_t sector, FlashLogFormat::SectorHeader_t& header);
+  bool openSector(size_t sector, uint32_t sequence);
+  void recover();
+  bool write(const FlashLogFormat::Record_t* records, size_t count);
+  size_t recordOffset(size_t sector, size_t record);
+
+ public:
+  explicit FlashLog(FlashPartition& partition);
+  virtual ~FlashLog();
+
+  bool begin();
+  void append(const Telemetry::Sample_t& sample);
+  bool flush();
+  size_t replay(HistoryStore& history);
+
+  uint32_t getTornRecords();
+};
+
+#endif
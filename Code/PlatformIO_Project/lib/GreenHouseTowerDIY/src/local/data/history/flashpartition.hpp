@@ -0,0 +1,23 @@
+#ifndef FLASHPARTITION_HPP
+#define FLASHPARTITION_HPP
+#include <Arduino.h>
+
+/**
+ * @brief Raw access to a flash region, what FlashLog stores its ring in
+ * @note Flash semantics: erase() sets whole sectors to 0xFF, write() can only
+ * clear bits. EspPartition maps it onto a data partition, the host tests use
+ * a RAM fake.
+ */
+class FlashPartition {
+ public:
+  virtual ~FlashPartition() {}
+
+  //* Locate the region, false when it does not exist
+  virtual bool begin() = 0;
+  virtual size_t size() const = 0;
+  virtual bool read(size_t offset, void* data, size_t length) = 0;
+  virtual bool write(size_t offset, const void* data, size_t length) = 0;
+  virtual bool erase(size_t offset, size_t length) = 0;
+};
+
+#endif  // FLASHPARTITION_HPP
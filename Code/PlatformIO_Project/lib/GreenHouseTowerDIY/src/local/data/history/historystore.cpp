@@ -0,0 +1,270 @@
+#include "historystore.hpp"
+#include <algorithm>
+
+HistoryStore::HistoryStore() : _tiers{}, _lastTimestamp(0) {}
+
+HistoryStore::~HistoryStore() {
+  for (auto& tier : _tiers) {
+    free(tier.timestamps);
+  }
+}
+
+/**
+ * @brief Allocate all tiers up front
+ * @note Prefers PSRAM when the board has it
+ */
+bool HistoryStore::begin() {
+  bool ok = allocate(_tiers[History::RAW], HISTORY_RAW_SLOTS, 0) &&
+            allocate(_tiers[History::FIVE_MINUTES], HISTORY_5M_SLOTS, 300) &&
+            allocate(_tiers[History::ONE_HOUR], HISTORY_1H_SLOTS, 3600);
+  if (!ok) {
+    log_e("[History]: Unable to allocate the history store");
+    return false;
+  }
+  log_i("[History]: %d raw, %d 5m and %d 1h slots for %d channels",
+        HISTORY_RAW_SLOTS, HISTORY_5M_SLOTS, HISTORY_1H_SLOTS,
+        Telemetry::CHANNEL_COUNT);
+  return true;
+}
+
+bool HistoryStore::allocate(Tier_t& tier, size_t capacity, uint32_t period) {
+  size_t series = period == 0 ? 1 : 3;
+  size_t bytes = capacity * sizeof(uint32_t) +
+                 series * Telemetry::CHANNEL_COUNT * capacity * sizeof(float);
+
+  uint8_t* block = static_cast<uint8_t*>(
+      heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (block == nullptr)
+    block = static_cast<uint8_t*>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+  if (block == nullptr)
+    return false;
+
+  tier.capacity = capacity;
+  tier.period = period;
+  tier.head = 0;
+  tier.count = 0;
+  tier.timestamps = reinterpret_cast<uint32_t*>(block);
+  tier.mean = reinterpret_cast<float*>(block + capacity * sizeof(uint32_t));
+  if (period == 0) {
+    tier.min = tier.mean;
+    tier.max = tier.mean;
+  } else {
+    tier.min = tier.mean + Telemetry::CHANNEL_COUNT * capacity;
+    tier.max = tier.min + Telemetry::CHANNEL_COUNT * capacity;
+  }
+  resetBucket(tier, 0);
+  return true;
+}
+
+void HistoryStore::resetBucket(Tier_t& tier, uint32_t bucket) {
+  tier.bucket = bucket;
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    tier.accMin[c] = INFINITY;
+    tier.accMax[c] = -INFINITY;
+    tier.accSum[c] = 0;
+    tier.accCount[c] = 0;
+  }
+}
+
+//* Close the bucket being accumulated into the next ring slot
+void HistoryStore::flushBucket(Tier_t& tier) {
+  bool empty = true;
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    if (tier.accCount[c] > 0) {
+      empty = false;
+      break;
+    }
+  }
+  if (empty)
+    return;
+
+  size_t s = tier.head;
+  tier.timestamps[s] = tier.bucket;
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    size_t i = c * tier.capacity + s;
+    if (tier.accCount[c] == 0) {
+      tier.min[i] = tier.max[i] = tier.mean[i] = NAN;
+      continue;
+    }
+    tier.min[i] = tier.accMin[c];
+    tier.max[i] = tier.accMax[c];
+    tier.mean[i] = tier.accSum[c] / tier.accCount[c];
+  }
+  tier.head = (tier.head + 1) % tier.capacity;
+  if (tier.count < tier.capacity)
+    tier.count++;
+}
+
+/**
+ * @brief Append one acquisition cycle
+ * @note Samples must arrive in time order, anything at or before the last
+ * stored timestamp (e.g. an NTP step backwards) is dropped so the rings stay
+ * sorted.
+ */
+void HistoryStore::insert(const Telemetry::Sample_t& sample) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_tiers[History::RAW].timestamps == nullptr)
+    return;
+  if (sample.timestamp <= _lastTimestamp) {
+    log_w("[History]: Dropping out of order sample %u", sample.timestamp);
+    return;
+  }
+  _lastTimestamp = sample.timestamp;
+
+  //* Raw tier
+  Tier_t& raw = _tiers[History::RAW];
+  raw.timestamps[raw.head] = sample.timestamp;
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    raw.mean[c * raw.capacity + raw.head] = sample.values[c];
+  }
+  raw.head = (raw.head + 1) % raw.capacity;
+  if (raw.count < raw.capacity)
+    raw.count++;
+
+  //* Rollup tiers
+  for (uint8_t r = History::FIVE_MINUTES; r < History::RESOLUTION_COUNT; r++) {
+    Tier_t& tier = _tiers[r];
+    uint32_t bucket = sample.timestamp - (sample.timestamp % tier.period);
+    if (bucket != tier.bucket) {
+      flushBucket(tier);
+      resetBucket(tier, bucket);
+    }
+    for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+      float value = sample.values[c];
+      if (isnan(value))
+        continue;
+      tier.accMin[c] = std::min(tier.accMin[c], value);
+      tier.accMax[c] = std::max(tier.accMax[c], value);
+      tier.accSum[c] += value;
+      tier.accCount[c]++;
+    }
+  }
+}
+
+//* Ring slot of the index-th oldest entry
+size_t HistoryStore::slot(const Tier_t& tier, size_t index) const {
+  return (tier.head + tier.capacity - tier.count + index) % tier.capacity;
+}
+
+//* Index of the first entry at or after timestamp
+size_t HistoryStore::lowerBound(const Tier_t& tier, uint32_t timestamp) const {
+  size_t low = 0;
+  size_t high = tier.count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (tier.timestamps[slot(tier, mid)] < timestamp)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+History::Point_t HistoryStore::point(const Tier_t& tier,
+                                     Telemetry::Channel_e channel,
+                                     size_t s) const {
+  size_t i = channel * tier.capacity + s;
+  return {tier.timestamps[s], tier.min[i], tier.max[i], tier.mean[i]};
+}
+
+/**
+ * @brief Number of valid points of a channel within [from, to]
+ */
+size_t HistoryStore::count(Telemetry::Channel_e channel,
+                           History::Resolution_e resolution,
+                           uint32_t from,
+                           uint32_t to) {
+  if (channel >= Telemetry::CHANNEL_COUNT ||
+      resolution >= History::RESOLUTION_COUNT)
+    return 0;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const Tier_t& tier = _tiers[resolution];
+  size_t total = 0;
+  for (size_t i = lowerBound(tier, from); i < tier.count; i++) {
+    size_t s = slot(tier, i);
+    if (tier.timestamps[s] > to)
+      break;
+    if (!isnan(tier.mean[channel * tier.capacity + s]))
+      total++;
+  }
+  return total;
+}
+
+/**
+ * @brief Copy the valid points of a channel within [from, to]
+ * @note Returns at most max points, oldest first. Page through a long range by
+ * calling again with from set past the last returned timestamp.
+ */
+size_t HistoryStore::query(Telemetry::Channel_e channel,
+                           History::Resolution_e resolution,
+                           uint32_t from,
+                           uint32_t to,
+                           History::Point_t* out,
+                           size_t max) {
+  if (channel >= Telemetry::CHANNEL_COUNT ||
+      resolution >= History::RESOLUTION_COUNT)
+    return 0;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const Tier_t& tier = _tiers[resolution];
+  size_t written = 0;
+  for (size_t i = lowerBound(tier, from); i < tier.count && written < max;
+       i++) {
+    size_t s = slot(tier, i);
+    if (tier.timestamps[s] > to)
+      break;
+    History::Point_t p = point(tier, channel, s);
+    if (isnan(p.mean))
+      continue;
+    out[written++] = p;
+  }
+  return written;
+}
+
+/**
+ * @brief Compress the means of a channel within [from, to]
+ * @note Used by the bulk export paths. Stops early when the encoder buffer is
+ * full, the points written so far remain decodable.
+ * @return the number of points encoded
+ */
+size_t HistoryStore::encode(Telemetry::Channel_e channel,
+                            History::Resolution_e resolution,
+                            uint32_t from,
+                            uint32_t to,
+                            GorillaEncoder& encoder) {
+  History::Point_t page[16];
+  size_t encoded = 0;
+  while (from <= to) {
+    size_t n = query(channel, resolution, from, to, page, 16);
+    for (size_t i = 0; i < n; i++) {
+      if (!encoder.append(page[i].timestamp, page[i].mean))
+        return encoded;
+      encoded++;
+    }
+    if (n < 16 || page[n - 1].timestamp == UINT32_MAX)
+      break;
+    from = page[n - 1].timestamp + 1;
+  }
+  return encoded;
+}
+
+uint32_t HistoryStore::getPeriod(History::Resolution_e resolution) const {
+  if (resolution >= History::RESOLUTION_COUNT)
+    return 0;
+  return _tiers[resolution].period;
+}
+
+/**
+ * @brief Finest resolution that still reaches back to from
+ */
+History::Resolution_e HistoryStore::resolutionFor(uint32_t from) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (uint8_t r = History::RAW; r < History::RESOLUTION_COUNT; r++) {
+    const Tier_t& tier = _tiers[r];
+    if (tier.count == tier.capacity && tier.timestamps[slot(tier, 0)] > from)
+      continue;
+    return static_cast<History::Resolution_e>(r);
+  }
+  return History::ONE_HOUR;
+}
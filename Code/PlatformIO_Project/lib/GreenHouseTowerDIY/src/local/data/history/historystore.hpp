@@ -0,0 +1,107 @@
+#ifndef HISTORYSTORE_HPP
+#define HISTORYSTORE_HPP
+#include <Arduino.h>
+#include <mutex>
+#include "local/data/codec/gorilla.hpp"
+#include "local/data/telemetry/telemetry.hpp"
+
+//* Raw samples, enough for the last hour at the 60 s acquisition interval
+#ifndef HISTORY_RAW_SLOTS
+#define HISTORY_RAW_SLOTS 64
+#endif  // HISTORY_RAW_SLOTS
+
+//* 5 minute rollups, one day
+#ifndef HISTORY_5M_SLOTS
+#define HISTORY_5M_SLOTS 288
+#endif  // HISTORY_5M_SLOTS
+
+//* 1 hour rollups, one week
+#ifndef HISTORY_1H_SLOTS
+#define HISTORY_1H_SLOTS 168
+#endif  // HISTORY_1H_SLOTS
+
+namespace History {
+  enum Resolution_e : uint8_t {
+    RAW,
+    FIVE_MINUTES,
+    ONE_HOUR,
+    RESOLUTION_COUNT
+  };
+
+  struct Point_t {
+    uint32_t timestamp;
+    float min;
+    float max;
+    float mean;
+  };
+}  // namespace History
+
+/**
+ * @brief Fixed memory time-series store
+ * @note Each resolution is a ring of slots kept as a struct of arrays - one
+ * timestamp array plus one value array per channel and statistic - so a range
+ * query over one channel walks contiguous memory. All tiers are allocated
+ * once in begin() and never grow.
+ * @note Rollups are bucketed on wall clock boundaries, a bucket becomes
+ * visible once the first sample of the next bucket arrives.
+ */
+class HistoryStore {
+  struct Tier_t {
+    size_t capacity;
+    uint32_t period;  // seconds per slot, 0 for raw samples
+    size_t head;      // next slot to write
+    size_t count;
+    uint32_t* timestamps;
+    //* [channel * capacity + slot], raw samples only use mean
+    float* min;
+    float* max;
+    float* mean;
+
+    //* bucket currently being accumulated
+    uint32_t bucket;
+    float accMin[Telemetry::CHANNEL_COUNT];
+    float accMax[Telemetry::CHANNEL_COUNT];
+    float accSum[Telemetry::CHANNEL_COUNT];
+    uint16_t accCount[Telemetry::CHANNEL_COUNT];
+  };
+
+  Tier_t _tiers[History::RESOLUTION_COUNT];
+  mutable std::mutex _mutex;
+  uint32_t _lastTimestamp;
+
+  bool allocate(Tier_t& tier, size_t capacity, uint32_t period);
+  void resetBucket(Tier_t& tier, uint32_t bucket);
+  void flushBucket(Tier_t& tier);
+  size_t slot(const Tier_t& tier, size_t index) const;
+  size_t lowerBound(const Tier_t& tier, uint32_t timestamp) const;
+  History::Point_t point(const Tier_t& tier,
+                         Telemetry::Channel_e channel,
+                         size_t slot) const;
+
+ public:
+  HistoryStore();
+  virtual ~HistoryStore();
+
+  bool begin();
+  void insert(const Telemetry::Sample_t& sample);
+
+  size_t count(Telemetry::Channel_e channel,
+               History::Resolution_e resolution,
+               uint32_t from,
+               uint32_t to);
+  size_t query(Telemetry::Channel_e channel,
+               History::Resolution_e resolution,
+               uint32_t from,
+               uint32_t to,
+               History::Point_t* out,
+               size_t max);
+  size_t encode(Telemetry::Channel_e channel,
+                History::Resolution_e resolution,
+                uint32_t from,
+                uint32_t to,
+                GorillaEncoder& encoder);
+  uint32_t getPeriod(History::Resolution_e resolution) const;
+  History::Resolution_e resolutionFor(uint32_t from) const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "replayharness.hpp"
+
+ReplayHarness::ReplayHarness(VirtualClock& clock,
+                             SensorTrace& trace,
+                             AccumulateData& data,
+                             DataSnapshot& snapshot)
+    : _clock(clock),
+      _trace(trace),
+      _data(data),
+      _snapshot(snapshot),
+      _reported(0),
+      _done(false) {}
+
+ReplayHarness::~ReplayHarness() {}
+
+/**
+ * @brief Report the cycle AccumulateData just ran, then move trace time on
+ * @note Call right after AccumulateData::loop()
+ */
+void ReplayHarness::loop() {
+  if (_done)
+    return;
+
+  if (_data.getCycleCount() != _reported) {
+    _reported = _data.getCycleCount();
+    report();
+  }
+
+  if (_trace.finished()) {
+    _done = true;
+    Serial.printf("REPLAY_END {\"cycles\":%u,\"trace_ms\":%u}\n", _reported,
+                  _trace.elapsed());
+    return;
+  }
+  _clock.advance(REPLAY_STEP_MS);
+}
+
+//* Written piecewise, the document is not copied
+void ReplayHarness::report() {
+  DataSnapshot::Body_t body = _snapshot.get();
+  Serial.printf(
+      "REPLAY {\"cycle\":%u,\"trace_ms\":%u,\"latency_us\":%u,\"heap\":%d,"
+      "\"arena\":%u",
+      _reported, _trace.elapsed(), _data.getCycleMicros(),
+      _data.getCycleHeap(), CycleArena::getCycleUsed());
+#if ALLOC_TRACKING
+  AllocTracker::Counter_t allocs = AllocTracker::getCycleTotal();
+  Serial.printf(",\"allocs\":%u,\"alloc_bytes\":%u,\"leaks\":%u",
+                allocs.allocs, allocs.bytes, AllocTracker::getCycleLeaks());
+#endif  // ALLOC_TRACKING
+  Serial.print(",\"doc\":");
+  Serial.print(body->json.c_str());
+  Serial.print(",\"cbor\":\"");
+  char hex[3];
+  for (uint8_t byte : body->cbor) {
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    Serial.print(hex);
+  }
+  Serial.print("\"}\n");
+}
@@ -0,0 +1,50 @@
+#ifndef REPLAYHARNESS_HPP
+#define REPLAYHARNESS_HPP
+#include <Arduino.h>
+#include <local/data/accumulatedata/accumulatedata.hpp>
+#include <local/data/clock/clock.hpp>
+#include <local/data/snapshot/datasnapshot.hpp>
+#include <local/io/sensors/trace/sensortrace.hpp>
+
+//* Trace time added per loop() call
+#ifndef REPLAY_STEP_MS
+#define REPLAY_STEP_MS 1000
+#endif  // REPLAY_STEP_MS
+
+/**
+ * @brief Runs AccumulateData over a SensorTrace and reports every cycle
+ * @note Built with -DSENSOR_TRACE_REPLAY=1. The sensors and the acquisition
+ * run on a VirtualClock moved REPLAY_STEP_MS per loop(), so hours of trace
+ * replay in minutes while WiFi and MQTT stay on the system clock.
+ * @note Replayed cycles are neither published, queued nor written to the
+ * flash log, they only reach the snapshot and the RAM history. The flash log
+ * is not loaded either, so the history holds the trace alone.
+ * @note One line per cycle on Serial, then REPLAY_END once the trace ran out:
+ *   REPLAY {"cycle":1,"trace_ms":60000,"latency_us":812,"heap":0,
+ *           "doc":{...},"cbor":"a5..."}
+ * with allocs, alloc_bytes and leaks after heap in allocation tracking builds.
+ * tools/replay_trace.py extracts them from a monitor log and compares them
+ * with a golden file.
+ */
+class ReplayHarness {
+  VirtualClock& _clock;
+  SensorTrace& _trace;
+  AccumulateData& _data;
+  DataSnapshot& _snapshot;
+  uint32_t _reported;
+  bool _done;
+
+  void report();
+
+ public:
+  ReplayHarness(VirtualClock& clock,
+                SensorTrace& trace,
+                AccumulateData& data,
+                DataSnapshot& snapshot);
+  virtual ~ReplayHarness();
+
+  void loop();
+  bool isDone() const { return _done; }
+};
+
+#endif  // REPLAYHARNESS_HPP
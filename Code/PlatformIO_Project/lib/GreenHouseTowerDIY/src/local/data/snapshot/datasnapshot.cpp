@@ -0,0 +1,130 @@
+#include "datasnapshot.hpp"
+#include <esp_system.h>
+
+//* The ROM deflater needs ~300KB of state, only use it when PSRAM is present
+#ifdef BOARD_HAS_PSRAM
+#include <rom/crc.h>
+#include <rom/miniz.h>
+#endif  // BOARD_HAS_PSRAM
+
+DataSnapshot::DataSnapshot()
+    : _body(std::make_shared<SnapshotBody_t>()),
+      _sequence(0),
+      _nonce(esp_random()),
+      _compressor(nullptr) {}
+
+DataSnapshot::~DataSnapshot() {
+  if (_compressor != nullptr)
+    free(_compressor);
+}
+
+/**
+ * @brief Publish a new data document
+ * @note Called once per acquisition cycle. The ETag and the optional gzip copy
+ * are built here so that the request handlers never touch the payload.
+ * @note cbor is the binary form of the same cycle, served on request
+ */
+void DataSnapshot::update(const char* json,
+                          size_t length,
+                          const uint8_t* cbor,
+                          size_t cborLength) {
+  auto body = std::make_shared<SnapshotBody_t>();
+  body->json.assign(json, length);
+  if (cbor != nullptr)
+    body->cbor.assign(cbor, cbor + cborLength);
+  body->sequence = _sequence + 1;
+  snprintf(body->etag, sizeof(body->etag), "\"%08x-%08x\"", _nonce,
+           body->sequence);
+  snprintf(body->etagGzip, sizeof(body->etagGzip), "\"%08x-%08x-gz\"",
+           _nonce, body->sequence);
+  snprintf(body->etagCbor, sizeof(body->etagCbor), "\"%08x-%08x-c\"", _nonce,
+           body->sequence);
+
+  if (!compress(body->json, body->gzip)) {
+    body->gzip.clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sequence = body->sequence;
+    _body = body;
+  }
+  log_d("[Data Snapshot]: Sequence %u - %u bytes json, %u bytes gzip",
+        body->sequence, body->json.size(), body->gzip.size());
+
+  //* Hand the new body to the push channels
+  Body_t published = body;
+  for (auto& listener : _listeners) {
+    listener(published);
+  }
+}
+
+/**
+ * @brief Register a callback fired after every update
+ * @note Listeners run on the acquisition task, keep them short
+ */
+void DataSnapshot::onUpdate(Listener_t listener) {
+  _listeners.push_back(listener);
+}
+
+DataSnapshot::Body_t DataSnapshot::get() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _body;
+}
+
+uint32_t DataSnapshot::getSequence() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _sequence;
+}
+
+/**
+ * @brief Gzip the document with the ROM deflater
+ * @return false when compression is unavailable or failed
+ */
+bool DataSnapshot::compress(const std::string& input,
+                            std::vector<uint8_t>& output) {
+#ifdef BOARD_HAS_PSRAM
+  if (_compressor == nullptr) {
+    _compressor = ps_malloc(sizeof(tdefl_compressor));
+    if (_compressor == nullptr) {
+      log_w("[Data Snapshot]: Unable to allocate the gzip compressor");
+      return false;
+    }
+  }
+
+  tdefl_compressor* compressor = static_cast<tdefl_compressor*>(_compressor);
+  if (tdefl_init(compressor, nullptr, nullptr, TDEFL_DEFAULT_MAX_PROBES) !=
+      TDEFL_STATUS_OKAY) {
+    return false;
+  }
+
+  //* gzip header - deflate, no flags, no mtime, unix
+  static const uint8_t header[10] = {0x1f, 0x8b, 0x08, 0x00, 0x00,
+                                     0x00, 0x00, 0x00, 0x00, 0x03};
+  output.assign(header, header + sizeof(header));
+  output.resize(sizeof(header) + input.size() + 64);
+
+  size_t inSize = input.size();
+  size_t outSize = output.size() - sizeof(header) - 8;
+  tdefl_status status =
+      tdefl_compress(compressor, input.data(), &inSize,
+                     output.data() + sizeof(header), &outSize, TDEFL_FINISH);
+  if (status != TDEFL_STATUS_DONE) {
+    log_w("[Data Snapshot]: gzip failed with status %d", status);
+    return false;
+  }
+  output.resize(sizeof(header) + outSize);
+
+  //* gzip trailer - crc32 and input size, little endian
+  uint32_t crc = crc32_le(0, reinterpret_cast<const uint8_t*>(input.data()),
+                          input.size());
+  uint32_t size = input.size();
+  for (int i = 0; i < 4; i++)
+    output.push_back((crc >> (i * 8)) & 0xff);
+  for (int i = 0; i < 4; i++)
+    output.push_back((size >> (i * 8)) & 0xff);
+  return true;
+#else
+  return false;
+#endif  // BOARD_HAS_PSRAM
+}
@@ -0,0 +1,55 @@
+#ifndef DATASNAPSHOT_HPP
+#define DATASNAPSHOT_HPP
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Immutable copy of the latest data document
+ * @note A new body is built once per acquisition cycle, readers only ever
+ * hold a shared pointer to it so a request in flight is never affected by
+ * the next cycle.
+ */
+struct SnapshotBody_t {
+  std::string json;
+  std::vector<uint8_t> gzip;
+  std::vector<uint8_t> cbor;
+  uint32_t sequence;
+  //* Quoted entity tags per representation, "<boot nonce>-<sequence>[-gz|-c]"
+  char etag[20];
+  char etagGzip[24];
+  char etagCbor[24];
+};
+
+class DataSnapshot {
+ public:
+  using Body_t = std::shared_ptr<const SnapshotBody_t>;
+  using Listener_t = std::function<void(const Body_t&)>;
+
+  DataSnapshot();
+  virtual ~DataSnapshot();
+
+  void update(const char* json,
+              size_t length,
+              const uint8_t* cbor = nullptr,
+              size_t cborLength = 0);
+  Body_t get() const;
+  uint32_t getSequence() const;
+  void onUpdate(Listener_t listener);
+
+ private:
+  bool compress(const std::string& input, std::vector<uint8_t>& output);
+
+  mutable std::mutex _mutex;
+  Body_t _body;
+  std::vector<Listener_t> _listeners;
+  uint32_t _sequence;
+  //* Random per boot, so a tag from before a reboot never matches
+  uint32_t _nonce;
+  void* _compressor;
+};
+
+#endif
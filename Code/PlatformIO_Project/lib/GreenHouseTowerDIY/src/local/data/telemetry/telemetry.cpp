@@ -0,0 +1,49 @@
+#include "telemetry.hpp"
+
+//* Names match the keys used by the sensors and serializers
+const char* const Telemetry::channel_names[Telemetry::CHANNEL_COUNT] = {
+    "ldr",         "water_level_sensor", "water_level_percentage",
+    "temperature", "dht_hum",            "dht_temp",
+    "sht31_1_hum", "sht31_1_temp",       "sht31_2_hum",
+    "sht31_2_temp",
+};
+
+const uint8_t Telemetry::channel_precision[Telemetry::CHANNEL_COUNT] = {
+    1, 1, 1, 2, 2, 2, 2, 2, 2, 2,
+};
+
+const char* Telemetry::channelName(Channel_e channel) {
+  if (channel >= CHANNEL_COUNT)
+    return "unknown";
+  return channel_names[channel];
+}
+
+uint8_t Telemetry::channelPrecision(Channel_e channel) {
+  if (channel >= CHANNEL_COUNT)
+    return 3;
+  return channel_precision[channel];
+}
+
+Telemetry::Channel_e Telemetry::channelFromName(const char* name,
+                                                size_t length) {
+  for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+    if (strncmp(channel_names[i], name, length) == 0 &&
+        channel_names[i][length] == '\0') {
+      return static_cast<Channel_e>(i);
+    }
+  }
+  return CHANNEL_COUNT;
+}
+
+Telemetry::Channel_e Telemetry::channelFromName(const std::string& name) {
+  return channelFromName(name.c_str(), name.length());
+}
+
+void Telemetry::clear(Sample_t& sample) {
+  sample.timestamp = 0;
+  sample.timestamp_ms = 0;
+  sample.uptime = 0;
+  for (auto& value : sample.values) {
+    value = NAN;
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+#include <Arduino.h>
+#include <string>
+
+/**
+ * @brief Numeric view of one acquisition cycle
+ * @note Every scalar the tower measures gets a fixed channel id, the history,
+ * logging and encoding modules work on channel ids instead of sensor names.
+ * Channel ids are part of the stored and transmitted formats - only ever
+ * append new channels.
+ */
+namespace Telemetry {
+  enum Channel_e : uint8_t {
+    LDR,
+    WATER_LEVEL,
+    WATER_LEVEL_PERCENTAGE,
+    TOWER_TEMP,
+    DHT_HUM,
+    DHT_TEMP,
+    SHT31_1_HUM,
+    SHT31_1_TEMP,
+    SHT31_2_HUM,
+    SHT31_2_TEMP,
+    CHANNEL_COUNT
+  };
+
+  struct Sample_t {
+    uint32_t timestamp;  // epoch seconds
+    uint64_t timestamp_ms;  // epoch milliseconds, 0 when the clock is unsynced
+    uint32_t uptime;  // seconds since boot, dates cycles taken before a sync
+    float values[CHANNEL_COUNT];  // NAN when the channel was not read
+  };
+
+  extern const char* const channel_names[CHANNEL_COUNT];
+  //* Decimals a channel is printed with, matches getPrecision() of its sensor
+  extern const uint8_t channel_precision[CHANNEL_COUNT];
+
+  const char* channelName(Channel_e channel);
+  uint8_t channelPrecision(Channel_e channel);
+  //* Returns CHANNEL_COUNT when the name is unknown
+  Channel_e channelFromName(const char* name, size_t length);
+  Channel_e channelFromName(const std::string& name);
+  void clear(Sample_t& sample);
+}  // namespace Telemetry
+
+#endif
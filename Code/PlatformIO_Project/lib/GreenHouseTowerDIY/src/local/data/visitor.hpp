@@ -1,12 +1,24 @@
 #ifndef VISITOR_HPP
 #define VISITOR_HPP
+#include <string_view>
+#include "local/data/fixedstring/fixedstring.hpp"
+
+//* Longest sensor name a serializer keeps
+#ifndef SENSOR_NAME_SIZE
+#define SENSOR_NAME_SIZE 32
+#endif  // SENSOR_NAME_SIZE
+
+typedef FixedString<SENSOR_NAME_SIZE> SensorName_t;
 
 template <typename T>
 class SensorInterface {
  public:
   virtual ~SensorInterface() = default;
-  virtual const std::string& getSensorName() = 0;
+  //* Names are string literals, the view stays valid forever
+  virtual std::string_view getSensorName() = 0;
   virtual T read() = 0;
+  //* Decimals used when the reading is formatted as text
+  virtual uint8_t getPrecision() { return 3; }
 };
 
 template <typename T>
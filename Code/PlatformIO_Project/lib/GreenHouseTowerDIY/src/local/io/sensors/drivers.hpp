@@ -0,0 +1,25 @@
+#ifndef SENSOR_DRIVERS_HPP
+#define SENSOR_DRIVERS_HPP
+#include <Adafruit_SHT31.h>
+#include <DHT_U.h>
+#include <DallasTemperature.h>
+#include <HCSR04.h>
+#include <hp_BH1750.h>
+
+//* Hardware drivers, or trace playback with -DSENSOR_TRACE_REPLAY=1
+#if SENSOR_TRACE_REPLAY
+#include "local/io/sensors/trace/tracedrivers.hpp"
+using SHT31Driver_t = TraceSHT31;
+using DHTDriver_t = TraceDHT;
+using DS18B20Driver_t = TraceDallas;
+using UltrasonicDriver_t = TraceUltrasonic;
+using BH1750Driver_t = TraceBH1750;
+#else
+using SHT31Driver_t = Adafruit_SHT31;
+using DHTDriver_t = DHT_Unified;
+using DS18B20Driver_t = DallasTemperature;
+using UltrasonicDriver_t = UltraSonicDistanceSensor;
+using BH1750Driver_t = hp_BH1750;
+#endif  // SENSOR_TRACE_REPLAY
+
+#endif  // SENSOR_DRIVERS_HPP
@@ -22,7 +22,7 @@ std::string Humidity::map_return_keys[6] = {"dht_hum",     "dht_temp",
                                             "sht31_1_hum", "sht31_1_temp",
                                             "sht31_2_hum", "sht31_2_temp"};
 
-Humidity::Humidity(GreenHouseConfig& config)
+Humidity::Humidity(GreenHouseConfig& config, Clock& clock)
     : _delayS(0),
       _enableHeater(false),
       _loopCnt(0),
@@ -37,6 +37,7 @@ Humidity::Humidity(GreenHouseConfig& config)
       _humiditySensorsActive(
           GreenHouseConfig::HumidityFeatures_t::NONE_HUMIDITY),
       _config(config),
+      _clock(clock),
       sht31(),
       sht31_2(),
       dht(_config.getEnabledFeatures().dht_pin,
@@ -154,7 +155,7 @@ GreenHouseConfig::HumidityFeatures_t Humidity::setup() {
         _humiditySensorsActive =
             GreenHouseConfig::HumidityFeatures_t::BOTH_HUMIDITY;
       }
-      delay(2L);  // delay in between reads for stability
+      _clock.delay(2);  // delay in between reads for stability
       break;
     default:
       log_d("[Humidity]: No Humidity Sensors Enabled");
@@ -167,7 +168,7 @@ GreenHouseConfig::HumidityFeatures_t Humidity::setup() {
 
 void Humidity::readDHT() {
   //* Delay between measurements.
-  Network_Utilities::my_delay(_delayS * 2);
+  _clock.delay(_delayS * 2);
 
   //* Get temperature event and print its value.
   sensors_event_t event;
@@ -353,9 +354,6 @@ void Humidity::readSHT31() {
       // check if 'is not a number'
       checkISNAN("[Humidity]: Temp", temp);
       checkISNAN("[Humidity]: Humidity", hum);
-      Network_Utilities::my_delay(
-          0.1L);  // delay in between reads for stability
-
       // Toggle heater enabled state every 30 seconds
       // An ~3.0 degC _temperature increase can be noted when heater is
       // enabled This is needed due to the high operating humidity of the
@@ -372,9 +370,6 @@ void Humidity::readSHT31() {
       checkISNAN("[Humidity]: Temp_2", temp_2);
       checkISNAN("[Humidity]: Hum_2", hum_2);
 
-      Network_Utilities::my_delay(
-          0.1L);  // delay in between reads for stability
-
       // Toggle heater enabled state every 30 seconds
       // An ~3.0 degC _temperature increase can be noted when heater is
       // enabled This is needed due to the high operating humidity of the
@@ -395,7 +390,7 @@ void Humidity::readSHT31() {
       float hum_2 = sht31_2.readHumidity();
       checkISNAN("[Humidity]: Hum_1", hum_1);
       checkISNAN("[Humidity]: Hum_2", hum_2);
-      Network_Utilities::my_delay(1L);  // delay in between reads for stability
+      _clock.delay(5);  // delay in between reads for stability
       _humidity.at(map_return_keys[2]) = hum_1;
       _humidity.at(map_return_keys[3]) = temp_1;
       _humidity.at(map_return_keys[4]) = hum_2;
@@ -411,9 +406,8 @@ void Humidity::readSHT31() {
   }
 }
 
-const std::string& Humidity::getSensorName() {
-  static std::string name = "humidity";
-  return name;
+std::string_view Humidity::getSensorName() {
+  return "humidity";
 }
 
 void Humidity::accept(Visitor<SensorInterface<Humidity_Return_t>>& visitor) {
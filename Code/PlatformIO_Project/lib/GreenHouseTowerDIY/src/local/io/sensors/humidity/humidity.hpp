@@ -12,8 +12,10 @@
 #include <Wire.h>
 #include <functional>
 #include <unordered_map>
+#include "local/data/clock/clock.hpp"
 #include "local/data/config/config.hpp"
 #include "local/data/visitor.hpp"
+#include "local/io/sensors/drivers.hpp"
 
 // #define DHTTYPE DHT11  // DHT 11
 // #define DHTTYPE DHT22  // DHT 22 (AM2302)
@@ -33,9 +35,10 @@ class Humidity : public Element<Visitor<SensorInterface<Humidity_Return_t>>>,
   GreenHouseConfig::HumidityFeatures_t _humiditySensorsActive;
 
   GreenHouseConfig& _config;
-  Adafruit_SHT31 sht31;
-  Adafruit_SHT31 sht31_2;
-  DHT_Unified dht;
+  Clock& _clock;
+  SHT31Driver_t sht31;
+  SHT31Driver_t sht31_2;
+  DHTDriver_t dht;
 
   GreenHouseConfig::HumidityFeatures_t setup();
   void readDHT();
@@ -46,11 +49,12 @@ class Humidity : public Element<Visitor<SensorInterface<Humidity_Return_t>>>,
   float towerTemp();
 
  public:
-  Humidity(GreenHouseConfig& config);
+  Humidity(GreenHouseConfig& config, Clock& clock);
   virtual ~Humidity();
   void begin();
   Humidity_Return_t read() override;
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
+  uint8_t getPrecision() override { return 2; }
   void accept(Visitor<SensorInterface<Humidity_Return_t>>& visitor) override;
 };
 #endif
\ No newline at end of file
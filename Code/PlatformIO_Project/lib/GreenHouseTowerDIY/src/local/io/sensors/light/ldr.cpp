@@ -2,7 +2,8 @@
 
 // TODO: Fix this with a proper implementation of the LDR and lux
 
-LDR::LDR(GreenHouseConfig& config) : config(config), _GAMMA(0.7), _RL10(50) {}
+LDR::LDR(GreenHouseConfig& config, Clock& clock)
+    : config(config), _clock(clock), _GAMMA(0.7), _RL10(50) {}
 
 LDR::~LDR() {}
 
@@ -56,7 +57,6 @@ float LDR::read() {
       char buffer[100];
       dtostrf(lux, 10, 3, buffer);
       log_i("%s\n", buffer);
-      Network_Utilities::my_delay(0.1L);
     } break;
     case GreenHouseConfig::LDRFeatures_t::BH1750: {
       if (!BH1750_sensor.hasValue())
@@ -71,9 +71,8 @@ float LDR::read() {
   return lux;
 }
 
-const std::string& LDR::getSensorName() {
-  static std::string name = "ldr";
-  return name;
+std::string_view LDR::getSensorName() {
+  return "ldr";
 }
 
 void LDR::accept(Visitor<SensorInterface<float>>& visitor) {
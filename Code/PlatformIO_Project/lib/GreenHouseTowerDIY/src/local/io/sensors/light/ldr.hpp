@@ -3,23 +3,27 @@
 #include <Arduino.h>
 #include <hp_BH1750.h>
 #include <utilities/network_utilities.hpp>
+#include "local/data/clock/clock.hpp"
 #include "local/data/config/config.hpp"
 #include "local/data/visitor.hpp"
+#include "local/io/sensors/drivers.hpp"
 
 #define LDR_PIN 33
 class LDR : public Element<Visitor<SensorInterface<float>>>,
             public SensorInterface<float> {
  public:
-  explicit LDR(GreenHouseConfig& config);
+  LDR(GreenHouseConfig& config, Clock& clock);
   virtual ~LDR();
   void begin();
   float read() override;
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
+  uint8_t getPrecision() override { return 1; }
   void accept(Visitor<SensorInterface<float>>& visitor) override;
 
  private:
   GreenHouseConfig& config;
-  hp_BH1750 BH1750_sensor;  // create the sensor object
+  Clock& _clock;
+  BH1750Driver_t BH1750_sensor;  // create the sensor object
   const float _GAMMA;
   const float _RL10;
 };
@@ -169,9 +169,8 @@ std::vector<float> TowerTemp::read() {
   return temp_sensor_results;
 }
 
-const std::string& TowerTemp::getSensorName() {
-  static std::string name = "temperature";
-  return name;
+std::string_view TowerTemp::getSensorName() {
+  return "temperature";
 }
 
 void TowerTemp::accept(Visitor<SensorInterface<std::vector<float>>>& visitor) {
@@ -11,6 +11,7 @@
 #include <vector>
 #include "local/data/config/config.hpp"
 #include "local/data/visitor.hpp"
+#include "local/io/sensors/drivers.hpp"
 
 using Temp_Array_t = std::vector<float>;
 class TowerTemp : public Element<Visitor<SensorInterface<Temp_Array_t>>>,
@@ -19,7 +20,7 @@ class TowerTemp : public Element<Visitor<SensorInterface<Temp_Array_t>>>,
   // Setup a oneWire instance to communicate with any OneWire devices
   OneWire oneWire;
   // Pass our oneWire reference to Dallas Temperature.
-  DallasTemperature sensors;
+  DS18B20Driver_t sensors;
   // variable to hold device addresses
   DeviceAddress temp_sensor_addresses;
 
@@ -38,7 +39,8 @@ class TowerTemp : public Element<Visitor<SensorInterface<Temp_Array_t>>>,
   int getSensorCount();
 
   std::vector<float> read() override;
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
+  uint8_t getPrecision() override { return 2; }
   void accept(Visitor<SensorInterface<Temp_Array_t>>& visitor) override;
 
   Temp_Array_t temp_sensor_results;
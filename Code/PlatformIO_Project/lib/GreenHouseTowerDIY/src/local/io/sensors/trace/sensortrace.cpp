@@ -0,0 +1,168 @@
+#include "sensortrace.hpp"
+#include <SPIFFS.h>
+
+SensorTrace* SensorTrace::_instance = nullptr;
+
+//* Must follow SensorTrace::Source_e, probes are matched on their prefix
+static const char* const source_names[SensorTrace::DS18B20] = {
+    "sht31_1.temp", "sht31_1.hum", "sht31_2.temp", "sht31_2.hum",
+    "dht.temp",     "dht.hum",     "hcsr04",       "bh1750",
+};
+
+SensorTrace::SensorTrace(Clock& clock)
+    : _clock(clock), _start(0), _line(0), _next(), _pending(false) {
+  for (uint8_t s = 0; s < SOURCE_COUNT; s++) {
+    _seen[s] = false;
+    _valid[s] = false;
+    _values[s] = NAN;
+  }
+}
+
+SensorTrace::~SensorTrace() {
+  if (_file)
+    _file.close();
+}
+
+/**
+ * @brief Open the trace and apply its readings at 0
+ * @note Call before the sensors begin, they probe for their parts then
+ * @return false without a trace, the fake drivers then report every sensor
+ * as missing
+ */
+bool SensorTrace::begin(const char* path) {
+  _instance = this;
+  if (!SPIFFS.begin(false)) {
+    log_e("[Sensor Trace]: Unable to mount SPIFFS");
+    return false;
+  }
+  _file = SPIFFS.open(path, FILE_READ);
+  if (!_file) {
+    log_e("[Sensor Trace]: No trace at %s", path);
+    return false;
+  }
+  _start = _clock.millis();
+  update();
+  log_i("[Sensor Trace]: Replaying %s, %u probe(s)", path, getProbeCount());
+  return true;
+}
+
+/**
+ * @brief Parse one trace line
+ * @return false for comments, blank and malformed lines
+ */
+bool SensorTrace::parse(const char* line, Reading_t& reading) {
+  char* end;
+  unsigned long time = strtoul(line, &end, 10);
+  if (end == line)
+    return false;
+
+  while (*end == ' ' || *end == '\t')
+    end++;
+  const char* name = end;
+  while (*end != '\0' && *end != ' ' && *end != '\t')
+    end++;
+  size_t length = end - name;
+
+  uint8_t source = SOURCE_COUNT;
+  for (uint8_t s = 0; s < DS18B20; s++) {
+    if (strlen(source_names[s]) == length &&
+        strncmp(name, source_names[s], length) == 0)
+      source = s;
+  }
+  if (source == SOURCE_COUNT && length > 8 &&
+      strncmp(name, "ds18b20.", 8) == 0 && isdigit(name[8])) {
+    unsigned long probe = strtoul(name + 8, nullptr, 10);
+    if (probe < SENSOR_TRACE_PROBES)
+      source = DS18B20 + probe;
+  }
+  if (source == SOURCE_COUNT)
+    return false;
+
+  while (*end == ' ' || *end == '\t')
+    end++;
+  reading.time = time;
+  reading.source = source;
+  if (strncmp(end, "err", 3) == 0) {
+    reading.valid = false;
+    reading.value = NAN;
+    return true;
+  }
+  char* last;
+  reading.value = strtof(end, &last);
+  if (last == end)
+    return false;
+  reading.valid = !isnan(reading.value);
+  return true;
+}
+
+//* Next well formed reading of the file into _next
+bool SensorTrace::fetch() {
+  char line[64];
+  while (_file && _file.available()) {
+    size_t length = _file.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+    _line++;
+    if (parse(line, _next))
+      return true;
+
+    const char* text = line;
+    while (isspace(*text))
+      text++;
+    if (*text != '\0' && *text != '#')
+      log_w("[Sensor Trace]: Skipping malformed line %u", _line);
+  }
+  return false;
+}
+
+//* Apply every reading due by now
+void SensorTrace::update() {
+  uint32_t now = elapsed();
+  while (true) {
+    if (!_pending && !(_pending = fetch()))
+      return;
+    if (_next.time > now)
+      return;
+    _seen[_next.source] = true;
+    _valid[_next.source] = _next.valid;
+    _values[_next.source] = _next.value;
+    _pending = false;
+  }
+}
+
+/**
+ * @brief Latest reading of a source
+ * @return false when the source failed or has no reading yet
+ */
+bool SensorTrace::read(uint8_t source, float& value) {
+  update();
+  if (source >= SOURCE_COUNT || !_seen[source] || !_valid[source])
+    return false;
+  value = _values[source];
+  return true;
+}
+
+bool SensorTrace::has(uint8_t source) {
+  update();
+  return source < SOURCE_COUNT && _seen[source];
+}
+
+//* Probes on the bus, up to the highest one the trace mentioned so far
+uint8_t SensorTrace::getProbeCount() {
+  update();
+  uint8_t count = 0;
+  for (uint8_t p = 0; p < SENSOR_TRACE_PROBES; p++) {
+    if (_seen[DS18B20 + p])
+      count = p + 1;
+  }
+  return count;
+}
+
+bool SensorTrace::finished() {
+  update();
+  return !_pending && !(_file && _file.available());
+}
+
+//* Trace time, ms since begin()
+uint32_t SensorTrace::elapsed() {
+  return _clock.millis() - _start;
+}
@@ -0,0 +1,84 @@
+#ifndef SENSORTRACE_HPP
+#define SENSORTRACE_HPP
+#include <Arduino.h>
+#include <FS.h>
+#include "local/data/clock/clock.hpp"
+
+#ifndef SENSOR_TRACE_PATH
+#define SENSOR_TRACE_PATH "/trace.txt"
+#endif  // SENSOR_TRACE_PATH
+
+//* DS18B20 probes a trace can carry
+#ifndef SENSOR_TRACE_PROBES
+#define SENSOR_TRACE_PROBES 8
+#endif  // SENSOR_TRACE_PROBES
+
+/**
+ * @brief Recorded sensor readings played back on a Clock
+ * @note Text, one reading per line: <ms> <source> <value|err>, e.g.
+ *   0 sht31_1.temp 21.53
+ *   60000 hcsr04 err
+ * ms counts from begin(), lines are in time order, # starts a comment.
+ * Sources are sht31_1.temp, sht31_1.hum, sht31_2.temp, sht31_2.hum,
+ * dht.temp, dht.hum, ds18b20.<n>, hcsr04 and bh1750, values are in the
+ * driver's own unit (°C, %RH, cm, lx). err makes the driver fail the way
+ * the real part does.
+ * @note The file is streamed, a reading holds until the next one for the
+ * same source, so a week long trace costs no more RAM than a short one. A
+ * sensor counts as present when the trace has a reading for it at 0.
+ */
+class SensorTrace {
+ public:
+  enum Source_e : uint8_t {
+    SHT31_1_TEMP,
+    SHT31_1_HUM,
+    SHT31_2_TEMP,
+    SHT31_2_HUM,
+    DHT_TEMP,
+    DHT_HUM,
+    HCSR04,
+    BH1750,
+    DS18B20,  // probe n is DS18B20 + n
+    SOURCE_COUNT = DS18B20 + SENSOR_TRACE_PROBES
+  };
+
+  struct Reading_t {
+    uint32_t time;  // ms since the start of the trace
+    uint8_t source;
+    bool valid;
+    float value;
+  };
+
+ private:
+  static SensorTrace* _instance;
+
+  Clock& _clock;
+  File _file;
+  uint32_t _start;
+  uint32_t _line;
+  Reading_t _next;
+  bool _pending;
+  bool _seen[SOURCE_COUNT];
+  bool _valid[SOURCE_COUNT];
+  float _values[SOURCE_COUNT];
+
+  bool fetch();
+  void update();
+
+ public:
+  explicit SensorTrace(Clock& clock);
+  virtual ~SensorTrace();
+
+  bool begin(const char* path = SENSOR_TRACE_PATH);
+  bool read(uint8_t source, float& value);
+  bool has(uint8_t source);
+  uint8_t getProbeCount();
+  bool finished();
+  uint32_t elapsed();
+
+  static bool parse(const char* line, Reading_t& reading);
+  //* Trace the fake drivers read from, nullptr until begin()
+  static SensorTrace* get() { return _instance; }
+};
+
+#endif  // SENSORTRACE_HPP
@@ -0,0 +1,132 @@
+#include "tracedrivers.hpp"
+
+//* Latest reading of a source, false without a trace
+static bool traceRead(uint8_t source, float& value) {
+  SensorTrace* trace = SensorTrace::get();
+  return trace && trace->read(source, value);
+}
+
+static bool traceHas(uint8_t source) {
+  SensorTrace* trace = SensorTrace::get();
+  return trace && trace->has(source);
+}
+
+//***********************************************************************************************************************
+
+TraceSHT31::TraceSHT31()
+    : _temp(SensorTrace::SHT31_1_TEMP),
+      _hum(SensorTrace::SHT31_1_HUM),
+      _heater(false) {}
+
+bool TraceSHT31::begin(uint8_t address) {
+  bool second = address == 0x45;
+  _temp = second ? SensorTrace::SHT31_2_TEMP : SensorTrace::SHT31_1_TEMP;
+  _hum = second ? SensorTrace::SHT31_2_HUM : SensorTrace::SHT31_1_HUM;
+  return traceHas(_temp) || traceHas(_hum);
+}
+
+float TraceSHT31::readTemperature() {
+  float value;
+  return traceRead(_temp, value) ? value : NAN;
+}
+
+float TraceSHT31::readHumidity() {
+  float value;
+  return traceRead(_hum, value) ? value : NAN;
+}
+
+//***********************************************************************************************************************
+
+TraceDHT::TraceDHT(uint8_t pin, uint8_t type) : _type(type) {}
+
+TraceDHT::Channel::Channel(SensorTrace::Source_e source, uint8_t type)
+    : _source(source), _type(type) {}
+
+bool TraceDHT::Channel::getEvent(sensors_event_t* event) {
+  memset(event, 0, sizeof(sensors_event_t));
+  event->version = sizeof(sensors_event_t);
+  event->timestamp = millis();
+  float value;
+  bool ok = traceRead(_source, value);
+  if (_source == SensorTrace::DHT_TEMP) {
+    event->type = SENSOR_TYPE_AMBIENT_TEMPERATURE;
+    event->temperature = ok ? value : NAN;
+  } else {
+    event->type = SENSOR_TYPE_RELATIVE_HUMIDITY;
+    event->relative_humidity = ok ? value : NAN;
+  }
+  return true;
+}
+
+//* Same limits as the DHT library, min_delay drives the read spacing
+void TraceDHT::Channel::getSensor(sensor_t* sensor) {
+  memset(sensor, 0, sizeof(sensor_t));
+  strncpy(sensor->name, "Trace DHT", sizeof(sensor->name) - 1);
+  sensor->version = 1;
+  bool temp = _source == SensorTrace::DHT_TEMP;
+  sensor->type =
+      temp ? SENSOR_TYPE_AMBIENT_TEMPERATURE : SENSOR_TYPE_RELATIVE_HUMIDITY;
+  sensor->min_value = temp ? -40.0 : 0.0;
+  sensor->max_value = temp ? 80.0 : 100.0;
+  sensor->resolution = 0.1;
+  sensor->min_delay = _type == 11 ? 1000000L : 2000000L;
+}
+
+//***********************************************************************************************************************
+
+uint8_t TraceDallas::getDeviceCount() {
+  SensorTrace* trace = SensorTrace::get();
+  return trace ? trace->getProbeCount() : 0;
+}
+
+bool TraceDallas::getAddress(uint8_t* address, uint8_t index) {
+  if (index >= getDeviceCount())
+    return false;
+  memset(address, 0, 8);
+  address[0] = 0x28;  // DS18B20 family code
+  address[1] = index;
+  return true;
+}
+
+float TraceDallas::getTempC(const uint8_t* address) {
+  return getTempCByIndex(address[1]);
+}
+
+float TraceDallas::getTempCByIndex(uint8_t index) {
+  float value;
+  if (index >= SENSOR_TRACE_PROBES ||
+      !traceRead(SensorTrace::DS18B20 + index, value))
+    return DEVICE_DISCONNECTED_C;
+  return value;
+}
+
+//***********************************************************************************************************************
+
+double TraceUltrasonic::measureDistanceCm() {
+  float value;
+  return traceRead(SensorTrace::HCSR04, value) ? value : -1.0;
+}
+
+//* The trace holds the compensated distance already
+double TraceUltrasonic::measureDistanceCm(float temperature) {
+  return measureDistanceCm();
+}
+
+//***********************************************************************************************************************
+
+TraceBH1750::TraceBH1750() : _started(false) {}
+
+bool TraceBH1750::begin(uint8_t address) {
+  return traceHas(SensorTrace::BH1750);
+}
+
+bool TraceBH1750::hasValue() {
+  float value;
+  return _started && traceRead(SensorTrace::BH1750, value);
+}
+
+float TraceBH1750::getLux() {
+  float value;
+  _started = false;
+  return traceRead(SensorTrace::BH1750, value) ? value : 0;
+}
@@ -0,0 +1,84 @@
+#ifndef TRACEDRIVERS_HPP
+#define TRACEDRIVERS_HPP
+#include <Adafruit_Sensor.h>
+#include <Arduino.h>
+#include <DallasTemperature.h>
+#include "local/io/sensors/trace/sensortrace.hpp"
+
+/**
+ * @brief Stand-ins for the sensor libraries, fed by the SensorTrace
+ * @note Each one mirrors the part of its library's API the sensor classes
+ * use, and fails the way the part does: NaN for the SHT31 and DHT, -127 °C
+ * for a DS18B20, -1 cm for the HC-SR04, no value for the BH1750.
+ */
+
+//* Adafruit_SHT31, 0x44 is the first sensor, 0x45 the second
+class TraceSHT31 {
+  SensorTrace::Source_e _temp;
+  SensorTrace::Source_e _hum;
+  bool _heater;
+
+ public:
+  TraceSHT31();
+  bool begin(uint8_t address);
+  float readTemperature();
+  float readHumidity();
+  bool isHeaterEnabled() { return _heater; }
+  void heater(bool enabled) { _heater = enabled; }
+};
+
+//* DHT_Unified
+class TraceDHT {
+  uint8_t _type;
+
+ public:
+  class Channel {
+    SensorTrace::Source_e _source;
+    uint8_t _type;
+
+   public:
+    Channel(SensorTrace::Source_e source, uint8_t type);
+    bool getEvent(sensors_event_t* event);
+    void getSensor(sensor_t* sensor);
+  };
+
+  TraceDHT(uint8_t pin, uint8_t type);
+  void begin() {}
+  Channel temperature() { return Channel(SensorTrace::DHT_TEMP, _type); }
+  Channel humidity() { return Channel(SensorTrace::DHT_HUM, _type); }
+};
+
+//* DallasTemperature, probe n answers on the address {0x28, n, 0, ...}
+class TraceDallas {
+ public:
+  explicit TraceDallas(OneWire* oneWire) {}
+  void begin() {}
+  uint8_t getDeviceCount();
+  void requestTemperatures() {}
+  bool getAddress(uint8_t* address, uint8_t index);
+  float getTempC(const uint8_t* address);
+  float getTempCByIndex(uint8_t index);
+};
+
+//* UltraSonicDistanceSensor
+class TraceUltrasonic {
+ public:
+  TraceUltrasonic(uint8_t trigger, uint8_t echo) {}
+  double measureDistanceCm();
+  double measureDistanceCm(float temperature);
+};
+
+//* hp_BH1750, every start() makes the current reading available
+class TraceBH1750 {
+  bool _started;
+
+ public:
+  TraceBH1750();
+  bool begin(uint8_t address);
+  void calibrateTiming() {}
+  void start() { _started = true; }
+  bool hasValue();
+  float getLux();
+};
+
+#endif  // TRACEDRIVERS_HPP
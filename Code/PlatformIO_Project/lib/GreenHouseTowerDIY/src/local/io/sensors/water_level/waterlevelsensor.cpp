@@ -10,15 +10,16 @@
 // TODO: Add set method for radius  and height
 // TODO: Migrate this to a pressure sensor
 
-WaterLevelSensor::WaterLevelSensor(TowerTemp& _towerTemp)
+WaterLevelSensor::WaterLevelSensor(TowerTemp& _towerTemp, Clock& clock)
     : _radius(),
       _height(),
       _towerTemp(_towerTemp),
+      _clock(clock),
       _distanceSensor(TRIG_PIN, ECHO_PIN) {}
 WaterLevelSensor::~WaterLevelSensor() {}
 
 double WaterLevelSensor::readSensor() {
-  Network_Utilities::my_delay(1L);
+  _clock.delay(5);
   double distance =
       _distanceSensor.measureDistanceCm(_towerTemp.temp_sensor_results[0]);
   log_d("[WaterLevelSensor]: Distance: %.3f cm", distance, DEC);
@@ -60,9 +61,8 @@ double WaterLevelSensor::volume() {
   return v;
 }
 
-const std::string& WaterLevelSensor::getSensorName() {
-  static const std::string name = "water_level_sensor";
-  return name;
+std::string_view WaterLevelSensor::getSensorName() {
+  return "water_level_sensor";
 }
 
 void WaterLevelSensor::accept(Visitor<SensorInterface<float>>& visitor) {
@@ -87,9 +87,8 @@ float WaterLevelPercentage::read() {
   return percentage;
 }
 
-const std::string& WaterLevelPercentage::getSensorName() {
-  static const std::string name = "water_level_percentage";
-  return name;
+std::string_view WaterLevelPercentage::getSensorName() {
+  return "water_level_percentage";
 }
 
 void WaterLevelPercentage::accept(Visitor<SensorInterface<float>>& visitor) {
@@ -9,7 +9,9 @@
 #include <functional>
 
 #include <utilities/network_utilities.hpp>
+#include "local/data/clock/clock.hpp"
 #include "local/data/visitor.hpp"
+#include "local/io/sensors/drivers.hpp"
 #include "local/io/sensors/temperature/towertemp.hpp"
 
 class WaterLevelSensor : public Element<Visitor<SensorInterface<float>>>,
@@ -18,19 +20,21 @@ class WaterLevelSensor : public Element<Visitor<SensorInterface<float>>>,
   double _radius;
   double _height;
   TowerTemp& _towerTemp;
-  UltraSonicDistanceSensor _distanceSensor;
+  Clock& _clock;
+  UltrasonicDriver_t _distanceSensor;
   //* Private functions
   double readSensor();
 
  public:
   //* Constructor
-  WaterLevelSensor(TowerTemp& _towerTemp);
+  WaterLevelSensor(TowerTemp& _towerTemp, Clock& clock);
   virtual ~WaterLevelSensor();
   double volume();
   //* Read the water level
   float read() override;
   //* Accept the visitor
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
+  uint8_t getPrecision() override { return 1; }
   void accept(Visitor<SensorInterface<float>>& visitor) override;
 };
 
@@ -41,7 +45,8 @@ class WaterLevelPercentage : public Element<Visitor<SensorInterface<float>>>,
  public:
   WaterLevelPercentage(WaterLevelSensor& waterLevelSensor);
   float read() override;
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
+  uint8_t getPrecision() override { return 1; }
   void accept(Visitor<SensorInterface<float>>& visitor) override;
 };
 
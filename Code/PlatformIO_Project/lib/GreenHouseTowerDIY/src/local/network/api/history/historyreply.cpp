@@ -0,0 +1,99 @@
+#include "historyreply.hpp"
+
+HistoryReply::HistoryReply(Telemetry::Channel_e channel,
+                           uint32_t resolution,
+                           Downsample::Method_e method)
+    : _channel(channel),
+      _resolution(resolution),
+      _method(method),
+      _stage(HEADER),
+      _next(0),
+      _pendingLength(0),
+      _pendingIndex(0) {}
+
+/**
+ * @brief Read the range out of the store and downsample it
+ * @note The source points only live for the duration of this call
+ * @return the number of points that will be sent
+ */
+size_t HistoryReply::build(HistoryStore& history,
+                         History::Resolution_e resolution,
+                         uint32_t from,
+                         uint32_t to,
+                         size_t threshold) {
+  size_t available = history.count(_channel, resolution, from, to);
+  std::vector<History::Point_t> source(available);
+  size_t read = history.query(_channel, resolution, from, to, source.data(),
+                              source.size());
+
+  _points.resize(std::min(read, threshold));
+  size_t kept =
+      Downsample::run(_method, source.data(), read, _points.data(), threshold);
+  _points.resize(kept);
+  log_d("[History Reply]: %s %u points down to %u",
+        Telemetry::channelName(_channel), read, kept);
+  return kept;
+}
+
+//* Render the next piece of the body into the pending buffer
+bool HistoryReply::format() {
+  int length = 0;
+  switch (_stage) {
+    case HEADER:
+      length = snprintf(
+          _pending, sizeof(_pending),
+          "{\"channel\":\"%s\",\"resolution\":%u,\"method\":\"%s\","
+          "\"points\":[",
+          Telemetry::channelName(_channel), _resolution,
+          Downsample::methodName(_method));
+      _stage = _points.empty() ? FOOTER : POINTS;
+      break;
+    case POINTS: {
+      const Downsample::Point_t& p = _points[_next];
+      length = snprintf(_pending, sizeof(_pending), "%s[%u,",
+                        _next == 0 ? "" : ",", p.timestamp);
+      size_t value = FloatFormat::format(
+          p.value, Telemetry::channelPrecision(_channel), _pending + length,
+          sizeof(_pending) - length - 1);
+      //* Keep the pair valid JSON even if the value did not fit
+      if (value == 0)
+        value = snprintf(_pending + length, sizeof(_pending) - length - 1,
+                         "null");
+      length += value;
+      _pending[length++] = ']';
+      _pending[length] = '\0';
+      if (++_next == _points.size())
+        _stage = FOOTER;
+      break;
+    }
+    case FOOTER:
+      length = snprintf(_pending, sizeof(_pending), "]}");
+      _stage = DONE;
+      break;
+    case DONE:
+    default:
+      return false;
+  }
+  _pendingLength = std::min(static_cast<size_t>(std::max(length, 0)),
+                            sizeof(_pending) - 1);
+  _pendingIndex = 0;
+  return true;
+}
+
+/**
+ * @brief Chunked response filler
+ * @note Copies as much as fits, a point that straddles two chunks is carried
+ * over in the pending buffer. Returns 0 once the body is complete.
+ */
+size_t HistoryReply::fill(uint8_t* buffer, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen) {
+    if (_pendingIndex == _pendingLength && !format())
+      break;
+    size_t chunk = std::min(maxLen - written, _pendingLength - _pendingIndex);
+    memcpy(buffer + written, _pending + _pendingIndex, chunk);
+    _pendingIndex += chunk;
+    written += chunk;
+  }
+  return written;
+}
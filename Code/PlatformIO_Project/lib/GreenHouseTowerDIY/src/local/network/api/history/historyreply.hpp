@@ -0,0 +1,56 @@
+#ifndef HISTORYREPLY_HPP
+#define HISTORYREPLY_HPP
+#include <Arduino.h>
+#include <vector>
+#include <local/Serializers/FloatFormat/floatformat.hpp>
+#include <local/data/history/downsample.hpp>
+#include <local/data/telemetry/telemetry.hpp>
+
+//* Upper bound on the points a client may ask for
+#ifndef HISTORY_MAX_POINTS
+#define HISTORY_MAX_POINTS 1000
+#endif  // HISTORY_MAX_POINTS
+
+/**
+ * @brief Body of a downsampled history query, serialized on demand
+ * @note Only the downsampled points are kept, the JSON text is produced one
+ * point at a time from inside the chunked response filler so the body never
+ * exists in RAM as a whole:
+ *
+ *   {"channel":"<name>","resolution":<s>,"method":"<m>","points":[[t,v],...]}
+ */
+class HistoryReply {
+  enum Stage_e : uint8_t {
+    HEADER,
+    POINTS,
+    FOOTER,
+    DONE,
+  };
+
+  Telemetry::Channel_e _channel;
+  uint32_t _resolution;
+  Downsample::Method_e _method;
+  std::vector<Downsample::Point_t> _points;
+  Stage_e _stage;
+  size_t _next;
+  char _pending[128];
+  size_t _pendingLength;
+  size_t _pendingIndex;
+
+  bool format();
+
+ public:
+  HistoryReply(Telemetry::Channel_e channel,
+               uint32_t resolution,
+               Downsample::Method_e method);
+
+  size_t build(HistoryStore& history,
+             History::Resolution_e resolution,
+             uint32_t from,
+             uint32_t to,
+             size_t threshold);
+  size_t fill(uint8_t* buffer, size_t maxLen);
+  size_t getPointCount() const { return _points.size(); }
+};
+
+#endif
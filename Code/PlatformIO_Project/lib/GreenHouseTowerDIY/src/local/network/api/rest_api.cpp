@@ -1,9 +1,15 @@
 #include "rest_api.hpp"
 
-RestAPI::RestAPI(ProjectConfig& projectConfig, GreenHouseConfig& configManager)
+RestAPI::RestAPI(ProjectConfig& projectConfig,
+                 GreenHouseConfig& configManager,
+                 DataSnapshot& snapshot,
+                 HistoryStore& history)
     : projectConfig(projectConfig),
       configManager(configManager),
-      server(80, projectConfig, "/control", "/wifimanager", "/tower") {}
+      snapshot(snapshot),
+      history(history),
+      server(80, projectConfig, "/control", "/wifimanager", "/tower"),
+      stream(snapshot, "/tower/stream") {}
 
 RestAPI::~RestAPI() {}
 
@@ -44,9 +50,29 @@ void RestAPI::setupServer() {
     this->setDHT(request);
   });
 
+  server.addAPICommand("/data", [this](AsyncWebServerRequest* request) {
+    this->getData(request);
+  });
+
+  server.addAPICommand("/history", [this](AsyncWebServerRequest* request) {
+    this->getHistory(request);
+  });
+
+  server.addAPICommand(
+      "/historyExport", [this](AsyncWebServerRequest* request) {
+        this->exportHistory(request);
+      });
+
+  //* Live telemetry over websocket
+  stream.begin(server.server);
+
   server.begin();
 }
 
+void RestAPI::loop() {
+  stream.loop();
+}
+
 void RestAPI::setDHT(AsyncWebServerRequest* request) {
   switch (server._networkMethodsMap_enum[request->method()]) {
     case APIServer::POST: {
@@ -82,3 +108,279 @@ void RestAPI::setDHT(AsyncWebServerRequest* request) {
     }
   }
 }
+
+/**
+ * @brief If-None-Match against the tag of the representation being sent
+ * @note The header is "*" or a comma separated list of tags, each possibly
+ * W/ prefixed. If-None-Match uses the weak comparison, so the prefix is
+ * ignored.
+ */
+static bool etagMatches(AsyncWebServerRequest* request, const char* etag) {
+  if (!request->hasHeader("If-None-Match"))
+    return false;
+  const char* p = request->getHeader("If-None-Match")->value().c_str();
+  size_t length = strlen(etag);
+  while (*p != '\0') {
+    while (*p == ' ' || *p == '\t' || *p == ',')
+      p++;
+    if (*p == '*')
+      return true;
+    if (strncmp(p, "W/", 2) == 0)
+      p += 2;
+    const char* start = p;
+    if (*p == '"') {
+      const char* end = strchr(p + 1, '"');
+      if (end == nullptr)
+        return false;
+      p = end + 1;
+    }
+    if ((size_t)(p - start) == length && memcmp(start, etag, length) == 0)
+      return true;
+    while (*p != '\0' && *p != ',')
+      p++;
+  }
+  return false;
+}
+
+/**
+ * @brief Serve the latest data document
+ * @note The body is the cached snapshot of the last acquisition cycle, so
+ * polling is cheap. Clients that send back the ETag get a 304 until the next
+ * cycle, clients that accept gzip get the copy compressed at update time.
+ * The gzip copy has its own tag, a strong tag names one exact byte sequence.
+ * @note Clients asking for application/cbor, or passing format=cbor, get the
+ * binary form of the cycle described in local/data/codec/cbor.hpp
+ */
+void RestAPI::getData(AsyncWebServerRequest* request) {
+  switch (server._networkMethodsMap_enum[request->method()]) {
+    case APIServer::GET: {
+      DataSnapshot::Body_t body = snapshot.get();
+      if (body->sequence == 0) {
+        request->send(503, APIServer::MIMETYPE_JSON,
+                      "{\"msg\":\"No data available yet\"}");
+        return;
+      }
+
+      bool cbor =
+          (request->hasParam("format") &&
+           request->getParam("format")->value() == "cbor") ||
+          (request->hasHeader("Accept") &&
+           request->getHeader("Accept")->value().indexOf("application/cbor") >=
+               0);
+      if (cbor) {
+        sendCbor(request, body);
+        return;
+      }
+
+      bool gzip = !body->gzip.empty() && request->hasHeader("Accept-Encoding") &&
+                  request->getHeader("Accept-Encoding")->value().indexOf(
+                      "gzip") >= 0;
+      const char* etag = gzip ? body->etagGzip : body->etag;
+
+      if (etagMatches(request, etag)) {
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Vary", "Accept, Accept-Encoding");
+        request->send(response);
+        return;
+      }
+
+      //* Stream straight out of the shared body, no per request copy
+      const uint8_t* data =
+          gzip ? body->gzip.data()
+               : reinterpret_cast<const uint8_t*>(body->json.data());
+      size_t length = gzip ? body->gzip.size() : body->json.size();
+      AsyncWebServerResponse* response = request->beginResponse(
+          APIServer::MIMETYPE_JSON, length,
+          [body, data, length](uint8_t* buffer, size_t maxLen,
+                               size_t index) -> size_t {
+            size_t chunk = std::min(maxLen, length - index);
+            memcpy(buffer, data + index, chunk);
+            return chunk;
+          });
+      response->addHeader("ETag", etag);
+      response->addHeader("Cache-Control", "no-cache");
+      response->addHeader("Vary", "Accept, Accept-Encoding");
+      if (gzip)
+        response->addHeader("Content-Encoding", "gzip");
+      request->send(response);
+      break;
+    }
+    default: {
+      request->send(400, APIServer::MIMETYPE_JSON,
+                    "{\"msg\":\"Invalid Request\"}");
+      break;
+    }
+  }
+}
+
+//* Binary form of the latest cycle, tagged apart from the JSON one
+void RestAPI::sendCbor(AsyncWebServerRequest* request,
+                       const DataSnapshot::Body_t& body) {
+  if (body->cbor.empty()) {
+    request->send(503, APIServer::MIMETYPE_JSON,
+                  "{\"msg\":\"No data available yet\"}");
+    return;
+  }
+
+  const char* etag = body->etagCbor;
+  if (etagMatches(request, etag)) {
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Vary", "Accept");
+    request->send(response);
+    return;
+  }
+
+  const uint8_t* data = body->cbor.data();
+  size_t length = body->cbor.size();
+  AsyncWebServerResponse* response = request->beginResponse(
+      "application/cbor", length,
+      [body, data, length](uint8_t* buffer, size_t maxLen,
+                           size_t index) -> size_t {
+        size_t chunk = std::min(maxLen, length - index);
+        memcpy(buffer, data + index, chunk);
+        return chunk;
+      });
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  response->addHeader("Vary", "Accept");
+  request->send(response);
+}
+
+/**
+ * @brief Bulk export of one channel as a Gorilla compressed stream
+ * @note Params: channel (name), from and to (epoch seconds, default the whole
+ * store) and resolution (raw, 5m or 1h, default the finest one covering from)
+ */
+void RestAPI::exportHistory(AsyncWebServerRequest* request) {
+  switch (server._networkMethodsMap_enum[request->method()]) {
+    case APIServer::GET: {
+      if (!request->hasParam("channel")) {
+        request->send(400, APIServer::MIMETYPE_JSON,
+                      "{\"msg\":\"Missing channel\"}");
+        return;
+      }
+      Telemetry::Channel_e channel = Telemetry::channelFromName(
+          request->getParam("channel")->value().c_str(),
+          request->getParam("channel")->value().length());
+      if (channel == Telemetry::CHANNEL_COUNT) {
+        request->send(404, APIServer::MIMETYPE_JSON,
+                      "{\"msg\":\"Unknown channel\"}");
+        return;
+      }
+
+      uint32_t from = request->hasParam("from")
+                          ? strtoul(request->getParam("from")->value().c_str(),
+                                    nullptr, 10)
+                          : 0;
+      uint32_t to = request->hasParam("to")
+                        ? strtoul(request->getParam("to")->value().c_str(),
+                                  nullptr, 10)
+                        : UINT32_MAX;
+
+      History::Resolution_e resolution = history.resolutionFor(from);
+      if (request->hasParam("resolution")) {
+        const String& value = request->getParam("resolution")->value();
+        if (value == "raw")
+          resolution = History::RAW;
+        else if (value == "5m")
+          resolution = History::FIVE_MINUTES;
+        else if (value == "1h")
+          resolution = History::ONE_HOUR;
+      }
+
+      size_t points = history.count(channel, resolution, from, to);
+      std::shared_ptr<std::vector<uint8_t>> body =
+          std::make_shared<std::vector<uint8_t>>(
+              GorillaEncoder::maxSize(points));
+      GorillaEncoder encoder(body->data(), body->size());
+      history.encode(channel, resolution, from, to, encoder);
+      body->resize(encoder.finish());
+
+      AsyncWebServerResponse* response = request->beginResponse(
+          "application/octet-stream", body->size(),
+          [body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t chunk = std::min(maxLen, body->size() - index);
+            memcpy(buffer, body->data() + index, chunk);
+            return chunk;
+          });
+      response->addHeader("X-Points", String(encoder.getCount()));
+      response->addHeader("X-Resolution",
+                          String(history.getPeriod(resolution)));
+      request->send(response);
+      break;
+    }
+    default: {
+      request->send(400, APIServer::MIMETYPE_JSON,
+                    "{\"msg\":\"Invalid Request\"}");
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Downsampled history of one channel for charting
+ * @note Params: channel (name), from and to (epoch seconds, default the whole
+ * store), points (target count, default 200) and method (lttb or minmax,
+ * default lttb). The resolution is the finest one covering from. The body is
+ * streamed as a chunked response.
+ */
+void RestAPI::getHistory(AsyncWebServerRequest* request) {
+  switch (server._networkMethodsMap_enum[request->method()]) {
+    case APIServer::GET: {
+      if (!request->hasParam("channel")) {
+        request->send(400, APIServer::MIMETYPE_JSON,
+                      "{\"msg\":\"Missing channel\"}");
+        return;
+      }
+      const String& name = request->getParam("channel")->value();
+      Telemetry::Channel_e channel =
+          Telemetry::channelFromName(name.c_str(), name.length());
+      if (channel == Telemetry::CHANNEL_COUNT) {
+        request->send(404, APIServer::MIMETYPE_JSON,
+                      "{\"msg\":\"Unknown channel\"}");
+        return;
+      }
+
+      uint32_t from = request->hasParam("from")
+                          ? strtoul(request->getParam("from")->value().c_str(),
+                                    nullptr, 10)
+                          : 0;
+      uint32_t to = request->hasParam("to")
+                        ? strtoul(request->getParam("to")->value().c_str(),
+                                  nullptr, 10)
+                        : UINT32_MAX;
+      size_t points =
+          request->hasParam("points")
+              ? strtoul(request->getParam("points")->value().c_str(), nullptr,
+                        10)
+              : 200;
+      points = std::max<size_t>(3, std::min<size_t>(points, HISTORY_MAX_POINTS));
+      Downsample::Method_e method =
+          request->hasParam("method") &&
+                  request->getParam("method")->value() == "minmax"
+              ? Downsample::MIN_MAX
+              : Downsample::LTTB;
+
+      History::Resolution_e resolution = history.resolutionFor(from);
+      std::shared_ptr<HistoryReply> reply = std::make_shared<HistoryReply>(
+          channel, history.getPeriod(resolution), method);
+      reply->build(history, resolution, from, to, points);
+
+      AsyncWebServerResponse* response = request->beginChunkedResponse(
+          APIServer::MIMETYPE_JSON,
+          [reply](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return reply->fill(buffer, maxLen);
+          });
+      response->addHeader("Cache-Control", "no-cache");
+      request->send(response);
+      break;
+    }
+    default: {
+      request->send(400, APIServer::MIMETYPE_JSON,
+                    "{\"msg\":\"Invalid Request\"}");
+      break;
+    }
+  }
+}
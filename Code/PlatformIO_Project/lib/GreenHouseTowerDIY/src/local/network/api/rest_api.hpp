@@ -3,19 +3,35 @@
 #include <EasyNetworkManager.hpp>
 #include <data/statemanager/state_manager.hpp>
 #include <local/data/config/config.hpp>
+#include <local/data/history/historystore.hpp>
+#include <local/data/snapshot/datasnapshot.hpp>
+#include <local/network/api/history/historyreply.hpp>
+#include <local/network/api/stream/telemetrystream.hpp>
 class RestAPI {
  private:
   APIServer server;
   ProjectConfig& projectConfig;
   GreenHouseConfig& configManager;
+  DataSnapshot& snapshot;
+  HistoryStore& history;
+  TelemetryStream stream;
   void setupServer();
 
  public:
-  RestAPI(ProjectConfig& projectConfig, GreenHouseConfig& configManager);
+  RestAPI(ProjectConfig& projectConfig,
+          GreenHouseConfig& configManager,
+          DataSnapshot& snapshot,
+          HistoryStore& history);
   virtual ~RestAPI();
   void begin();
+  void loop();
   void setTopic(AsyncWebServerRequest* request);
   void setDHT(AsyncWebServerRequest* request);
+  void getData(AsyncWebServerRequest* request);
+  void sendCbor(AsyncWebServerRequest* request,
+                const DataSnapshot::Body_t& body);
+  void exportHistory(AsyncWebServerRequest* request);
+  void getHistory(AsyncWebServerRequest* request);
 };
 
 #endif  // API_HPP
\ No newline at end of file
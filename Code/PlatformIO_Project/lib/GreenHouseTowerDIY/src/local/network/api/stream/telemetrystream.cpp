@@ -0,0 +1,174 @@
+#include "telemetrystream.hpp"
+
+TelemetryStream::TelemetryStream(DataSnapshot& snapshot, const char* url)
+    : _ws(url),
+      _snapshot(snapshot),
+      _frames{},
+      _latest(0),
+      _framed(0),
+      _seedRequested(false),
+      _dropped(0) {}
+
+TelemetryStream::~TelemetryStream() {
+  for (auto& frame : _frames) {
+    if (frame.buffer != nullptr)
+      frame.buffer->unlock();
+  }
+}
+
+void TelemetryStream::begin(AsyncWebServer& server) {
+  _ws.onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client,
+                     AwsEventType type, void* arg, uint8_t* data,
+                     size_t len) {
+    this->onEvent(server, client, type, arg, data, len);
+  });
+  server.addHandler(&_ws);
+
+  _snapshot.onUpdate(
+      [this](const DataSnapshot::Body_t& body) { this->publish(body); });
+  log_i("[Telemetry Stream]: Listening on %s", _ws.url());
+}
+
+/**
+ * @brief Service the stream from the main loop
+ * @note Seeds new clients, drains the per client backlog as the socket
+ * queues free up and reaps closed clients. The only place frames are sent
+ * from, publish() and the socket events just move the ring and the cursors.
+ * @note Frames that left the ring stay in the socket's buffer list until
+ * _cleanBuffers() frees the ones no client still holds
+ */
+void TelemetryStream::loop() {
+  _ws.cleanupClients();
+  seed();
+  pump();
+  _ws._cleanBuffers();
+}
+
+size_t TelemetryStream::getClientCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _cursors.size();
+}
+
+uint32_t TelemetryStream::getDroppedFrames() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _dropped;
+}
+
+/**
+ * @brief Encode a snapshot into the shared frame ring
+ * @note The frame is built once, every client is sent the same buffer by the
+ * next loop()
+ */
+void TelemetryStream::publish(const DataSnapshot::Body_t& body) {
+  if (_ws.count() == 0) {
+    return;
+  }
+
+  static const char* fmt = "{\"seq\":%u,\"data\":%s}";
+  int length = snprintf(nullptr, 0, fmt, body->sequence, body->json.c_str());
+  AsyncWebSocketMessageBuffer* buffer = _ws.makeBuffer(length);
+  if (buffer == nullptr) {
+    log_e("[Telemetry Stream]: Unable to allocate a frame");
+    return;
+  }
+  snprintf(reinterpret_cast<char*>(buffer->get()), length + 1, fmt,
+           body->sequence, body->json.c_str());
+  buffer->lock();
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _latest++;
+    _framed = body->sequence;
+    Frame_t& slot = _frames[_latest % STREAM_QUEUE_DEPTH];
+    if (slot.buffer != nullptr)
+      slot.buffer->unlock();
+    slot.buffer = buffer;
+    slot.sequence = _latest;
+  }
+}
+
+/**
+ * @brief Start new clients at the current snapshot
+ * @note Nothing is framed while no client is connected, so the ring can be
+ * hours old when one arrives. The current snapshot is framed first unless
+ * the latest frame already holds it.
+ */
+void TelemetryStream::seed() {
+  if (!_seedRequested.exchange(false))
+    return;
+
+  DataSnapshot::Body_t body = _snapshot.get();
+  bool stale;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    stale = body && (_latest == 0 || _framed != body->sequence);
+  }
+  if (stale)
+    publish(body);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& cursor : _cursors) {
+    if (cursor.second == 0)
+      cursor.second = _latest == 0 ? 1 : _latest;
+  }
+}
+
+/**
+ * @brief Move every client cursor forward as far as its socket allows
+ */
+void TelemetryStream::pump() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_latest == 0)
+    return;
+
+  uint32_t oldest =
+      _latest >= STREAM_QUEUE_DEPTH ? _latest - STREAM_QUEUE_DEPTH + 1 : 1;
+
+  for (auto& cursor : _cursors) {
+    AsyncWebSocketClient* client = _ws.client(cursor.first);
+    if (cursor.second == 0 || client == nullptr ||
+        client->status() != WS_CONNECTED)
+      continue;
+
+    //* Slow consumer - drop the frames that fell out of the ring
+    if (cursor.second < oldest) {
+      _dropped += oldest - cursor.second;
+      log_d("[Telemetry Stream]: Client %u dropped %u frames", cursor.first,
+            oldest - cursor.second);
+      cursor.second = oldest;
+    }
+
+    while (cursor.second <= _latest && client->canSend()) {
+      client->text(_frames[cursor.second % STREAM_QUEUE_DEPTH].buffer);
+      cursor.second++;
+    }
+  }
+}
+
+void TelemetryStream::onEvent(AsyncWebSocket* server,
+                              AsyncWebSocketClient* client,
+                              AwsEventType type,
+                              void* arg,
+                              uint8_t* data,
+                              size_t len) {
+  switch (type) {
+    case WS_EVT_CONNECT: {
+      {
+        //* New subscribers start with the current snapshot, see seed()
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cursors[client->id()] = 0;
+      }
+      _seedRequested = true;
+      log_i("[Telemetry Stream]: Client %u connected", client->id());
+      break;
+    }
+    case WS_EVT_DISCONNECT: {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cursors.erase(client->id());
+      log_i("[Telemetry Stream]: Client %u disconnected", client->id());
+      break;
+    }
+    default:
+      break;
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef TELEMETRYSTREAM_HPP
+#define TELEMETRYSTREAM_HPP
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <local/data/snapshot/datasnapshot.hpp>
+
+/**
+ * @brief Live telemetry push channel
+ * @note Every new snapshot is encoded once into a websocket message buffer
+ * that is shared by all clients. The last STREAM_QUEUE_DEPTH frames are kept
+ * in a ring and each client only holds a cursor into it, so a slow consumer
+ * skips ahead to the oldest retained frame instead of growing a queue.
+ */
+#ifndef STREAM_QUEUE_DEPTH
+#define STREAM_QUEUE_DEPTH 4
+#endif  // STREAM_QUEUE_DEPTH
+
+class TelemetryStream {
+  struct Frame_t {
+    AsyncWebSocketMessageBuffer* buffer;
+    uint32_t sequence;
+  };
+
+  AsyncWebSocket _ws;
+  DataSnapshot& _snapshot;
+  std::mutex _mutex;
+  Frame_t _frames[STREAM_QUEUE_DEPTH];
+  uint32_t _latest;
+  //* Snapshot sequence of the latest frame
+  uint32_t _framed;
+  //* client id -> sequence of the next frame to send, 0 until seeded
+  std::unordered_map<uint32_t, uint32_t> _cursors;
+  std::atomic<bool> _seedRequested;
+  uint32_t _dropped;
+
+  void publish(const DataSnapshot::Body_t& body);
+  void seed();
+  void pump();
+  void onEvent(AsyncWebSocket* server,
+               AsyncWebSocketClient* client,
+               AwsEventType type,
+               void* arg,
+               uint8_t* data,
+               size_t len);
+
+ public:
+  TelemetryStream(DataSnapshot& snapshot, const char* url = "/tower/stream");
+  virtual ~TelemetryStream();
+
+  void begin(AsyncWebServer& server);
+  void loop();
+  size_t getClientCount();
+  uint32_t getDroppedFrames();
+};
+
+#endif
@@ -1,5 +1,5 @@
 #include "basicmqtt.hpp"
-#include <ESPmDNS.h>
+#include <algorithm>
 
 // TODO: Implement the MQTT Stack as a base class for all MQTT based sensors
 // Note: reimplement this library with the current Mqtt base class https://github.com/dawidchyrzynski/arduino-home-assistant
@@ -12,11 +12,43 @@
 //************************************************************************************************************************
 BaseMQTT::BaseMQTT(GreenHouseConfig& config,
                    ProjectConfig& projectConfig,
-                   MQTTClient& client)
+                   MQTTClient& client,
+                   MQTTOutbox& outbox,
+                   Clock& clock)
     : _deviceConfig(config),
       _projectConfig(projectConfig),
       _client(client),
-      brokerDiscovery(false) {}
+      _outbox(outbox),
+      _clock(clock),
+      _topics(config, projectConfig),
+      _discovery(clock),
+      _pool(clock),
+      _started(false),
+      _reinit(false),
+      _configuredRevision(0),
+      _activePort(0),
+      _endpointChanged(false),
+      _lastDrain(0),
+      _state(MQTTState_e::MQTTState_Idle),
+      _attempts(0),
+      _attemptStart(0),
+      _nextAttempt(0),
+      _outageStart(0),
+      _connectLatency(0),
+      _lastOutage(0),
+      _outages(0),
+      _sessions(0),
+      _heapBefore(0),
+      _heapLow(0),
+      _minHeapBefore(0),
+      _heapPeak(0),
+      _maxHeapPeak(0),
+      _tlsConnectMs(0),
+      _minTlsConnectMs(UINT32_MAX),
+      _maxTlsConnectMs(0),
+      _publishCount(0),
+      _lastPublishMicros(0),
+      _maxPublishMicros(0) {}
 
 BaseMQTT::~BaseMQTT() {}
 
@@ -24,195 +56,643 @@ void BaseMQTT::begin() {
   log_i("[BasicMQTT]: Setting up MQTT...");
   _client.addCallback(this);
 
-  brokerDiscovery = discovermDNSBroker();
-
   log_i("[BasicMQTT]: Broker %s:%d",
         _deviceConfig.getMQTTConfig().broker.c_str(),
         _deviceConfig.getMQTTConfig().port);
 
-  if (!_deviceConfig.getMQTTConfig().broker.empty() || brokerDiscovery) {
-    //* Generate the MQTT configuration
-    //* Configuration for MQTT
-    StaticJsonDocument<384> doc;
-    JsonObject mqttConfig = doc.createNestedObject("mqtt");
-
-    mqttConfig["enabled"] = _deviceConfig.getMQTTConfig().enabled;
-    mqttConfig["reconnect_mqtt"] = _deviceConfig.getMQTTConfig().reconnect_mqtt;
-    mqttConfig["reconnect_retires"] =
-        _deviceConfig.getMQTTConfig().reconnect_tries;
-    mqttConfig["reconnect_time_ms"] =
-        _deviceConfig.getMQTTConfig().reconnect_time_ms;
-    mqttConfig["server"] = _deviceConfig.getMQTTConfig().broker;
-    mqttConfig["port"] = _deviceConfig.getMQTTConfig().port;
-    mqttConfig["id_name"] = _projectConfig.getMDNSConfig().hostname;
-    mqttConfig["auth"] = (bool)_deviceConfig.getMQTTConfig().auth;
-    mqttConfig["username"] = _deviceConfig.getMQTTConfig().username;
-    mqttConfig["password"] = _deviceConfig.getMQTTConfig().password;
-    mqttConfig["enable_certs"] = _deviceConfig.getMQTTConfig().enable_certs;
-    mqttConfig["ca_file"] = _deviceConfig.getMQTTConfig().ca_file;
-    mqttConfig["cert_file"] = _deviceConfig.getMQTTConfig().cert_file;
-    mqttConfig["key_file"] = _deviceConfig.getMQTTConfig().key_file;
-    mqttConfig["enabled_websocket"] =
-        _deviceConfig.getMQTTConfig().enabled_websocket;
-    mqttConfig["websocket_path"] = _deviceConfig.getMQTTConfig().websocket_path;
-
-    JsonArray pub_topics = mqttConfig.createNestedArray("pub_topic");
-    for (auto& topic : _deviceConfig.getMQTTConfig().pub_topics) {
-      pub_topics.add(topic);
+  _topics.refresh();
+  refreshTopics();
+  registerCommands();
+  _router.seal();
+
+  //* Start on the preferred known broker, discovery only runs without one
+  //* or once every known broker failed. The broker mDNS found last time
+  //* counts as known until a new query replaces it.
+  _outageStart = _clock.millis();
+  const std::string& cached = _deviceConfig.getMQTTConfig().discovered_broker;
+  size_t colon = cached.rfind(':');
+  if (colon != std::string::npos)
+    _pool.merge({{cached.substr(0, colon),
+                  (uint16_t)atoi(cached.c_str() + colon + 1), UINT32_MAX}});
+  configurePool();
+  if (_pool.size() == 0)
+    _discovery.request();
+  if (!_activeHost.empty())
+    connect();
+}
+
+//* Client settings from the config and the active broker
+void BaseMQTT::clientConfig(JsonObject mqttConfig) {
+  mqttConfig["enabled"] = _deviceConfig.getMQTTConfig().enabled;
+  mqttConfig["reconnect_mqtt"] = false;
+  mqttConfig["reconnect_retires"] =
+      _deviceConfig.getMQTTConfig().reconnect_tries;
+  mqttConfig["reconnect_time_ms"] =
+      _deviceConfig.getMQTTConfig().reconnect_time_ms;
+  mqttConfig["server"] = _activeHost;
+  mqttConfig["port"] = _activePort;
+  mqttConfig["id_name"] = _projectConfig.getMDNSConfig().hostname;
+  mqttConfig["auth"] = (bool)_deviceConfig.getMQTTConfig().auth;
+  mqttConfig["username"] = _deviceConfig.getMQTTConfig().username;
+  mqttConfig["password"] = _deviceConfig.getMQTTConfig().password;
+  mqttConfig["enable_certs"] = _deviceConfig.getMQTTConfig().enable_certs;
+  mqttConfig["ca_file"] = _deviceConfig.getMQTTConfig().ca_file;
+  mqttConfig["cert_file"] = _deviceConfig.getMQTTConfig().cert_file;
+  mqttConfig["key_file"] = _deviceConfig.getMQTTConfig().key_file;
+  mqttConfig["enabled_websocket"] =
+      _deviceConfig.getMQTTConfig().enabled_websocket;
+  mqttConfig["websocket_path"] = _deviceConfig.getMQTTConfig().websocket_path;
+
+  JsonArray pub_topics = mqttConfig.createNestedArray("pub_topic");
+  for (auto& topic : _deviceConfig.getMQTTConfig().pub_topics) {
+    pub_topics.add(std::string(_topics.getPrefix().view()) + topic);
+  }
+  mqttConfig.createNestedArray("sub_topic");
+
+  mqttConfig["mqtt_task_stack_size"] =
+      _deviceConfig.getMQTTConfig().mqtt_task_stack_size;
+}
+
+/**
+ * @brief Compare the client settings with the ones the client was built from
+ * @note Runs when the config revision or the active broker changed. The
+ * endpoint, credentials and certificates live in the esp-mqtt client, a
+ * change there restarts the attempt and the client is rebuilt. Other changes,
+ * such as topics or publish modes, leave the session alone.
+ */
+void BaseMQTT::checkClientConfig() {
+  _configuredRevision = _deviceConfig.getRevision();
+  _endpointChanged = false;
+
+  StaticJsonDocument<384> doc;
+  clientConfig(doc.to<JsonObject>());
+  std::string settings;
+  serializeJson(doc, settings);
+  if (settings == _clientSettings)
+    return;
+  _clientSettings.swap(settings);
+  if (!_started || _activeHost.empty())
+    return;
+
+  log_i("[BasicMQTT]: Client settings changed, reconnecting with them");
+  _reinit = true;
+  if (_state == MQTTState_e::MQTTState_Connected) {
+    _outageStart = _clock.millis();
+    _outages++;
+  }
+  _attempts = 0;
+  _nextAttempt = _clock.millis();
+  _state = MQTTState_e::MQTTState_Backoff;
+}
+
+/**
+ * @brief Hand the current configuration to the client
+ * @note The client's own reconnect loop is disabled, reconnects are driven by
+ * the state machine in loop(). Subscriptions are not passed either, they are
+ * sent as one batch once the session is up.
+ */
+void BaseMQTT::configure() {
+  //* Generate the MQTT configuration
+  StaticJsonDocument<384> doc;
+  JsonObject mqttConfig = doc.createNestedObject("mqtt");
+  clientConfig(mqttConfig);
+
+  serializeJsonPretty(doc, Serial);
+  Serial.println();
+  _client.setConfig(mqttConfig);
+  //* End MQTT Configuration
+  log_i("[BasicMQTT]: Hostname: %s",
+        _projectConfig.getMDNSConfig().hostname.c_str());
+}
+
+/**
+ * @brief Start one connection attempt, completion is picked up by loop()
+ * @note A plain retry only reconnects the esp-mqtt client. When the client
+ * settings changed, see checkClientConfig(), the TLS credentials are reloaded
+ * and the client is torn down and set up again from the new configuration.
+ */
+void BaseMQTT::connect() {
+  if (_endpointChanged || _configuredRevision != _deviceConfig.getRevision())
+    checkClientConfig();
+
+  if (!_started || _reinit) {
+    if (!_tls.load(_deviceConfig.getMQTTConfig())) {
+      log_e("[BasicMQTT]: TLS credentials unusable, not connecting");
+      _attempts++;
+      _nextAttempt = _clock.millis() + backoff();
+      _state = MQTTState_e::MQTTState_Backoff;
+      return;
     }
+    configure();
+  }
+  _state = MQTTState_e::MQTTState_Connecting;
+  _attemptStart = _clock.millis();
+  _heapBefore = ESP.getFreeHeap();
+  _heapLow = _heapBefore;
+  _minHeapBefore = ESP.getMinFreeHeap();
+  //* Local Mosquitto Connection -- Start
+  if (!_started) {
+    _client.setup();
+    _started = true;
+  } else if (_reinit) {
+    _client.disconnect();
+    _client.setup();
+  } else {
+    _client.reconnect();
+  }
+  _reinit = false;
+}
+
+/**
+ * @brief Delay before the next attempt
+ * @note Exponential from one second up to backoff_max_ms, randomised over
+ * the upper half of the step so a fleet of towers does not reconnect in
+ * lockstep after a broker restart
+ */
+uint32_t BaseMQTT::backoff() {
+  uint32_t ceiling =
+      std::max(1000, _deviceConfig.getMQTTConfig().backoff_max_ms);
+  uint32_t delay = ceiling;
+  if (_attempts < 16)
+    delay = std::min<uint32_t>(ceiling, 1000UL << _attempts);
+  return delay / 2 + esp_random() % (delay / 2 + 1);
+}
 
-    JsonArray sub_topics = mqttConfig.createNestedArray("sub_topic");
-    for (auto& topic : _deviceConfig.getMQTTConfig().sub_topics) {
-      sub_topics.add(topic);
+/**
+ * @brief Connection state machine, never blocks
+ * @note Connecting - waits for the session up to reconnect_time_ms
+ *       Connected - watches for the session dropping
+ *       Backoff - waits out the jittered delay, then tries again
+ */
+void BaseMQTT::updateConnection() {
+  uint32_t now = _clock.millis();
+  Project_Config::MQTTConfig_t& mqtt = _deviceConfig.getMQTTConfig();
+  switch (_state) {
+    case MQTTState_e::MQTTState_Connecting: {
+      _heapLow = std::min<uint32_t>(_heapLow, ESP.getFreeHeap());
+      if (_client.connected()) {
+        _connectLatency = now - _attemptStart;
+        _lastOutage = now - _outageStart;
+        _attempts = 0;
+        _state = MQTTState_e::MQTTState_Connected;
+        _sessions++;
+        _pool.connected(_activeHost, _activePort);
+        rememberBroker();
+
+        //* A new low-water mark means the connect itself went that low
+        uint32_t minHeap = ESP.getMinFreeHeap();
+        if (minHeap < _minHeapBefore)
+          _heapLow = std::min(_heapLow, minHeap);
+        _heapPeak = _heapBefore > _heapLow ? _heapBefore - _heapLow : 0;
+        _maxHeapPeak = std::max(_maxHeapPeak, _heapPeak);
+        if (mqtt.enable_certs) {
+          _tlsConnectMs = _connectLatency;
+          _minTlsConnectMs = std::min(_minTlsConnectMs, _tlsConnectMs);
+          _maxTlsConnectMs = std::max(_maxTlsConnectMs, _tlsConnectMs);
+        }
+        log_i("[BasicMQTT]: Connected in %u ms after %u ms offline, %u bytes "
+              "of heap used",
+              _connectLatency, _lastOutage, _heapPeak);
+        resubscribe();
+        publishStatus();
+      } else if (now - _attemptStart >=
+                 (uint32_t)std::max(1000, mqtt.reconnect_time_ms)) {
+        _attempts++;
+        _nextAttempt = now + backoff();
+        _state = MQTTState_e::MQTTState_Backoff;
+        if (_attempts == (uint32_t)mqtt.reconnect_tries)
+          log_e("[BasicMQTT]: %u attempts failed, still retrying", _attempts);
+
+        //* Fail over right away when another broker is available
+        _pool.failed(_activeHost, _activePort);
+        selectBroker();
+      }
+      break;
+    }
+    case MQTTState_e::MQTTState_Connected: {
+      if (!_client.connected()) {
+        log_w("[BasicMQTT]: Connection lost");
+        _outageStart = now;
+        _outages++;
+        _nextAttempt = now + backoff();
+        _state = mqtt.reconnect_mqtt ? MQTTState_e::MQTTState_Backoff
+                                     : MQTTState_e::MQTTState_Idle;
+        _pool.failed(_activeHost, _activePort);
+        if (mqtt.reconnect_mqtt)
+          selectBroker();
+      }
+      break;
+    }
+    case MQTTState_e::MQTTState_Backoff: {
+      if ((int32_t)(now - _nextAttempt) >= 0 &&
+          wifiStateManager.getCurrentState() ==
+              WiFiState_e::WiFiState_Connected) {
+        log_d("[BasicMQTT]: Reconnect attempt %u", _attempts + 1);
+        connect();
+      }
+      break;
     }
+    case MQTTState_e::MQTTState_Idle:
+    default:
+      break;
+  }
+}
 
-    mqttConfig["mqtt_task_stack_size"] =
-        _deviceConfig.getMQTTConfig().mqtt_task_stack_size;
+/**
+ * @brief Connection upkeep, then replay documents queued during an outage
+ * @note One document per outbox_drain_ms so the backlog does not starve the
+ * live cycle or flood the broker
+ * @note The backlog goes to its own non-retained topic, see getBacklogTopic().
+ * Live cycles keep the state topic in order and its retained message current
+ * while the outage is replayed.
+ */
+void BaseMQTT::loop() {
+  //* Fresh mDNS results, move to the best broker unless a session is up
+  if (_discovery.update()) {
+    _pool.merge(_discovery.getBrokers());
+    if (_state != MQTTState_e::MQTTState_Connected)
+      selectBroker();
+  }
+  //* Nothing to connect to, query again on the retry spacing, not the TTL
+  if (_pool.size() == 0)
+    _discovery.request();
 
-    serializeJsonPretty(doc, Serial);
-    Serial.println();
-    _client.setConfig(mqttConfig);
-    //* End MQTT Configuration
-    log_i("[BasicMQTT]: Hostname: %s",
-          _projectConfig.getMDNSConfig().hostname.c_str());
-    _client.setup();
-    //* Local Mosquitto Connection -- Start
+  //* Config changed, subscribe to the rebuilt topics
+  if (_topics.refresh()) {
+    refreshTopics();
+    configurePool();
+  }
+
+  //* Config or broker changed, rebuild the client if its settings moved
+  if (_endpointChanged || _configuredRevision != _deviceConfig.getRevision())
+    checkClientConfig();
+
+  updateConnection();
+
+  uint32_t interval = _deviceConfig.getMQTTConfig().outbox_drain_ms;
+  if (_state != MQTTState_e::MQTTState_Connected ||
+      _clock.millis() - _lastDrain < interval)
+    return;
+  _lastDrain = _clock.millis();
+
+  uint32_t timestamp;
+  std::string document;
+  if (_outbox.pop(timestamp, document)) {
+    log_d("[BasicMQTT]: Replaying cycle from %u, %u left", timestamp,
+          _outbox.size());
+    const MQTTTopic_t& topic =
+        getBacklogTopic(document.c_str(), document.length());
+    publish(topic.c_str(), document.c_str(), document.length(), 1, false);
   }
 }
 
+//* Point the router and the subscription set at the rebuilt topic table
+void BaseMQTT::refreshTopics() {
+  MQTTTopic_t commands(_topics.getPrefix());
+  commands.append("cmd/");
+  _router.setPrefix(commands);
+  _subscriptions.clear();
+  for (auto& topic : _topics.subscriptions()) {
+    subscribe(topic);
+  }
+  subscribe(std::string(_topics.get(Topics::COMMANDS).view()));
+  if (_state == MQTTState_e::MQTTState_Connected)
+    resubscribe();
+}
+
+/**
+ * @brief Add a topic to the subscription set
+ * @note The set is sorted and holds each topic once, it is sent to the broker
+ * as a whole by resubscribe()
+ * @return false when the topic was already in the set
+ */
+bool BaseMQTT::subscribe(const std::string& topic) {
+  auto it =
+      std::lower_bound(_subscriptions.begin(), _subscriptions.end(), topic);
+  if (it != _subscriptions.end() && *it == topic)
+    return false;
+  _subscriptions.insert(it, topic);
+  return true;
+}
+
+//* Send the whole subscription set, once per session
+void BaseMQTT::resubscribe() {
+  for (auto& topic : _subscriptions) {
+    _client.addTopicSub(topic.c_str(), 2);
+  }
+  log_i("[BasicMQTT]: Subscribed to %u topics", _subscriptions.size());
+}
+
+/**
+ * @brief Commands that change the MQTT configuration
+ * @note Sensor and acquisition commands are registered by their owners
+ */
+void BaseMQTT::registerCommands() {
+  _router.on("history_export", [this](const char* payload, size_t length) {
+    bool enabled;
+    if (CommandRouter::parseBool(payload, length, enabled))
+      _deviceConfig.setHistoryExport(enabled);
+  });
+
+  _router.on("publish_mode", [this](const char* payload, size_t length) {
+    uint32_t mode;
+    if (CommandRouter::parseUInt(payload, length, mode) &&
+        mode <= GreenHouseConfig::MqttPublish_t::BATCHED_AND_PER_SENSOR)
+      _deviceConfig.setPublishMode(
+          static_cast<GreenHouseConfig::MqttPublish_t>(mode));
+  });
+}
+
+/**
+ * @brief Retained connection report on <prefix>/status, once per session
+ * @note Lets the cost of a (TLS) connect be compared across broker setups
+ * without a serial console
+ */
+void BaseMQTT::publishStatus() {
+  Project_Config::MQTTConfig_t& mqtt = _deviceConfig.getMQTTConfig();
+  char status[320];
+  int length = snprintf(
+      status, sizeof(status),
+      "{\"broker\":\"%s:%u\",\"tls\":%s,\"sessions\":%u,\"outages\":%u,"
+      "\"connect_ms\":%u,\"tls_connect_ms\":%u,\"tls_connect_min_ms\":%u,"
+      "\"tls_connect_max_ms\":%u,\"heap_peak\":%u,\"heap_peak_max\":%u,"
+      "\"free_heap\":%u}",
+      _activeHost.c_str(), _activePort, mqtt.enable_certs ? "true" : "false",
+      _sessions, _outages, _connectLatency, _tlsConnectMs,
+      _minTlsConnectMs == UINT32_MAX ? 0 : _minTlsConnectMs,
+      _maxTlsConnectMs,
+      _heapPeak, _maxHeapPeak, ESP.getFreeHeap());
+  if (length <= 0 || length >= (int)sizeof(status))
+    return;
+  publishRetained(_topics.get(Topics::STATUS),
+                  std::string_view(status, length));
+}
+
 void BaseMQTT::onTopicUpdate(MQTTClient* client,
                              const mqtt_client_topic_data* topic) {}
 
 void BaseMQTT::onConnected(MQTTClient* client) {}
 
-//* Handles messages arrived on subscribed topic(s)
+/**
+ * @brief Handles messages arrived on subscribed topic(s)
+ * @note Runs on the MQTT client task, the payload is handed to the command
+ * router as is
+ */
 void BaseMQTT::onDataReceived(MQTTClient* client,
                               const mqtt_client_event_data* data) {
-  //* Convert the payload to a string
-  std::string result;
-  for (int i = 0; i < data->data_len; i++) {
-    log_i("%s", static_cast<char>(data->data[i]));
-    result += static_cast<char>(data->data[i]);
-  }
-  log_i("[BasicMQTT]: Message: [%s]", result.c_str());
-
-  log_i(
-      "[BasicMQTT]: [%lu] +++ MQTT message of size %d on topic "
-      "%s: "
-      "%.*s\r\n",
-      millis(), data->data_len, data->topic.c_str(), data->data_len,
-      data->data);
-
-  // TODO: Add support to handle sensor specific commands
+  log_d("[BasicMQTT]: Message of %d bytes on %s", data->data_len,
+        data->topic.c_str());
+  _router.dispatch(data->topic.c_str(), data->topic.length(), data->data,
+                   data->data_len);
 }
 
 void BaseMQTT::onSubscribed(MQTTClient* thisClient,
                             const mqtt_client_topic_data* topic) {}
 
-void BaseMQTT::dataHandler(const std::string& topic,
+/**
+ * @brief Single publish path, tracks how long the client takes per message
+ * @note QoS and retain come from the configured topic policies, telemetry
+ * defaults to QoS 0 so no in-flight state builds up in the client
+ */
+void BaseMQTT::publish(const char* topic, const char* payload, size_t length) {
+  Project_Config::MQTTDelivery_t policy = _deviceConfig.getTopicPolicy(topic);
+  publish(topic, payload, length, policy.qos, policy.retain);
+}
+
+void BaseMQTT::publish(const char* topic,
+                       const char* payload,
+                       size_t length,
+                       uint8_t qos,
+                       bool retain) {
+  uint32_t start = micros();
+  _client.publish(topic, payload, length, qos, retain);
+  _lastPublishMicros = micros() - start;
+  _maxPublishMicros = std::max(_maxPublishMicros, _lastPublishMicros);
+  _publishCount++;
+  log_d("[BasicMQTT]: Published %u bytes on %s (qos %u%s) in %u us", length,
+        topic, qos, retain ? ", retained" : "", _lastPublishMicros);
+}
+
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
                            const std::string& payload) {
   log_d("[BasicMQTT]: Payload: %s", topic.c_str());
-  if (!_client.connected() && !topic.empty()) {
-    _client.addTopicSub(topic.c_str(), 2);
-  }
-
   if (!topic.empty() && !payload.empty()) {
-    _client.publish(topic.c_str(), payload.c_str(), payload.length(), 2, 1);
+    publish(topic.c_str(), payload.c_str(), payload.length());
   }
 }
 
-void BaseMQTT::dataHandler(const std::string& topic, float payload) {
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
+                           const CycleArena::String& payload) {
   log_d("[BasicMQTT]: Payload: %s", topic.c_str());
-  if (!_client.connected() && !topic.empty()) {
-    _client.addTopicSub(topic.c_str(), 2);
-  }
-
-  std::string payloadStr = std::to_string(payload);
-  if (!topic.empty() && !payloadStr.empty()) {
-    _client.publish(topic.c_str(), payloadStr.c_str(), payloadStr.length(), 2,
-                    1);
+  if (!topic.empty() && !payload.empty()) {
+    publish(topic.c_str(), payload.c_str(), payload.length());
   }
 }
 
-void BaseMQTT::dataHandler(const std::string& topic,
-                           std::vector<float> payload) {
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
+                           float payload,
+                           uint8_t precision) {
   log_d("[BasicMQTT]: Payload: %s", topic.c_str());
-  if (!_client.connected() && !topic.empty()) {
-    _client.addTopicSub(topic.c_str(), 2);
+  char payloadStr[FLOAT_FORMAT_SIZE];
+  size_t length =
+      FloatFormat::format(payload, precision, payloadStr, sizeof(payloadStr));
+  if (!topic.empty() && length > 0) {
+    publish(topic.c_str(), payloadStr, length);
   }
+}
 
-  std::string payloadStr;
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
+                           std::vector<float> payload,
+                           uint8_t precision) {
+  log_d("[BasicMQTT]: Payload: %s", topic.c_str());
+  CycleArena::String payloadStr;
   for (auto& i : payload) {
-    payloadStr += std::to_string(i) + ",";
-    log_i("[BasicMQTT]: Payload: %s", payloadStr.c_str());
+    FloatFormat::append(payloadStr, i, precision);
+    payloadStr += ",";
   }
   if (!topic.empty() && !payloadStr.empty()) {
-    _client.publish(topic.c_str(), payloadStr.c_str(), payloadStr.length(), 2,
-                    1);
+    publish(topic.c_str(), payloadStr.c_str(), payloadStr.length());
   }
 }
 
-void BaseMQTT::dataHandler(const std::string& topic,
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
                            std::vector<std::string> payload) {
   log_d("[BasicMQTT]: Payload: %s", topic.c_str());
-  if (!_client.connected() && !topic.empty()) {
-    _client.addTopicSub(topic.c_str(), 2);
+  CycleArena::String payloadStr;
+  for (auto& i : payload) {
+    payloadStr.append(i.c_str(), i.length());
+    payloadStr += ",";
   }
+  if (!topic.empty() && !payloadStr.empty()) {
+    publish(topic.c_str(), payloadStr.c_str(), payloadStr.length());
+  }
+}
 
-  std::string payloadStr;
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
+                           std::unordered_map<std::string, float> payload,
+                           uint8_t precision) {
+  log_d("[BasicMQTT]: Payload: %s", topic.c_str());
+  CycleArena::String payloadStr;
   for (auto& i : payload) {
-    payloadStr += i + ",";
+    payloadStr.append(i.first.c_str(), i.first.length());
+    payloadStr += ":";
+    FloatFormat::append(payloadStr, i.second, precision);
+    payloadStr += ",";
   }
   if (!topic.empty() && !payloadStr.empty()) {
-    _client.publish(topic.c_str(), payloadStr.c_str(), payloadStr.length(), 2,
-                    1);
+    publish(topic.c_str(), payloadStr.c_str(), payloadStr.length());
   }
 }
 
-void BaseMQTT::dataHandler(const std::string& topic,
-                           std::unordered_map<std::string, float> payload) {
-  log_d("[BasicMQTT]: Payload: %s", topic.c_str());
-  if (!_client.connected() && !topic.empty()) {
-    _client.addTopicSub(topic.c_str(), 2);
+//* Binary payloads, e.g. compressed history exports
+void BaseMQTT::dataHandler(const MQTTTopic_t& topic,
+                           const uint8_t* payload,
+                           size_t length) {
+  log_d("[BasicMQTT]: Binary payload of %u bytes on %s", length,
+        topic.c_str());
+  if (!topic.empty() && length > 0) {
+    publish(topic.c_str(), reinterpret_cast<const char*>(payload), length);
   }
+}
 
-  std::string payloadStr;
-  for (auto& i : payload) {
-    payloadStr += i.first + ":" + std::to_string(i.second) + ",";
+/**
+ * @brief Publish a whole acquisition cycle as one message
+ * @note The payload is the JSON document or its CBOR form, depending on the
+ * mqtt encoding setting. Each goes to its own topic, see getCycleTopic().
+ * @note With QoS 2 every publish is a four packet exchange, one document per
+ * cycle on the device topic costs one exchange instead of one per sensor
+ * @note While the broker is unreachable the document goes to the outbox and
+ * is replayed from loop() on the backlog topic after reconnecting
+ * @return true when the document was published or queued
+ */
+bool BaseMQTT::publishCycle(const char* payload,
+                            size_t length,
+                            uint32_t timestamp) {
+  if (length == 0)
+    return false;
+  if (!_client.connected()) {
+    _outbox.push(timestamp, payload, length);
+    return true;
   }
-  if (!topic.empty() && !payloadStr.empty()) {
-    _client.publish(topic.c_str(), payloadStr.c_str(), payloadStr.length(), 2,
-                    1);
-  }
-}
-
-//******************************************************************************
-// * Function: Discover mDNS Broker
-// * Description: Find the mDNS broker and and port return them
-// * Parameters: None
-// * Return: int - 1 if success, 0 if fail
-//******************************************************************************
-bool BaseMQTT::discovermDNSBroker() {
-  IPAddress mqttServer;
-  //* check if there is a WiFi connection
-  if (wifiStateManager.getCurrentState() == WiFiState_e::WiFiState_Connected) {
-    log_i("[mDNS Broker Discovery]: Connected to Wifi, proceeding... \n");
-    log_i("[mDNS Broker Discovery]: Setting up mDNS... ");
-    log_i("[mDNS Broker Discovery]: Querying MQTT broker service...");
-
-    int n = MDNS.queryService("mqtt", "tcp");
-    if (n != 0) {
-      int mqttPort;
-      // Found one or more MQTT services - use the first one.
-      mqttServer = MDNS.IP(0);
-      mqttPort = MDNS.port(0);
-      _deviceConfig.setMQTTBroker(mqttServer.toString().c_str(), mqttPort);
-      _deviceConfig.saveMQTT();
-      log_i("[mDNS Broker Discovery]: MQTT broker found at: %s:%d",
-            mqttServer.toString().c_str(), mqttPort);
-      return true;
+  const MQTTTopic_t& topic = getCycleTopic(payload, length);
+  publish(topic.c_str(), payload, length);
+  log_i("[BasicMQTT]: Cycle of %u bytes published on %s in %u us (max %u us)",
+        length, topic.c_str(), _lastPublishMicros, _maxPublishMicros);
+  return true;
+}
+
+/**
+ * @brief Retained QoS 1 publish, regardless of the topic policies
+ * @note For state the broker has to hand to late subscribers, such as Home
+ * Assistant discovery configs. An empty payload clears the retained message.
+ */
+void BaseMQTT::publishRetained(const MQTTTopic_t& topic,
+                               std::string_view payload) {
+  if (topic.empty() || !_client.connected())
+    return;
+  publish(topic.c_str(), payload.data(), payload.length(), 1, true);
+}
+
+/**
+ * @brief Topic of the batched cycle document
+ * @note Defaults to <hostname>/<tower_id>/state when no device topic is
+ * configured
+ */
+const MQTTTopic_t& BaseMQTT::getDeviceTopic() {
+  return _topics.get(Topics::STATE);
+}
+
+/**
+ * @brief Topic for a cycle payload, CBOR goes to <device topic>/cbor
+ * @note A JSON document always opens with '{', a CBOR cycle with a map head
+ * (0xa0 to 0xb7). Telling them apart by the first byte keeps queued documents
+ * on the right topic even if the encoding changed during an outage.
+ */
+const MQTTTopic_t& BaseMQTT::getCycleTopic(const char* payload,
+                                           size_t length) {
+  if (length > 0 && payload[0] != '{')
+    return _topics.get(Topics::STATE_CBOR);
+  return getDeviceTopic();
+}
+
+/**
+ * @brief Topic for a replayed outbox document, <device topic>/backlog
+ * @note Published QoS 1 and never retained, whatever the policy of the state
+ * topic. CBOR goes to <device topic>/backlog/cbor, told apart as in
+ * getCycleTopic().
+ */
+const MQTTTopic_t& BaseMQTT::getBacklogTopic(const char* payload,
+                                             size_t length) {
+  if (length > 0 && payload[0] != '{')
+    return _topics.get(Topics::BACKLOG_CBOR);
+  return _topics.get(Topics::BACKLOG);
+}
+
+/**
+ * @brief Ask for a background mDNS query for _mqtt._tcp brokers
+ * @note Never blocks, the result is picked up by loop()
+ */
+void BaseMQTT::discovermDNSBroker() {
+  _discovery.request();
+}
+
+/**
+ * @brief Feed the configured broker list to the pool, mqtt.broker is the
+ * fallback
+ * @note A changed list applies to a live session too, the client is rebuilt
+ * when the best broker moved
+ */
+void BaseMQTT::configurePool() {
+  Project_Config::MQTTConfig_t& mqtt = _deviceConfig.getMQTTConfig();
+  if (_pool.configure(mqtt.brokers, mqtt.broker, mqtt.port,
+                      mqtt.broker_spread,
+                      _projectConfig.getMDNSConfig().hostname))
+    selectBroker();
+}
+
+/**
+ * @brief Move to the best candidate of the pool
+ * @note A new mDNS query is requested once every known broker failed
+ * @return true when another broker was selected
+ */
+bool BaseMQTT::selectBroker() {
+  if (_pool.allFailing())
+    _discovery.request();
+  const BrokerPool::Broker_t* broker = _pool.select();
+  if (!broker || (broker->host == _activeHost && broker->port == _activePort))
+    return false;
+  useBroker(*broker);
+  return true;
+}
+
+/**
+ * @brief Switch to a broker and try it without waiting out the backoff
+ * @note Only the client endpoint moves. The configuration, its revision and
+ * NVS are left alone, so a failover never replaces the configured brokers
+ * and does not rebuild the topics. A discovered broker is only cached once
+ * it took a session, see rememberBroker().
+ */
+void BaseMQTT::useBroker(const BrokerPool::Broker_t& broker) {
+  log_i("[BasicMQTT]: Broker %s:%u -> %s:%u", _activeHost.c_str(),
+        _activePort, broker.host.c_str(), broker.port);
+  _activeHost.assign(broker.host);
+  _activePort = broker.port;
+  _endpointChanged = true;
+  if (_state == MQTTState_e::MQTTState_Idle ||
+      _state == MQTTState_e::MQTTState_Backoff) {
+    _nextAttempt = _clock.millis();
+    _state = MQTTState_e::MQTTState_Backoff;
+  }
+}
+
+//* Cache a discovered broker that took a session, see begin()
+void BaseMQTT::rememberBroker() {
+  for (auto& broker : _pool.getBrokers()) {
+    if (broker.discovered && broker.host == _activeHost &&
+        broker.port == _activePort) {
+      _deviceConfig.setDiscoveredBroker(_activeHost + ":" +
+                                        std::to_string(_activePort));
+      return;
     }
-    log_e("[Fail]: No mqtt service found on your network\n");
   }
-  return false;
 }
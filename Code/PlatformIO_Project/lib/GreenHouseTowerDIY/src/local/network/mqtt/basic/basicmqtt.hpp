@@ -9,8 +9,24 @@
 // #include <PubSubClient.h>
 #include <ArduinoJson.h>
 #include <MQTTClient.h>
+#include "local/Serializers/FloatFormat/floatformat.hpp"
+#include "local/data/arena/cyclearena.hpp"
+#include "local/data/clock/clock.hpp"
 #include "local/data/config/config.hpp"
 #include "local/data/visitor.hpp"
+#include "local/network/mqtt/brokers/brokerpool.hpp"
+#include "local/network/mqtt/commands/commandrouter.hpp"
+#include "local/network/mqtt/discovery/brokerdiscovery.hpp"
+#include "local/network/mqtt/outbox/outbox.hpp"
+#include "local/network/mqtt/tls/tlscredentials.hpp"
+#include "local/network/mqtt/topics/topictable.hpp"
+
+enum class MQTTState_e : uint8_t {
+  MQTTState_Idle,
+  MQTTState_Connecting,
+  MQTTState_Connected,
+  MQTTState_Backoff,
+};
 
 /**
  * @brief MQTT Class
@@ -19,11 +35,79 @@ class BaseMQTT : public MQTTClientCallback, public IPAddress {
   GreenHouseConfig& _deviceConfig;
   ProjectConfig& _projectConfig;
   MQTTClient& _client;
+  MQTTOutbox& _outbox;
+  Clock& _clock;
+  TopicTable _topics;
+  CommandRouter _router;
+  BrokerDiscovery _discovery;
+  BrokerPool _pool;
+  TLSCredentials _tls;
+  bool _started;  // client set up, later attempts only reconnect
+  bool _reinit;   // client settings changed, the next attempt rebuilds it
+  uint32_t _configuredRevision;
+  std::string _clientSettings;  // what the client was last built from
+  //* Broker the client points at, mqtt.broker stays the configured fallback
+  std::string _activeHost;
+  uint16_t _activePort;
+  bool _endpointChanged;
+  std::vector<std::string> _subscriptions;
+  uint32_t _lastDrain;
+
+  //* Connection state machine
+  MQTTState_e _state;
+  uint32_t _attempts;
+  uint32_t _attemptStart;
+  uint32_t _nextAttempt;
+  uint32_t _outageStart;
+  uint32_t _connectLatency;
+  uint32_t _lastOutage;
+  uint32_t _outages;
+  uint32_t _sessions;
+
+  //* Connect cost, heap is sampled from loop() and the low-water mark
+  uint32_t _heapBefore;
+  uint32_t _heapLow;
+  uint32_t _minHeapBefore;
+  uint32_t _heapPeak;
+  uint32_t _maxHeapPeak;
+  //* Whole connect time of TLS sessions, TCP and the MQTT CONNECT included
+  uint32_t _tlsConnectMs;
+  uint32_t _minTlsConnectMs;
+  uint32_t _maxTlsConnectMs;
+
+  //* Publish statistics
+  uint32_t _publishCount;
+  uint32_t _lastPublishMicros;
+  uint32_t _maxPublishMicros;
+
+  void clientConfig(JsonObject mqttConfig);
+  void checkClientConfig();
+  void configure();
+  void connect();
+  uint32_t backoff();
+  void updateConnection();
+  void configurePool();
+  bool selectBroker();
+  void useBroker(const BrokerPool::Broker_t& broker);
+  void rememberBroker();
+  void refreshTopics();
+  bool subscribe(const std::string& topic);
+  void resubscribe();
+  void registerCommands();
+  void publishStatus();
+  void publish(const char* topic, const char* payload, size_t length);
+  void publish(const char* topic,
+               const char* payload,
+               size_t length,
+               uint8_t qos,
+               bool retain);
 
  public:
   BaseMQTT(GreenHouseConfig& config,
            ProjectConfig& _projectConfig,
-           MQTTClient& client);
+           MQTTClient& client,
+           MQTTOutbox& outbox,
+           Clock& clock);
   virtual ~BaseMQTT();
 
   //* Callbacks for MQTT library
@@ -36,17 +120,49 @@ class BaseMQTT : public MQTTClientCallback, public IPAddress {
                              const mqtt_client_topic_data* topic) override;
 
   void begin();
-  bool discovermDNSBroker();
+  void loop();
+  void discovermDNSBroker();
   bool mqttConnected() { return _client.connected(); }
 
   //* Data Handlers
-  void dataHandler(const std::string& topic, const std::string& payload);
-  void dataHandler(const std::string& topic, float payload);
-  void dataHandler(const std::string& topic, std::vector<float> payload);
-  void dataHandler(const std::string& topic, std::vector<std::string> payload);
-  void dataHandler(const std::string& topic,
-                   std::unordered_map<std::string, float> payload);
-
-  bool brokerDiscovery;
+  void dataHandler(const MQTTTopic_t& topic, const std::string& payload);
+  void dataHandler(const MQTTTopic_t& topic,
+                   const CycleArena::String& payload);
+  void dataHandler(const MQTTTopic_t& topic,
+                   float payload,
+                   uint8_t precision = 3);
+  void dataHandler(const MQTTTopic_t& topic,
+                   std::vector<float> payload,
+                   uint8_t precision = 3);
+  void dataHandler(const MQTTTopic_t& topic, std::vector<std::string> payload);
+  void dataHandler(const MQTTTopic_t& topic,
+                   std::unordered_map<std::string, float> payload,
+                   uint8_t precision = 3);
+  void dataHandler(const MQTTTopic_t& topic,
+                   const uint8_t* payload,
+                   size_t length);
+  bool publishCycle(const char* payload, size_t length, uint32_t timestamp);
+  void publishRetained(const MQTTTopic_t& topic, std::string_view payload);
+
+  const MQTTTopic_t& getDeviceTopic();
+  const MQTTTopic_t& getCycleTopic(const char* payload, size_t length);
+  const MQTTTopic_t& getBacklogTopic(const char* payload, size_t length);
+  const TopicTable& getTopics() { return _topics; }
+  CommandRouter& getRouter() { return _router; }
+  MQTTState_e getState() { return _state; }
+  const std::string& getActiveBroker() { return _activeHost; }
+  uint16_t getActivePort() { return _activePort; }
+  uint32_t getConnectLatency() { return _connectLatency; }
+  uint32_t getLastOutage() { return _lastOutage; }
+  uint32_t getOutageCount() { return _outages; }
+  uint32_t getSessionCount() { return _sessions; }
+  uint32_t getTlsConnectMs() { return _tlsConnectMs; }
+  uint32_t getMinTlsConnectMs() { return _minTlsConnectMs; }
+  uint32_t getMaxTlsConnectMs() { return _maxTlsConnectMs; }
+  uint32_t getHeapPeak() { return _heapPeak; }
+  uint32_t getMaxHeapPeak() { return _maxHeapPeak; }
+  uint32_t getPublishCount() { return _publishCount; }
+  uint32_t getLastPublishMicros() { return _lastPublishMicros; }
+  uint32_t getMaxPublishMicros() { return _maxPublishMicros; }
 };
 #endif  // HAMQTT_HPP
@@ -0,0 +1,160 @@
+#include "brokerpool.hpp"
+#include <algorithm>
+
+BrokerPool::BrokerPool(Clock& clock)
+    : _clock(clock), _fallbackPort(1883), _start(0) {}
+
+BrokerPool::~BrokerPool() {}
+
+/**
+ * @brief Rebuild the pool when its inputs changed
+ * @param list configured brokers, "host[:port];..." in order of preference
+ * @param fallback broker used when the list is empty
+ * @return true when the pool was rebuilt, health is kept for the brokers
+ * that stay in it
+ */
+bool BrokerPool::configure(const std::string& list,
+                           const std::string& fallback,
+                           uint16_t fallbackPort,
+                           bool spread,
+                           const std::string& hostname) {
+  std::string source = list + "|" + fallback + ":" +
+                       std::to_string(fallbackPort) + "|" +
+                       (spread ? hostname : std::string());
+  if (source == _source)
+    return false;
+  _source.swap(source);
+  _list.assign(list);
+  _fallback.assign(fallback);
+  _fallbackPort = fallbackPort;
+  rebuild();
+
+  //* FNV-1a of the hostname picks the first broker to try
+  _start = 0;
+  if (spread && !_brokers.empty()) {
+    uint32_t hash = 2166136261UL;
+    for (auto c : hostname) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 16777619UL;
+    }
+    _start = hash % _brokers.size();
+  }
+  log_i("[Broker Pool]: %u broker(s), starting at %u", _brokers.size(),
+        _start);
+  return true;
+}
+
+//* Append the mDNS results after the configured brokers
+void BrokerPool::merge(
+    const std::vector<BrokerDiscovery::Broker_t>& discovered) {
+  _discovered = discovered;
+  rebuild();
+  if (_start >= _brokers.size())
+    _start = 0;
+}
+
+void BrokerPool::rebuild() {
+  std::vector<Broker_t> previous;
+  previous.swap(_brokers);
+
+  size_t begin = 0;
+  while (begin < _list.length()) {
+    size_t end = _list.find(';', begin);
+    if (end == std::string::npos)
+      end = _list.length();
+    std::string entry = _list.substr(begin, end - begin);
+    begin = end + 1;
+    if (entry.empty())
+      continue;
+    size_t colon = entry.rfind(':');
+    uint16_t port = 1883;
+    if (colon != std::string::npos) {
+      port = atoi(entry.substr(colon + 1).c_str());
+      entry.erase(colon);
+    }
+    add(entry, port, false, previous);
+  }
+  if (_brokers.empty())
+    add(_fallback, _fallbackPort, false, previous);
+
+  for (auto& broker : _discovered) {
+    add(broker.host, broker.port, true, previous);
+  }
+}
+
+void BrokerPool::add(const std::string& host,
+                     uint16_t port,
+                     bool discovered,
+                     const std::vector<Broker_t>& previous) {
+  if (host.empty() || find(host, port))
+    return;
+  Broker_t broker = {host, port, discovered, 0, 0, 0};
+  for (auto& old : previous) {
+    if (old.host == host && old.port == port) {
+      broker.failures = old.failures;
+      broker.retryAt = old.retryAt;
+      broker.sessions = old.sessions;
+      break;
+    }
+  }
+  _brokers.push_back(broker);
+}
+
+BrokerPool::Broker_t* BrokerPool::find(const std::string& host,
+                                       uint16_t port) {
+  for (auto& broker : _brokers) {
+    if (broker.host == host && broker.port == port)
+      return &broker;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Broker to use for the next attempt
+ * @return nullptr when the pool is empty
+ */
+const BrokerPool::Broker_t* BrokerPool::select() {
+  uint32_t now = _clock.millis();
+  const Broker_t* best = nullptr;
+  for (size_t i = 0; i < _brokers.size(); i++) {
+    const Broker_t& broker = _brokers[(_start + i) % _brokers.size()];
+    if (broker.failures == 0 || (int32_t)(now - broker.retryAt) >= 0)
+      return &broker;
+    if (!best || (int32_t)(broker.retryAt - best->retryAt) < 0)
+      best = &broker;
+  }
+  return best;
+}
+
+void BrokerPool::failed(const std::string& host, uint16_t port) {
+  Broker_t* broker = find(host, port);
+  if (!broker)
+    return;
+  if (broker->failures < UINT8_MAX)
+    broker->failures++;
+  uint32_t cooldown = BROKER_POOL_MAX_COOLDOWN_MS;
+  if (broker->failures < 16)
+    cooldown = std::min<uint32_t>(
+        BROKER_POOL_MAX_COOLDOWN_MS,
+        BROKER_POOL_COOLDOWN_MS << (broker->failures - 1));
+  broker->retryAt = _clock.millis() + cooldown;
+  log_w("[Broker Pool]: %s:%u failed %u time(s), cooling down %u ms",
+        host.c_str(), port, broker->failures, cooldown);
+}
+
+void BrokerPool::connected(const std::string& host, uint16_t port) {
+  Broker_t* broker = find(host, port);
+  if (!broker)
+    return;
+  broker->failures = 0;
+  broker->sessions++;
+}
+
+//* Every broker failed its last attempt
+bool BrokerPool::allFailing() const {
+  for (auto& broker : _brokers) {
+    if (broker.failures == 0)
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,74 @@
+#ifndef BROKERPOOL_HPP
+#define BROKERPOOL_HPP
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "local/data/clock/clock.hpp"
+#include "local/network/mqtt/discovery/brokerdiscovery.hpp"
+
+//* First cooldown after a failure, doubled per consecutive failure
+#ifndef BROKER_POOL_COOLDOWN_MS
+#define BROKER_POOL_COOLDOWN_MS 5000UL
+#endif  // BROKER_POOL_COOLDOWN_MS
+
+#ifndef BROKER_POOL_MAX_COOLDOWN_MS
+#define BROKER_POOL_MAX_COOLDOWN_MS 300000UL
+#endif  // BROKER_POOL_MAX_COOLDOWN_MS
+
+/**
+ * @brief Ordered set of candidate brokers with health tracking
+ * @note Configured brokers come first in their configured order, brokers
+ * found over mDNS follow ranked by response time. A failure puts a broker in
+ * an exponential cooldown, select() returns the first broker out of cooldown
+ * or, when all of them are cooling down, the one that recovers first.
+ * @note With spreading enabled the walk starts at a hash of the hostname, so
+ * a fleet of towers sharing the same list lands on different brokers while
+ * each tower keeps a stable preference.
+ */
+class BrokerPool {
+ public:
+  struct Broker_t {
+    std::string host;
+    uint16_t port;
+    bool discovered;
+    uint8_t failures;  // consecutive
+    uint32_t retryAt;
+    uint32_t sessions;
+  };
+
+ private:
+  Clock& _clock;
+  std::vector<Broker_t> _brokers;
+  std::vector<BrokerDiscovery::Broker_t> _discovered;
+  std::string _source;
+  std::string _list;
+  std::string _fallback;
+  uint16_t _fallbackPort;
+  size_t _start;
+
+  void add(const std::string& host,
+           uint16_t port,
+           bool discovered,
+           const std::vector<Broker_t>& previous);
+  void rebuild();
+  Broker_t* find(const std::string& host, uint16_t port);
+
+ public:
+  explicit BrokerPool(Clock& clock);
+  virtual ~BrokerPool();
+
+  bool configure(const std::string& list,
+                 const std::string& fallback,
+                 uint16_t fallbackPort,
+                 bool spread,
+                 const std::string& hostname);
+  void merge(const std::vector<BrokerDiscovery::Broker_t>& discovered);
+  const Broker_t* select();
+  void failed(const std::string& host, uint16_t port);
+  void connected(const std::string& host, uint16_t port);
+  bool allFailing() const;
+  size_t size() const { return _brokers.size(); }
+  const std::vector<Broker_t>& getBrokers() const { return _brokers; }
+};
+
+#endif
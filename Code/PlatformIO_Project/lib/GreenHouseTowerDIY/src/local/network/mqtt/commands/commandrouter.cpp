@@ -0,0 +1,134 @@
+#include "commandrouter.hpp"
+#include <algorithm>
+
+CommandRouter::CommandRouter()
+    : _sealed(false), _dispatched(0), _unmatched(0) {}
+
+CommandRouter::~CommandRouter() {}
+
+//* Length aware lexicographic compare, the buffers are not null terminated
+int CommandRouter::compare(const char* a,
+                           size_t aLength,
+                           const char* b,
+                           size_t bLength) {
+  int result = memcmp(a, b, std::min(aLength, bLength));
+  if (result != 0)
+    return result;
+  return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+/**
+ * @brief Register a handler for <prefix><command>
+ * @note command must outlive the router, a string literal in practice
+ * @note Registration only, dispatch() reads the routes without the lock
+ * @return false once the router is sealed
+ */
+bool CommandRouter::on(const char* command, Handler_t handler) {
+  if (_sealed) {
+    log_e("[Command Router]: %s registered after begin, ignored", command);
+    return false;
+  }
+  Route_t route = {command, strlen(command), handler};
+  auto it = std::lower_bound(
+      _routes.begin(), _routes.end(), route,
+      [](const Route_t& a, const Route_t& b) {
+        return compare(a.command, a.length, b.command, b.length) < 0;
+      });
+  if (it != _routes.end() &&
+      compare(it->command, it->length, command, route.length) == 0) {
+    it->handler = handler;
+    return true;
+  }
+  _routes.insert(it, route);
+  return true;
+}
+
+//* No more routes, called before the MQTT task can dispatch
+void CommandRouter::seal() {
+  _sealed = true;
+}
+
+//* Topic prefix the commands live under, set when the topic table changes
+void CommandRouter::setPrefix(std::string_view prefix) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _prefix.assign(prefix.data(), prefix.size());
+}
+
+/**
+ * @brief Route one inbound message
+ * @return true when a handler was found
+ */
+bool CommandRouter::dispatch(const char* topic,
+                             size_t topicLength,
+                             const char* payload,
+                             size_t length) {
+  size_t prefixLength;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    prefixLength = _prefix.length();
+    if (prefixLength == 0 || topicLength <= prefixLength ||
+        memcmp(topic, _prefix.data(), prefixLength) != 0)
+      prefixLength = 0;
+  }
+  if (prefixLength == 0) {
+    _unmatched++;
+    return false;
+  }
+
+  const char* command = topic + prefixLength;
+  size_t commandLength = topicLength - prefixLength;
+  size_t low = 0;
+  size_t high = _routes.size();
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    int result = compare(_routes[mid].command, _routes[mid].length, command,
+                         commandLength);
+    if (result == 0) {
+      _dispatched++;
+      _routes[mid].handler(payload, length);
+      return true;
+    }
+    if (result < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  _unmatched++;
+  log_w("[Command Router]: No handler for %.*s", (int)commandLength, command);
+  return false;
+}
+
+bool CommandRouter::parseBool(const char* payload, size_t length, bool& value) {
+  static const char* const truthy[] = {"1", "true", "on"};
+  static const char* const falsy[] = {"0", "false", "off"};
+  for (auto word : truthy) {
+    if (strlen(word) == length && strncasecmp(payload, word, length) == 0) {
+      value = true;
+      return true;
+    }
+  }
+  for (auto word : falsy) {
+    if (strlen(word) == length && strncasecmp(payload, word, length) == 0) {
+      value = false;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CommandRouter::parseUInt(const char* payload,
+                              size_t length,
+                              uint32_t& value) {
+  if (length == 0 || length > 10)
+    return false;
+  uint64_t result = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (payload[i] < '0' || payload[i] > '9')
+      return false;
+    result = result * 10 + (payload[i] - '0');
+  }
+  if (result > UINT32_MAX)
+    return false;
+  value = result;
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef COMMANDROUTER_HPP
+#define COMMANDROUTER_HPP
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Inbound MQTT command dispatch
+ * @note Commands arrive on <hostname>/<tower_id>/cmd/<command>. Routes are
+ * registered once at startup and kept sorted by command name, an incoming
+ * topic is matched by comparing the prefix in place and binary searching the
+ * remainder. Handlers get a view of the payload straight from the client
+ * buffer, nothing is copied or allocated per message.
+ * @note dispatch() runs on the MQTT task while setPrefix() runs on the loop
+ * task, the prefix is guarded by a mutex. The routes are not, they are only
+ * registered before BaseMQTT::begin() seals the router and starts the
+ * session, on() is refused after that.
+ */
+class CommandRouter {
+ public:
+  using Handler_t = std::function<void(const char* payload, size_t length)>;
+
+ private:
+  struct Route_t {
+    const char* command;
+    size_t length;
+    Handler_t handler;
+  };
+
+  std::mutex _mutex;
+  std::string _prefix;
+  std::vector<Route_t> _routes;
+  bool _sealed;
+  uint32_t _dispatched;
+  uint32_t _unmatched;
+
+  static int compare(const char* a,
+                     size_t aLength,
+                     const char* b,
+                     size_t bLength);
+
+ public:
+  CommandRouter();
+  virtual ~CommandRouter();
+
+  bool on(const char* command, Handler_t handler);
+  void seal();
+  void setPrefix(std::string_view prefix);
+  bool dispatch(const char* topic,
+                size_t topicLength,
+                const char* payload,
+                size_t length);
+
+  uint32_t getDispatched() { return _dispatched; }
+  uint32_t getUnmatched() { return _unmatched; }
+
+  //* In place payload parsers, false when the payload is malformed
+  static bool parseBool(const char* payload, size_t length, bool& value);
+  static bool parseUInt(const char* payload, size_t length, uint32_t& value);
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "brokerdiscovery.hpp"
+#include <ESPmDNS.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <data/statemanager/state_manager.hpp>
+
+BrokerDiscovery::BrokerDiscovery(Clock& clock)
+    : _clock(clock),
+      _running(false),
+      _ready(false),
+      _requested(false),
+      _queried(false),
+      _queriedAt(0) {}
+
+BrokerDiscovery::~BrokerDiscovery() {}
+
+//* Ask for a new query, served by the next update() allowed to start one
+void BrokerDiscovery::request() {
+  _requested = true;
+}
+
+/**
+ * @brief Start a query when due, collect the results of a finished one
+ * @note Call from the loop task only
+ * @return true when a new broker list was collected
+ */
+bool BrokerDiscovery::update() {
+  if (_ready.exchange(false)) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _brokers.swap(_found);
+    _found.clear();
+    log_i("[mDNS Broker Discovery]: %u broker(s) found", _brokers.size());
+    return !_brokers.empty();
+  }
+
+  if (_running ||
+      wifiStateManager.getCurrentState() != WiFiState_e::WiFiState_Connected)
+    return false;
+
+  uint32_t now = _clock.millis();
+  bool expired = _queried && now - _queriedAt >= BROKER_DISCOVERY_TTL_MS;
+  bool spaced = !_queried || now - _queriedAt >= BROKER_DISCOVERY_RETRY_MS;
+  if (!(expired || (_requested && spaced)))
+    return false;
+
+  _requested = false;
+  _queried = true;
+  _queriedAt = now;
+  _running = true;
+  if (xTaskCreate(&BrokerDiscovery::task, "broker_mdns", 4096, this, 1,
+                  nullptr) != pdPASS) {
+    log_e("[mDNS Broker Discovery]: Could not start the query task");
+    _running = false;
+  }
+  return false;
+}
+
+void BrokerDiscovery::task(void* arg) {
+  BrokerDiscovery* self = static_cast<BrokerDiscovery*>(arg);
+  self->query();
+  self->_running = false;
+  vTaskDelete(nullptr);
+}
+
+//* Runs on the discovery task
+void BrokerDiscovery::query() {
+  log_i("[mDNS Broker Discovery]: Querying MQTT broker service...");
+  int n = MDNS.queryService("mqtt", "tcp");
+  if (n <= 0) {
+    log_w("[mDNS Broker Discovery]: No mqtt service found on the network");
+    return;
+  }
+
+  std::vector<Broker_t> found;
+  for (int i = 0; i < n; i++) {
+    Broker_t broker;
+    IPAddress ip = MDNS.IP(i);
+    broker.host.assign(ip.toString().c_str());
+    broker.port = MDNS.port(i);
+
+    WiFiClient client;
+    uint32_t start = millis();
+    broker.rtt = client.connect(ip, broker.port, BROKER_DISCOVERY_PROBE_MS)
+                     ? millis() - start
+                     : UINT32_MAX;
+    client.stop();
+    log_d("[mDNS Broker Discovery]: %s:%u answered in %u ms",
+          broker.host.c_str(), broker.port, broker.rtt);
+    found.push_back(broker);
+  }
+  std::stable_sort(found.begin(), found.end(),
+                   [](const Broker_t& a, const Broker_t& b) {
+                     return a.rtt < b.rtt;
+                   });
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _found.swap(found);
+  _ready = true;
+}
@@ -0,0 +1,65 @@
+#ifndef BROKERDISCOVERY_HPP
+#define BROKERDISCOVERY_HPP
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "local/data/clock/clock.hpp"
+
+//* How long a discovered broker list is trusted before it is queried again
+#ifndef BROKER_DISCOVERY_TTL_MS
+#define BROKER_DISCOVERY_TTL_MS 3600000UL
+#endif  // BROKER_DISCOVERY_TTL_MS
+
+//* Minimum spacing between two queries, caps the rate of failure re-queries
+#ifndef BROKER_DISCOVERY_RETRY_MS
+#define BROKER_DISCOVERY_RETRY_MS 30000UL
+#endif  // BROKER_DISCOVERY_RETRY_MS
+
+//* TCP connect timeout used to rank the brokers
+#ifndef BROKER_DISCOVERY_PROBE_MS
+#define BROKER_DISCOVERY_PROBE_MS 500
+#endif  // BROKER_DISCOVERY_PROBE_MS
+
+/**
+ * @brief Background mDNS discovery of _mqtt._tcp brokers
+ * @note The query and the ranking probes run on a short lived task started
+ * from update() once WiFi is up, the caller never blocks. Brokers are ranked
+ * by TCP connect time, unreachable ones last. The list is kept for
+ * BROKER_DISCOVERY_TTL_MS, or until request() asks for a new query.
+ * @note Nothing is queried until the first request()
+ */
+class BrokerDiscovery {
+ public:
+  struct Broker_t {
+    std::string host;
+    uint16_t port;
+    uint32_t rtt;  // ms, UINT32_MAX when the probe failed
+  };
+
+ private:
+  Clock& _clock;
+  std::mutex _mutex;
+  std::vector<Broker_t> _found;  // written by the task
+  std::vector<Broker_t> _brokers;
+  std::atomic<bool> _running;
+  std::atomic<bool> _ready;
+  bool _requested;
+  bool _queried;
+  uint32_t _queriedAt;
+
+  static void task(void* arg);
+  void query();
+
+ public:
+  explicit BrokerDiscovery(Clock& clock);
+  virtual ~BrokerDiscovery();
+
+  void request();
+  bool update();
+  const std::vector<Broker_t>& getBrokers() const { return _brokers; }
+  bool isRunning() const { return _running; }
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "hassdiscovery.hpp"
+#include <ArduinoJson.h>
+#include <algorithm>
+
+//* Must follow Telemetry::Channel_e, templates index the batched state document
+//* The water temperature is the mean of the probes that returned a number
+const Hass::Entity_t Hass::entities[Telemetry::CHANNEL_COUNT] = {
+    {"Light", "illuminance", "lx", "mdi:white-balance-sunny",
+     "{{ value_json.ldr }}", Topics::LDR},
+    {"Water stock", nullptr, "L", "mdi:water",
+     "{{ value_json.water_level_sensor }}", Topics::WATER_LEVEL},
+    {"Water level", nullptr, "%", "mdi:water-percent",
+     "{{ value_json.water_level_percentage }}",
+     Topics::WATER_LEVEL_PERCENTAGE},
+    {"Water temperature", "temperature", "°C", "mdi:coolant-temperature",
+     "{% set t = value_json.temperature | select('number') | list %}"
+     "{{ (t | sum / t | length) | round(2) if t else none }}",
+     Topics::TEMPERATURE},
+    {"DHT humidity", "humidity", "%", "mdi:water-percent",
+     "{{ value_json.humidity.dht_hum }}", Topics::HUMIDITY},
+    {"DHT temperature", "temperature", "°C", "mdi:thermometer-lines",
+     "{{ value_json.humidity.dht_temp }}", Topics::HUMIDITY},
+    {"SHT31 humidity", "humidity", "%", "mdi:water-percent",
+     "{{ value_json.humidity.sht31_1_hum }}", Topics::HUMIDITY},
+    {"SHT31 temperature", "temperature", "°C", "mdi:thermometer-lines",
+     "{{ value_json.humidity.sht31_1_temp }}", Topics::HUMIDITY},
+    {"SHT31 2 humidity", "humidity", "%", "mdi:water-percent",
+     "{{ value_json.humidity.sht31_2_hum }}", Topics::HUMIDITY},
+    {"SHT31 2 temperature", "temperature", "°C", "mdi:thermometer-lines",
+     "{{ value_json.humidity.sht31_2_temp }}", Topics::HUMIDITY},
+};
+
+HassDiscovery::HassDiscovery(GreenHouseConfig& config,
+                             ProjectConfig& projectConfig,
+                             BaseMQTT& mqtt)
+    : _config(config),
+      _projectConfig(projectConfig),
+      _mqtt(mqtt),
+      _built(false),
+      _revision(0),
+      _fingerprint(0),
+      _session(0),
+      _next(0) {}
+
+HassDiscovery::~HassDiscovery() {}
+
+void HassDiscovery::begin() {
+  _mqtt.getRouter().on("hass_discovery",
+                       [this](const char* payload, size_t length) {
+                         bool enabled;
+                         if (CommandRouter::parseBool(payload, length, enabled))
+                           _config.setHassDiscovery(enabled);
+                       });
+}
+
+/**
+ * @brief Rebuild on config change, then send what is pending
+ * @note The config revision and the topics are the only inputs, so steady
+ * state costs three comparisons per call. A rebuild that yields the
+ * same messages does not trigger a republish.
+ */
+void HassDiscovery::loop() {
+  const MQTTTopic_t& stateTopic = _mqtt.getDeviceTopic();
+  if (!_config.getMQTTConfig().hass_discovery) {
+    //* Turned off, withdraw what was announced
+    if (_messages.empty() && _removed.empty())
+      return;
+    for (auto& message : _messages) {
+      _removed.push_back(message.topic);
+    }
+    _messages.clear();
+    _built = false;
+    _fingerprint = 0;
+  } else if (!_built || _revision != _config.getRevision() ||
+             stateTopic != _stateTopic ||
+             _mqtt.getTopics().getPrefix() != _prefix) {
+    _built = true;
+    _revision = _config.getRevision();
+    _stateTopic.assign(stateTopic.data(), stateTopic.size());
+    const MQTTTopic_t& prefix = _mqtt.getTopics().getPrefix();
+    _prefix.assign(prefix.data(), prefix.size());
+    uint32_t fingerprint = _fingerprint;
+    build();
+    if (_fingerprint != fingerprint)
+      _next = 0;
+  }
+
+  if (_mqtt.getState() != MQTTState_e::MQTTState_Connected)
+    return;
+
+  //* New session, announce everything again
+  if (_session != _mqtt.getSessionCount()) {
+    _session = _mqtt.getSessionCount();
+    _next = 0;
+  }
+
+  if (!_removed.empty()) {
+    _mqtt.publishRetained(MQTTTopic_t(_removed.back()), std::string_view());
+    _removed.pop_back();
+    return;
+  }
+
+  if (_next < _messages.size()) {
+    const Message_t& message = _messages[_next++];
+    _mqtt.publishRetained(MQTTTopic_t(message.topic), message.payload);
+    if (_next == _messages.size())
+      log_i("[HASS Discovery]: Announced %u entities", _messages.size());
+  }
+}
+
+/**
+ * @brief Build the config messages of the enabled channels
+ * @note Topics that were announced before and are no longer built are queued
+ * for removal
+ */
+void HassDiscovery::build() {
+  std::vector<Message_t> previous;
+  previous.swap(_messages);
+  _fingerprint = 2166136261UL;
+
+  Source_e from = source();
+  if (from == NO_SOURCE) {
+    for (auto& message : previous) {
+      _removed.push_back(message.topic);
+    }
+    return;
+  }
+
+  const std::string node = nodeId(_projectConfig.getMDNSConfig().hostname);
+  const std::string tower = nodeId(_config.getMQTTConfig().tower_id);
+  const std::string device = node + "_" + tower;
+
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    Telemetry::Channel_e channel = static_cast<Telemetry::Channel_e>(c);
+    if (!channelEnabled(channel))
+      continue;
+    const Hass::Entity_t& entity = Hass::entities[c];
+    std::string object = tower + "_" + Telemetry::channelName(channel);
+
+    StaticJsonDocument<768> doc;
+    doc["name"] = entity.name;
+    doc["uniq_id"] = node + "_" + object;
+    doc["obj_id"] = node + "_" + object;
+    if (from == STATE_DOCUMENT) {
+      doc["stat_t"] = _stateTopic;
+      doc["val_tpl"] = entity.value_template;
+    } else {
+      const MQTTTopic_t& topic = _mqtt.getTopics().get(entity.topic);
+      doc["stat_t"] = std::string(topic.data(), topic.size());
+      //* The temperature and humidity topics carry the member of the state
+      //* document without its braces, the others a bare number
+      if (entity.topic == Topics::TEMPERATURE ||
+          entity.topic == Topics::HUMIDITY)
+        doc["val_tpl"] =
+            std::string("{% set value_json = ('{' ~ value ~ '}') | "
+                        "from_json %}") +
+            entity.value_template;
+      else
+        doc["val_tpl"] = "{{ value | float(none) }}";
+    }
+    doc["unit_of_meas"] = entity.unit;
+    if (entity.device_class)
+      doc["dev_cla"] = entity.device_class;
+    doc["stat_cla"] = "measurement";
+    doc["ic"] = entity.icon;
+    JsonObject dev = doc.createNestedObject("dev");
+    dev.createNestedArray("ids").add(device);
+    dev["name"] = _projectConfig.getMDNSConfig().hostname + " tower " +
+                  _config.getMQTTConfig().tower_id;
+    dev["mf"] = "ESP32GreenHouseTowerDIY";
+
+    Message_t message;
+    message.topic = "homeassistant/sensor/" + node + "/" + object + "/config";
+    serializeJson(doc, message.payload);
+    _fingerprint = fnv1a(_fingerprint, message.topic);
+    _fingerprint = fnv1a(_fingerprint, message.payload);
+    _messages.push_back(message);
+  }
+
+  for (auto& message : previous) {
+    auto it = std::find_if(
+        _messages.begin(), _messages.end(),
+        [&message](const Message_t& m) { return m.topic == message.topic; });
+    if (it == _messages.end())
+      _removed.push_back(message.topic);
+  }
+  log_d("[HASS Discovery]: %u entities built, %u removed", _messages.size(),
+        _removed.size());
+}
+
+/**
+ * @brief Where the entities read their values from
+ * @note Home Assistant templates cannot read CBOR. The JSON state document
+ * is preferred, the per sensor topics are used when it is not sent.
+ */
+HassDiscovery::Source_e HassDiscovery::source() {
+  Project_Config::MQTTConfig_t& mqtt = _config.getMQTTConfig();
+  if (mqtt.publish_mode != GreenHouseConfig::MqttPublish_t::PER_SENSOR &&
+      mqtt.encoding != GreenHouseConfig::Encoding_t::ENCODING_CBOR)
+    return STATE_DOCUMENT;
+  if (mqtt.publish_mode != GreenHouseConfig::MqttPublish_t::BATCHED)
+    return SENSOR_TOPICS;
+  log_w("[HASS Discovery]: Disabled, only a CBOR state document is sent");
+  return NO_SOURCE;
+}
+
+bool HassDiscovery::channelEnabled(Telemetry::Channel_e channel) {
+  Project_Config::EnabledFeatures_t& features = _config.getEnabledFeatures();
+  bool dht = false;
+  bool sht31 = false;
+  bool sht31_2 = false;
+  switch (features.humidity_features) {
+    case GreenHouseConfig::HumidityFeatures_t::SHT31:
+      sht31 = true;
+      break;
+    case GreenHouseConfig::HumidityFeatures_t::SHT31_2:
+      sht31_2 = true;
+      break;
+    case GreenHouseConfig::HumidityFeatures_t::BOTH_HUMIDITY:
+      sht31 = sht31_2 = true;
+      break;
+    case GreenHouseConfig::HumidityFeatures_t::DHT:
+      dht = true;
+      break;
+    case GreenHouseConfig::HumidityFeatures_t::DHT_SHT31:
+      dht = sht31 = true;
+      break;
+    case GreenHouseConfig::HumidityFeatures_t::DHT_SHT31_2:
+      dht = sht31_2 = true;
+      break;
+    default:
+      break;
+  }
+
+  switch (channel) {
+    case Telemetry::LDR:
+      return features.ldr_features != GreenHouseConfig::LDRFeatures_t::NONE_LDR;
+    case Telemetry::WATER_LEVEL:
+    case Telemetry::WATER_LEVEL_PERCENTAGE:
+      return features.water_Level_features !=
+             GreenHouseConfig::WaterLevelFeatures_t::NONE_WATER_LEVEL;
+    case Telemetry::TOWER_TEMP:
+      return true;
+    case Telemetry::DHT_HUM:
+    case Telemetry::DHT_TEMP:
+      return dht;
+    case Telemetry::SHT31_1_HUM:
+    case Telemetry::SHT31_1_TEMP:
+      return sht31;
+    case Telemetry::SHT31_2_HUM:
+    case Telemetry::SHT31_2_TEMP:
+      return sht31_2;
+    default:
+      return false;
+  }
+}
+
+//* Discovery ids only allow [a-zA-Z0-9_-]
+std::string HassDiscovery::nodeId(const std::string& hostname) {
+  std::string id(hostname);
+  for (auto& c : id) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+      c = '_';
+  }
+  return id;
+}
+
+uint32_t HassDiscovery::fnv1a(uint32_t hash, const std::string& data) {
+  for (auto c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
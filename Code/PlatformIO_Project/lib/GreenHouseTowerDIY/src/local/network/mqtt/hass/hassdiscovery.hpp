@@ -0,0 +1,81 @@
+#ifndef HASSDISCOVERY_HPP
+#define HASSDISCOVERY_HPP
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "local/data/config/config.hpp"
+#include "local/data/telemetry/telemetry.hpp"
+#include "local/network/mqtt/basic/basicmqtt.hpp"
+
+namespace Hass {
+  //* Static description of one telemetry channel as a Home Assistant sensor
+  struct Entity_t {
+    const char* name;
+    const char* device_class;  // nullptr when none applies
+    const char* unit;
+    const char* icon;
+    const char* value_template;  // reads the batched state document
+    Topics::Topic_e topic;       // per sensor topic carrying the channel
+  };
+
+  //* Must follow Telemetry::Channel_e
+  extern const Entity_t entities[Telemetry::CHANNEL_COUNT];
+}  // namespace Hass
+
+/**
+ * @brief Home Assistant MQTT discovery
+ * @note Announces every enabled channel as
+ * homeassistant/sensor/<hostname>/<tower_id>_<channel>/config, reading its
+ * value out of the telemetry the tower already publishes, so no extra
+ * messages are sent. That is the batched state document when it is JSON,
+ * otherwise the per sensor topics. A tower that only sends CBOR state
+ * documents announces nothing.
+ * @note The config messages are built once per feature configuration and
+ * kept as ready to send strings. They are only (re)published when a new MQTT
+ * session comes up or when the rebuilt set differs from the published one,
+ * one message per loop() call. Entities that disappear with a feature change
+ * get their retained config cleared.
+ */
+class HassDiscovery {
+  enum Source_e : uint8_t {
+    NO_SOURCE,
+    STATE_DOCUMENT,
+    SENSOR_TOPICS,
+  };
+
+  struct Message_t {
+    std::string topic;
+    std::string payload;
+  };
+
+  GreenHouseConfig& _config;
+  ProjectConfig& _projectConfig;
+  BaseMQTT& _mqtt;
+  std::vector<Message_t> _messages;
+  std::vector<std::string> _removed;
+  bool _built;
+  uint32_t _revision;
+  std::string _stateTopic;
+  std::string _prefix;
+  uint32_t _fingerprint;
+  uint32_t _session;
+  size_t _next;
+
+  bool channelEnabled(Telemetry::Channel_e channel);
+  Source_e source();
+  void build();
+  static std::string nodeId(const std::string& hostname);
+  static uint32_t fnv1a(uint32_t hash, const std::string& data);
+
+ public:
+  HassDiscovery(GreenHouseConfig& config,
+                ProjectConfig& projectConfig,
+                BaseMQTT& mqtt);
+  virtual ~HassDiscovery();
+
+  void begin();
+  void loop();
+  size_t getEntityCount() const { return _messages.size(); }
+};
+
+#endif
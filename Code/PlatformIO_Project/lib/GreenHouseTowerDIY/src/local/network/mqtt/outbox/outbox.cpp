@@ -0,0 +1,164 @@
+#include "outbox.hpp"
+
+MQTTOutbox::MQTTOutbox(GreenHouseConfig& config, const char* spillPath)
+    : _config(config),
+      _spillPath(spillPath),
+      _head(0),
+      _count(0),
+      _spillReady(false),
+      _spillRead(0),
+      _spillSize(0),
+      _dropped(0) {}
+
+MQTTOutbox::~MQTTOutbox() {}
+
+/**
+ * @brief Mount SPIFFS when spilling is enabled
+ * @note A spill file left over from before a reboot is replayed as well
+ */
+void MQTTOutbox::begin() {
+  if (!_config.getMQTTConfig().outbox_spill)
+    return;
+  //* Never format here, that would wipe the other SPIFFS files
+  if (!SPIFFS.begin(false)) {
+    log_e("[MQTT Outbox]: Unable to mount SPIFFS, spilling disabled");
+    return;
+  }
+  _spillReady = true;
+  if (SPIFFS.exists(_spillPath)) {
+    File file = SPIFFS.open(_spillPath, FILE_READ);
+    _spillSize = file.size();
+    file.close();
+    log_i("[MQTT Outbox]: %u bytes of queued documents from a previous run",
+          _spillSize);
+  }
+}
+
+//* Ring slot of the index-th oldest entry
+size_t MQTTOutbox::slot(size_t index) const {
+  return (_head + OUTBOX_RAM_SLOTS - _count + index) % OUTBOX_RAM_SLOTS;
+}
+
+/**
+ * @brief Queue a cycle document that could not be published
+ */
+void MQTTOutbox::push(uint32_t timestamp, const char* payload, size_t length) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_count == OUTBOX_RAM_SLOTS) {
+    Entry_t& oldest = _entries[slot(0)];
+    if (_spillReady && spill(oldest)) {
+      _count--;
+    } else if (_config.getMQTTConfig().outbox_policy ==
+               GreenHouseConfig::OutboxPolicy_t::OUTBOX_DOWNSAMPLE) {
+      downsample();
+    } else {
+      _count--;
+      _dropped++;
+    }
+  }
+
+  Entry_t& entry = _entries[_head];
+  entry.timestamp = timestamp;
+  entry.payload.assign(payload, length);
+  _head = (_head + 1) % OUTBOX_RAM_SLOTS;
+  _count++;
+}
+
+/**
+ * @brief Take the oldest queued document
+ * @return false when the outbox is empty
+ */
+bool MQTTOutbox::pop(uint32_t& timestamp, std::string& payload) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_spillReady && _spillRead < _spillSize &&
+      readSpill(timestamp, payload))
+    return true;
+
+  if (_count == 0)
+    return false;
+  Entry_t& entry = _entries[slot(0)];
+  timestamp = entry.timestamp;
+  payload.swap(entry.payload);
+  entry.payload.clear();
+  _count--;
+  return true;
+}
+
+//* Append the entry to the spill file, false once the file is full
+bool MQTTOutbox::spill(const Entry_t& entry) {
+  uint16_t length = std::min<size_t>(entry.payload.length(), UINT16_MAX);
+  size_t record = sizeof(entry.timestamp) + sizeof(length) + length;
+  if (_spillSize + record > OUTBOX_SPILL_BYTES)
+    return false;
+
+  File file = SPIFFS.open(_spillPath, FILE_APPEND);
+  if (!file)
+    return false;
+  bool ok =
+      file.write(reinterpret_cast<const uint8_t*>(&entry.timestamp),
+                 sizeof(entry.timestamp)) == sizeof(entry.timestamp) &&
+      file.write(reinterpret_cast<const uint8_t*>(&length), sizeof(length)) ==
+          sizeof(length) &&
+      file.write(reinterpret_cast<const uint8_t*>(entry.payload.data()),
+                 length) == length;
+  file.close();
+  if (ok)
+    _spillSize += record;
+  return ok;
+}
+
+//* Read the next spilled entry, the file is removed once fully drained
+bool MQTTOutbox::readSpill(uint32_t& timestamp, std::string& payload) {
+  File file = SPIFFS.open(_spillPath, FILE_READ);
+  bool ok = file && file.seek(_spillRead);
+  uint16_t length = 0;
+  ok = ok &&
+       file.read(reinterpret_cast<uint8_t*>(&timestamp), sizeof(timestamp)) ==
+           sizeof(timestamp) &&
+       file.read(reinterpret_cast<uint8_t*>(&length), sizeof(length)) ==
+           sizeof(length);
+  if (ok) {
+    payload.resize(length);
+    ok = file.read(reinterpret_cast<uint8_t*>(&payload[0]), length) == length;
+  }
+  if (file)
+    file.close();
+
+  if (ok)
+    _spillRead += sizeof(timestamp) + sizeof(length) + length;
+  if (!ok || _spillRead >= _spillSize) {
+    //* Drained, or a torn tail from a power loss
+    SPIFFS.remove(_spillPath);
+    _spillRead = 0;
+    _spillSize = 0;
+  }
+  return ok;
+}
+
+//* Keep every other queued entry, oldest first
+void MQTTOutbox::downsample() {
+  size_t kept = 0;
+  for (size_t i = 0; i < _count; i += 2) {
+    if (kept != i)
+      _entries[slot(kept)] = std::move(_entries[slot(i)]);
+    kept++;
+  }
+  for (size_t i = kept; i < _count; i++) {
+    _entries[slot(i)].payload.clear();
+  }
+  _dropped += _count - kept;
+  size_t tail = slot(0);
+  _count = kept;
+  _head = (tail + _count) % OUTBOX_RAM_SLOTS;
+  log_w("[MQTT Outbox]: Full, backlog downsampled to %u documents", _count);
+}
+
+size_t MQTTOutbox::size() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _count;
+}
+
+uint32_t MQTTOutbox::getDropped() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _dropped;
+}
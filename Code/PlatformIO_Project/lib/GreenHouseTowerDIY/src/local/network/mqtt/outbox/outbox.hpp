@@ -0,0 +1,67 @@
+#ifndef OUTBOX_HPP
+#define OUTBOX_HPP
+#include <Arduino.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <mutex>
+#include <string>
+#include "local/data/config/config.hpp"
+
+//* Cycle documents held in RAM while the broker is unreachable
+#ifndef OUTBOX_RAM_SLOTS
+#define OUTBOX_RAM_SLOTS 32
+#endif  // OUTBOX_RAM_SLOTS
+
+//* Upper bound of the optional SPIFFS spill file
+#ifndef OUTBOX_SPILL_BYTES
+#define OUTBOX_SPILL_BYTES 65536
+#endif  // OUTBOX_SPILL_BYTES
+
+/**
+ * @brief Store-and-forward queue for cycle documents
+ * @note Documents are kept in a fixed ring of RAM slots. When the ring is
+ * full and spilling is enabled the oldest slot is appended to a SPIFFS file
+ * (timestamp u32 | length u16 | payload), once the file reaches
+ * OUTBOX_SPILL_BYTES the drop policy applies:
+ *  - OUTBOX_DROP_OLDEST discards the oldest document
+ *  - OUTBOX_DOWNSAMPLE drops every other queued document, halving the
+ * resolution of the backlog but keeping the whole outage covered
+ * @note pop() hands back the oldest document first, spilled ones before the
+ * RAM ring. Payloads carry their own timestamp so a late delivery keeps the
+ * original acquisition time, documents queued before the first NTP sync are
+ * dated by their uptime field instead.
+ */
+class MQTTOutbox {
+  struct Entry_t {
+    uint32_t timestamp;
+    std::string payload;
+  };
+
+  GreenHouseConfig& _config;
+  const char* _spillPath;
+  std::mutex _mutex;
+  Entry_t _entries[OUTBOX_RAM_SLOTS];
+  size_t _head;
+  size_t _count;
+  bool _spillReady;
+  size_t _spillRead;
+  size_t _spillSize;
+  uint32_t _dropped;
+
+  size_t slot(size_t index) const;
+  bool spill(const Entry_t& entry);
+  bool readSpill(uint32_t& timestamp, std::string& payload);
+  void downsample();
+
+ public:
+  MQTTOutbox(GreenHouseConfig& config, const char* spillPath = "/outbox.bin");
+  virtual ~MQTTOutbox();
+
+  void begin();
+  void push(uint32_t timestamp, const char* payload, size_t length);
+  bool pop(uint32_t& timestamp, std::string& payload);
+  size_t size();
+  uint32_t getDropped();
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "tlscredentials.hpp"
+#include <SPIFFS.h>
+
+TLSCredentials::TLSCredentials() : _valid(false) {}
+
+TLSCredentials::~TLSCredentials() {
+  release();
+}
+
+/**
+ * @brief Check the configured files, unless already done
+ * @return true when TLS is off or the credentials are present
+ */
+bool TLSCredentials::load(const Project_Config::MQTTConfig_t& mqtt) {
+  if (!mqtt.enable_certs) {
+    release();
+    return true;
+  }
+
+  std::string source = mqtt.ca_file + "|" + mqtt.cert_file + "|" +
+                       mqtt.key_file;
+  if (_valid && source == _source)
+    return true;
+  release();
+
+  //* Never format here, that would wipe the certificates
+  if (!SPIFFS.begin(false)) {
+    log_e("[TLS Credentials]: Unable to mount SPIFFS");
+    return false;
+  }
+  if (!present(mqtt.ca_file)) {
+    log_e("[TLS Credentials]: Unable to read %s", mqtt.ca_file.c_str());
+    return false;
+  }
+  //* Client authentication is optional, but certificate and key go together
+  bool cert = !mqtt.cert_file.empty() && present(mqtt.cert_file);
+  bool key = !mqtt.key_file.empty() && present(mqtt.key_file);
+  if (cert != key) {
+    log_e("[TLS Credentials]: Client certificate and key must come together");
+    return false;
+  }
+
+  log_i("[TLS Credentials]: CA%s present", cert ? ", certificate and key" : "");
+  _valid = true;
+  _source.swap(source);
+  return true;
+}
+
+void TLSCredentials::release() {
+  _source.clear();
+  _valid = false;
+}
+
+//* Exists and is not empty
+bool TLSCredentials::present(const std::string& path) {
+  if (path.empty())
+    return false;
+  std::string name = path[0] == '/' ? path : "/" + path;
+  File file = SPIFFS.open(name.c_str(), FILE_READ);
+  if (!file)
+    return false;
+  size_t size = file.size();
+  file.close();
+  return size > 0;
+}
@@ -0,0 +1,35 @@
+#ifndef TLSCREDENTIALS_HPP
+#define TLSCREDENTIALS_HPP
+#include <Arduino.h>
+#include <string>
+#include "local/data/config/config.hpp"
+
+/**
+ * @brief Pre-flight check of the MQTT TLS credential files
+ * @note The client reads and parses the certificate files itself on every
+ * handshake. This only checks that the configured files are present and not
+ * empty, so a missing file backs off instead of costing a handshake attempt.
+ * Nothing is parsed or kept in RAM.
+ * @note No TLS session resumption: MQTTClient builds the esp-mqtt
+ * configuration from the file paths, and the esp-mqtt of this framework has
+ * no way to hand a saved esp-tls session back to a connect. Every connect
+ * is a full handshake.
+ * @note The files are checked again when their paths change, or on the next
+ * attempt when the last check failed.
+ */
+class TLSCredentials {
+  std::string _source;
+  bool _valid;
+
+  static bool present(const std::string& path);
+
+ public:
+  TLSCredentials();
+  virtual ~TLSCredentials();
+
+  bool load(const Project_Config::MQTTConfig_t& mqtt);
+  void release();
+  bool isValid() const { return _valid; }
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "topicfilter.hpp"
+
+namespace Topics {
+  bool matches(std::string_view filter, std::string_view topic) {
+    size_t f = 0;
+    size_t t = 0;
+    while (f < filter.length()) {
+      if (filter[f] == '#')
+        return true;
+      if (filter[f] == '+') {
+        while (t < topic.length() && topic[t] != '/')
+          t++;
+        f++;
+        continue;
+      }
+      if (t >= topic.length())
+        return filter.substr(f) == "/#";
+      if (filter[f] != topic[t])
+        return false;
+      f++;
+      t++;
+    }
+    return t == topic.length();
+  }
+}  // namespace Topics
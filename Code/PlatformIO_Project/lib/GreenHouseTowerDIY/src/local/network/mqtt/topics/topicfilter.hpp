@@ -0,0 +1,14 @@
+#ifndef TOPICFILTER_HPP
+#define TOPICFILTER_HPP
+#include <Arduino.h>
+#include <string_view>
+
+namespace Topics {
+  /**
+   * @brief MQTT topic filter match, + is one level and # the remaining levels
+   * @note A trailing /# also matches the parent level, a/# matches a
+   */
+  bool matches(std::string_view filter, std::string_view topic);
+}  // namespace Topics
+
+#endif  // TOPICFILTER_HPP
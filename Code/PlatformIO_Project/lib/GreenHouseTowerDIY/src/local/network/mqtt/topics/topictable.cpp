@@ -0,0 +1,89 @@
+#include "topictable.hpp"
+
+namespace Topics {
+  //* Must follow the order of Topic_e, sensor entries match getSensorName()
+  const char* const topic_names[TOPIC_COUNT] = {
+      "ntp",
+      "ldr",
+      "water_level_sensor",
+      "water_level_percentage",
+      "temperature",
+      "humidity",
+      "state",
+      "status",
+      "cmd/#",
+      "state/cbor",
+      "state/backlog",
+      "state/backlog/cbor",
+  };
+}  // namespace Topics
+
+TopicTable::TopicTable(GreenHouseConfig& config, ProjectConfig& projectConfig)
+    : _config(config), _projectConfig(projectConfig), _revision(0) {}
+
+TopicTable::~TopicTable() {}
+
+/**
+ * @brief Rebuild the table if the configuration changed since the last build
+ * @return true when the topics were rebuilt
+ */
+bool TopicTable::refresh() {
+  const std::string& hostname = _projectConfig.getMDNSConfig().hostname;
+  if (!_prefix.empty() && _revision == _config.getRevision() &&
+      _hostname == hostname)
+    return false;
+  _revision = _config.getRevision();
+  _hostname.assign(hostname);
+  build();
+  return true;
+}
+
+//* Topics longer than MQTT_TOPIC_SIZE are truncated and logged
+void TopicTable::build() {
+  Project_Config::MQTTConfig_t& mqtt = _config.getMQTTConfig();
+  bool fits = _prefix.assign(_hostname);
+  fits &= _prefix.append("/");
+  fits &= _prefix.append(mqtt.tower_id);
+  fits &= _prefix.append("/");
+
+  for (uint8_t t = 0; t < Topics::TOPIC_COUNT; t++) {
+    _topics[t].assign(_prefix);
+    fits &= _topics[t].append(Topics::topic_names[t]);
+  }
+  if (!mqtt.device_topic.empty()) {
+    fits &= _topics[Topics::STATE].assign(mqtt.device_topic);
+    fits &= _topics[Topics::STATE_CBOR].assign(mqtt.device_topic);
+    fits &= _topics[Topics::STATE_CBOR].append("/cbor");
+    fits &= _topics[Topics::BACKLOG].assign(mqtt.device_topic);
+    fits &= _topics[Topics::BACKLOG].append("/backlog");
+    fits &= _topics[Topics::BACKLOG_CBOR].assign(mqtt.device_topic);
+    fits &= _topics[Topics::BACKLOG_CBOR].append("/backlog/cbor");
+  }
+
+  for (uint8_t c = 0; c < Telemetry::CHANNEL_COUNT; c++) {
+    _history[c].assign(_prefix);
+    fits &= _history[c].append("history/");
+    fits &= _history[c].append(Telemetry::channel_names[c]);
+  }
+  if (!fits)
+    log_e("[Topic Table]: Topics longer than %u characters were truncated",
+          MQTT_TOPIC_SIZE);
+
+  _subscriptions.clear();
+  for (auto& topic : mqtt.sub_topics) {
+    _subscriptions.push_back(std::string(_prefix.view()) + topic);
+  }
+  log_i("[Topic Table]: Topics under %s", _prefix.c_str());
+}
+
+const MQTTTopic_t& TopicTable::get(Topics::Topic_e topic) const {
+  return _topics[topic < Topics::TOPIC_COUNT ? topic : Topics::STATE];
+}
+
+const MQTTTopic_t& TopicTable::history(Telemetry::Channel_e channel) const {
+  return _history[channel < Telemetry::CHANNEL_COUNT ? channel : 0];
+}
+
+const std::vector<std::string>& TopicTable::subscriptions() const {
+  return _subscriptions;
+}
@@ -0,0 +1,70 @@
+#ifndef TOPICTABLE_HPP
+#define TOPICTABLE_HPP
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "local/data/config/config.hpp"
+#include "local/data/fixedstring/fixedstring.hpp"
+#include "local/data/telemetry/telemetry.hpp"
+
+//* Longest topic the table holds, <hostname>/<tower_id>/<name> included
+#ifndef MQTT_TOPIC_SIZE
+#define MQTT_TOPIC_SIZE 128
+#endif  // MQTT_TOPIC_SIZE
+
+typedef FixedString<MQTT_TOPIC_SIZE> MQTTTopic_t;
+
+namespace Topics {
+  //* One publish topic per sensor, plus the device level topics
+  enum Topic_e : uint8_t {
+    NTP,
+    LDR,
+    WATER_LEVEL,
+    WATER_LEVEL_PERCENTAGE,
+    TEMPERATURE,
+    HUMIDITY,
+    STATE,
+    STATUS,
+    COMMANDS,
+    STATE_CBOR,
+    BACKLOG,
+    BACKLOG_CBOR,
+    TOPIC_COUNT
+  };
+
+  extern const char* const topic_names[TOPIC_COUNT];
+}  // namespace Topics
+
+/**
+ * @brief Interned MQTT topics of this tower
+ * @note Every topic lives under <hostname>/<tower_id>/ so towers sharing a
+ * broker never collide. The strings are built once and only rebuilt when the
+ * config revision or the hostname changes, the publish path just indexes the
+ * table and never concatenates.
+ * @note The topics are stored inline, the table never touches the heap once
+ * constructed
+ */
+class TopicTable {
+  GreenHouseConfig& _config;
+  ProjectConfig& _projectConfig;
+  uint32_t _revision;
+  std::string _hostname;
+  MQTTTopic_t _prefix;
+  MQTTTopic_t _topics[Topics::TOPIC_COUNT];
+  MQTTTopic_t _history[Telemetry::CHANNEL_COUNT];
+  std::vector<std::string> _subscriptions;
+
+  void build();
+
+ public:
+  TopicTable(GreenHouseConfig& config, ProjectConfig& projectConfig);
+  virtual ~TopicTable();
+
+  bool refresh();
+  const MQTTTopic_t& get(Topics::Topic_e topic) const;
+  const MQTTTopic_t& history(Telemetry::Channel_e channel) const;
+  const std::vector<std::string>& subscriptions() const;
+  const MQTTTopic_t& getPrefix() const { return _prefix; }
+};
+
+#endif
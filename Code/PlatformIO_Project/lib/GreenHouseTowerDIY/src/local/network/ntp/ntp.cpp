@@ -1,4 +1,6 @@
 #include "ntp.hpp"
+#include <esp_sntp.h>
+#include <sys/time.h>
 
 const char NetworkNTP::ntpServerName[] = "us.pool.ntp.org";
 // static const char ntpServerName[] = "time.nist.gov";
@@ -17,18 +19,39 @@ const char NetworkNTP::ntpServerName[] = "us.pool.ntp.org";
  * @brief Get the current time MANUALLY
  *
  */
-NetworkNTP::NetworkNTP()
-    : _formattedDate(""),
-      _dayStamp(""),
-      _timeStamp(""),
+NetworkNTP* NetworkNTP::_instance = nullptr;
+
+NetworkNTP::NetworkNTP(Clock& clock)
+    : _clock(clock),
+      _offset(0),
+      _last(0),
+      _syncs(0),
+      _lastOffsetMs(0),
+      _jitterMs(0),
+      _lastSync(0),
       localPort(8888),
-      timeClient(ntpUDP),
+      timeZone(TIME_ZONE_OFFSET),
       prevDisplay(0) {}
 
+/**
+ * @brief Start background SNTP
+ * @note The system clock is used as is when it already holds a plausible
+ * time, e.g. after a software reset
+ */
 void NetworkNTP::begin() {
-  timeZone = TIME_ZONE_OFFSET;
-  timeClient.begin();
-  timeClient.setTimeOffset(timeZone);
+  _instance = this;
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  if (now.tv_sec >= COMPILE_UNIX_TIME) {
+    _offset = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000 -
+              _clock.micros() / 1000;
+    _syncs = 1;
+  }
+
+  sntp_set_time_sync_notification_cb(&NetworkNTP::onSync);
+  sntp_set_sync_interval(NTP_SYNC_INTERVAL_MS);
+  //* Epoch time stays UTC, the offset only applies to formatted strings
+  configTime(timeZone, 0, ntpServerName);
 }
 
 NetworkNTP::~NetworkNTP() {}
@@ -133,69 +156,104 @@ void NetworkNTP::sendNTPpacket(IPAddress& address) {
 }
 #else
 
-void NetworkNTP::ntpLoop() {
-  if (!timeClient.update()) {
-    timeClient.forceUpdate();
-  }
-  // The _formattedDate comes with the following format:
-  // 2022-05-28T16:00:13Z
-  // We need to extract date and time
-  _formattedDate = timeClient.getFormattedDate().c_str();
-  log_d("Formatted Date: %s", _formattedDate.c_str());
-  int splitT = _formattedDate.find("T");
-
-  if (splitT == std::string::npos) {
-    log_e("Error parsing date");
+/**
+ * @brief SNTP sync callback, runs on the lwIP task
+ * @note Offset is the synced time minus what the clock read just before,
+ * jitter its smoothed variation between syncs (RFC 3550 style, gain 1/16)
+ */
+void NetworkNTP::onSync(struct timeval* tv) {
+  NetworkNTP* self = _instance;
+  if (!self || !tv)
     return;
+  int64_t mono = self->_clock.micros() / 1000;
+  int64_t synced = (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+  int64_t previous = self->_offset;
+  int64_t offset = synced - mono;
+
+  if (self->_syncs > 0) {
+    int32_t error = (int32_t)(offset - previous);
+    int32_t change = error - self->_lastOffsetMs;
+    uint32_t jitter = self->_jitterMs;
+    jitter += ((int32_t)abs(change) - (int32_t)jitter) / 16;
+    self->_jitterMs = jitter;
+    self->_lastOffsetMs = error;
   }
+  self->_offset = offset;
+  self->_lastSync = tv->tv_sec;
+  self->_syncs++;
+  log_i("[NTP]: Synced, offset %d ms, jitter %u ms", (int)self->_lastOffsetMs,
+        (unsigned)self->_jitterMs);
+}
+
+/**
+ * @brief Epoch milliseconds, 0 until the first sync
+ * @note O(1), never decreases
+ */
+uint64_t NetworkNTP::getEpochMillis() {
+  if (_syncs == 0)
+    return 0;
+  uint64_t now = _clock.micros() / 1000 + _offset;
+  uint64_t last = _last;
+  while (now > last && !_last.compare_exchange_weak(last, now)) {
+  }
+  return now > last ? now : last;
+}
+
+/**
+ * @brief Seconds since the epoch, 0 until the first successful sync
+ */
+uint32_t NetworkNTP::getEpochTime() {
+  return getEpochMillis() / 1000;
+}
 
-  _dayStamp = _formattedDate.substr(0, splitT).c_str();
-  log_d("DATE: %s", _dayStamp.c_str());
-  _timeStamp =
-      _formattedDate.substr(splitT + 1, _formattedDate.length() - 1).c_str();
-  log_d("HOUR: %s", _timeStamp.c_str());
+//* Local time through strftime, empty until the first sync
+std::string NetworkNTP::format(const char* pattern) {
+  uint64_t millis = getEpochMillis();
+  if (millis == 0)
+    return std::string();
+  time_t seconds = millis / 1000;
+  struct tm local;
+  localtime_r(&seconds, &local);
+  char buffer[32];
+  size_t length = strftime(buffer, sizeof(buffer), pattern, &local);
+  return std::string(buffer, length);
 }
 
-const std::string& NetworkNTP::getFullDate() {
-  return _formattedDate;
+//* ISO 8601 with the UTC offset, e.g. 2022-05-28T16:00:13+0200
+std::string NetworkNTP::getFullDate() {
+  return format("%Y-%m-%dT%H:%M:%S%z");
 }
 
-const std::string& NetworkNTP::getDayStamp() {
-  return _dayStamp;
+std::string NetworkNTP::getDayStamp() {
+  return format("%Y-%m-%d");
 }
 
-const std::string& NetworkNTP::getTimeStamp() {
-  return _timeStamp;
+std::string NetworkNTP::getTimeStamp() {
+  return format("%H:%M:%S");
 }
 
-const std::string NetworkNTP::getYear() {
-  std::string year;
-  year.assign(timeClient.getFormattedDate().substring(0, 4).c_str());
-  return year;
+std::string NetworkNTP::getYear() {
+  return format("%Y");
 }
 
-const std::string NetworkNTP::getMonth() {
-  std::string month;
-  month.assign(timeClient.getFormattedDate().substring(5, 7).c_str());
-  return month;
+std::string NetworkNTP::getMonth() {
+  return format("%m");
 }
 
-const std::string NetworkNTP::getDay() {
-  std::string day;
-  day.assign(timeClient.getFormattedDate().substring(8, 10).c_str());
-  return day;
+std::string NetworkNTP::getDay() {
+  return format("%d");
 }
 #endif  // NTP_MANUAL_ENABLED
 
-const std::string& NetworkNTP::getSensorName() {
-  static std::string name = "ntp";
-  return name;
+std::string_view NetworkNTP::getSensorName() {
+  return "ntp";
 }
 
 void NetworkNTP::accept(Visitor<SensorInterface<std::string>>& visitor) {
   visitor.visit(this);
 }
 
+//* Full local date and time, formatted per read
 std::string NetworkNTP::read() {
-  return getTimeStamp();
+  return getFullDate();
 }
\ No newline at end of file
@@ -6,22 +6,36 @@
 #ifndef NETWORKNTP_hpp
 #define NETWORKNTP_hpp
 #include <Arduino.h>
-#include <NTPClient.h>
 #include <WiFiUdp.h>
+#include <atomic>
 #include <string>
+#include "local/data/clock/clock.hpp"
 #include "local/data/visitor.hpp"
 
+//* Background SNTP resync period, lwIP enforces a 15 s minimum
+#ifndef NTP_SYNC_INTERVAL_MS
+#define NTP_SYNC_INTERVAL_MS 3600000UL
+#endif  // NTP_SYNC_INTERVAL_MS
+
+/**
+ * @brief Wall clock for timestamps
+ * @note Epoch milliseconds are the injected monotonic clock plus an offset
+ * set by the SNTP sync callback, reading them is one addition. lwIP resyncs
+ * in the background every NTP_SYNC_INTERVAL_MS, nothing blocks the loop.
+ * Readings never go backwards, a sync that steps the clock back holds the
+ * time until it catches up. Human readable strings are only formatted when
+ * asked for.
+ */
 class NetworkNTP : public Element<Visitor<SensorInterface<std::string>>>,
                    public SensorInterface<std::string> {
  public:
   // constructors
-  NetworkNTP();
+  explicit NetworkNTP(Clock& clock);
   virtual ~NetworkNTP();
   // Functions
   void begin();
-  void ntpLoop();
   std::string read() override;
-  const std::string& getSensorName() override;
+  std::string_view getSensorName() override;
   void accept(Visitor<SensorInterface<std::string>>& visitor) override;
 #if NTP_MANUAL_ENABLED
   time_t getNtpTime();
@@ -29,20 +43,37 @@ class NetworkNTP : public Element<Visitor<SensorInterface<std::string>>>,
   void printDigits(int digits);
   void sendNTPpacket(IPAddress& address);
 #else
-  const std::string& getFullDate();
-  const std::string& getDayStamp();
-  const std::string& getTimeStamp();
-  const std::string getYear();
-  const std::string getMonth();
-  const std::string getDay();
+  std::string getFullDate();
+  std::string getDayStamp();
+  std::string getTimeStamp();
+  std::string getYear();
+  std::string getMonth();
+  std::string getDay();
+  uint32_t getEpochTime();
+  uint64_t getEpochMillis();
+  bool isSynced() const { return _syncs > 0; }
+
+  //* Sync metrics, offset is how far the clock was off at the last sync
+  int32_t getOffsetMs() const { return _lastOffsetMs; }
+  uint32_t getJitterMs() const { return _jitterMs; }
+  uint32_t getSyncCount() const { return _syncs; }
+  uint32_t getLastSync() const { return _lastSync; }
 #endif  // NTP_MANUAL_ENABLED
 
   // Private variables
  private:
-  // Variables to save date and time
-  std::string _formattedDate;
-  std::string _dayStamp;
-  std::string _timeStamp;
+  static NetworkNTP* _instance;
+  static void onSync(struct timeval* tv);
+  std::string format(const char* pattern);
+
+  Clock& _clock;
+  //* epoch ms minus clock ms
+  std::atomic<int64_t> _offset;
+  std::atomic<uint64_t> _last;
+  std::atomic<uint32_t> _syncs;
+  std::atomic<int32_t> _lastOffsetMs;
+  std::atomic<uint32_t> _jitterMs;
+  std::atomic<uint32_t> _lastSync;
 
   // NTP Servers:
   static const char ntpServerName[16];
@@ -51,6 +82,5 @@ class NetworkNTP : public Element<Visitor<SensorInterface<std::string>>>,
 
   time_t prevDisplay;  // when the digital clock was displayed
   WiFiUDP ntpUDP;
-  NTPClient timeClient;
 };
 #endif
@@ -1,13 +1,10 @@
 // TODO: Implement observer for humidity sensor
 // TODO: Implement pressure sensor for water level
 // TODO: Implement IR sensor for water level
-// TODO: Implement Home Assistant MQTT Support
-// TODO: Implement feature flag to enable/disable Home Assistant MQTT Support
 // TODO: Implement interfaces for the API - to use Serial, MQTT, HTTP, etc
 // TODO: Abstract API using the bridge pattern
 // TODO: Implement setting features using the API
 // Note: default to the REST API if no mqtt feature is enabled
-// Note: default to the basic mqtt if HASSIO support is disabled
 
 #include <Arduino.h>
 
@@ -19,10 +16,19 @@
 #include <local/network/api/rest_api.hpp>
 #include <network/mdns/mdns_manager.hpp>
 #include "local/network/mqtt/basic/basicmqtt.hpp"
+#include "local/network/mqtt/hass/hassdiscovery.hpp"
 
 //* Data
 #include <local/data/accumulatedata/accumulatedata.hpp>
+#include <local/data/clock/clock.hpp>
 #include <local/data/config/config.hpp>
+#include <local/data/history/esppartition.hpp>
+#include <local/data/history/flashlog.hpp>
+#include <local/data/history/historystore.hpp>
+#include <local/data/snapshot/datasnapshot.hpp>
+#if SENSOR_TRACE_REPLAY
+#include <local/data/replay/replayharness.hpp>
+#endif  // SENSOR_TRACE_REPLAY
 
 //*  Sensor Includes
 #include <local/io/sensors/humidity/humidity.hpp>
@@ -35,6 +41,17 @@
 
 //! Objects
 
+//* Time source, every scheduler reads it
+SystemClock systemClock;
+#if SENSOR_TRACE_REPLAY
+//* Sensors and acquisition follow the trace, see ReplayHarness
+VirtualClock replayClock;
+SensorTrace sensorTrace(replayClock);
+Clock& sensorClock = replayClock;
+#else
+Clock& sensorClock = systemClock;
+#endif  // SENSOR_TRACE_REPLAY
+
 //* Config
 ProjectConfig config("greenhouse", "tower");
 ConfigHandler configHandler(config);
@@ -43,18 +60,26 @@ GreenHouseConfig greenhouseConfig(config);
 //* Network
 WiFiHandler network(config, WIFI_SSID, WIFI_PASS, 1);
 MDNSHandler mDNS(config, "_tower", "data", "_tcp", "api_port", "80");
-NetworkNTP ntp;
+NetworkNTP ntp(systemClock);
 MQTTClient mqttClient;
-BaseMQTT mqtt(greenhouseConfig, config, mqttClient);
+MQTTOutbox outbox(greenhouseConfig);
+BaseMQTT mqtt(greenhouseConfig, config, mqttClient, outbox, systemClock);
+HassDiscovery hassDiscovery(greenhouseConfig, config, mqtt);
+
+//* Data
+DataSnapshot snapshot;
+HistoryStore history;
+EspPartition historyPartition("history");
+FlashLog flashLog(historyPartition);
 
 //* API
-RestAPI rest_api(config, greenhouseConfig);
+RestAPI rest_api(config, greenhouseConfig, snapshot, history);
 
 //* Sensors
 TowerTemp tower_temp(greenhouseConfig);
-Humidity humidity(greenhouseConfig);
-WaterLevelSensor waterLevelSensor(tower_temp);
-LDR ldr(greenhouseConfig);
+Humidity humidity(greenhouseConfig, sensorClock);
+WaterLevelSensor waterLevelSensor(tower_temp, sensorClock);
+LDR ldr(greenhouseConfig, sensorClock);
 
 //* Data
 AccumulateData data(greenhouseConfig,
@@ -64,7 +89,15 @@ AccumulateData data(greenhouseConfig,
                     humidity,
                     waterLevelSensor,
                     ntp,
-                    mqtt);
+                    mqtt,
+                    snapshot,
+                    history,
+                    flashLog,
+                    sensorClock);
+
+#if SENSOR_TRACE_REPLAY
+ReplayHarness replay(replayClock, sensorTrace, data, snapshot);
+#endif  // SENSOR_TRACE_REPLAY
 
 void setup() {
   Serial.begin(115200);
@@ -79,13 +112,28 @@ void setup() {
   //* Load Config from memory
   configHandler.begin();
 
+  //* Setup Data
+  history.begin();
+#if !SENSOR_TRACE_REPLAY
+  //* Replay builds leave the flash log closed, see ReplayHarness
+  if (flashLog.begin())
+    flashLog.replay(history);
+#endif  // SENSOR_TRACE_REPLAY
+
   //* Setup Sensors
+#if SENSOR_TRACE_REPLAY
+  sensorTrace.begin();
+#endif  // SENSOR_TRACE_REPLAY
   humidity.begin();
   tower_temp.begin();
 
   //* Setup Network Tasks
   network.begin();
   mDNS.begin();
+  outbox.begin();
+  //* Command routes first, mqtt.begin() seals the router
+  hassDiscovery.begin();
+  data.begin();
   mqtt.begin();
   rest_api.begin();
   ntp.begin();
@@ -97,9 +145,18 @@ void setup() {
  * 1. WiFi State
  * 2. OTA Updates
  * 3. Accumulate Data
- * 4. Background Tasks
+ * 4. MQTT Outbox
+ * 5. Home Assistant Discovery
+ * 6. Live Telemetry
+ * 7. Background Tasks
  */
 void loop() {
   Network_Utilities::checkWiFiState();  // check the WiFi state
   data.loop();                          // accumulate sensor data
+  mqtt.loop();                          // replay queued cycles
+  hassDiscovery.loop();                 // announce entities on (re)connect
+  rest_api.loop();                      // push live telemetry
+#if SENSOR_TRACE_REPLAY
+  replay.loop();  // report the cycle, move trace time on
+#endif  // SENSOR_TRACE_REPLAY
 }
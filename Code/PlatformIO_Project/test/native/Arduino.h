@@ -0,0 +1,27 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+//* Just enough of Arduino.h for the host tests, see [env:native]
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <string>
+
+using std::isinf;
+using std::isnan;
+
+#define log_e(format, ...)
+#define log_w(format, ...)
+#define log_i(format, ...)
+#define log_d(format, ...)
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+  return malloc(size);
+}
+
+#endif  // NATIVE_ARDUINO_H
@@ -0,0 +1,17 @@
+#ifndef NATIVE_ESP_ROM_CRC_H
+#define NATIVE_ESP_ROM_CRC_H
+#include <stddef.h>
+#include <stdint.h>
+
+//* CRC-32 as computed by the ESP32 ROM, the same as zlib.crc32
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, size_t len) {
+  crc = ~crc;
+  while (len-- > 0) {
+    crc ^= *buf++;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+#endif  // NATIVE_ESP_ROM_CRC_H
@@ -0,0 +1,174 @@
+#include <unity.h>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/network/mqtt/brokers/brokerpool.cpp>
+
+static VirtualClock testClock;
+
+void setUp() {
+  testClock.set(0);
+}
+void tearDown() {}
+
+static void assertBroker(const char* host,
+                         uint16_t port,
+                         const BrokerPool::Broker_t* broker) {
+  TEST_ASSERT_NOT_NULL(broker);
+  TEST_ASSERT_EQUAL_STRING(host, broker->host.c_str());
+  TEST_ASSERT_EQUAL_UINT16(port, broker->port);
+}
+
+void test_list_parsing() {
+  BrokerPool pool(testClock);
+  TEST_ASSERT_TRUE(
+      pool.configure("a;b:8883;;a:1883;c", "fallback", 1883, false, "t"));
+  TEST_ASSERT_EQUAL_size_t(3, pool.size());
+  assertBroker("a", 1883, &pool.getBrokers()[0]);
+  assertBroker("b", 8883, &pool.getBrokers()[1]);
+  assertBroker("c", 1883, &pool.getBrokers()[2]);
+  //* Same inputs, nothing to rebuild
+  TEST_ASSERT_FALSE(
+      pool.configure("a;b:8883;;a:1883;c", "fallback", 1883, false, "t"));
+}
+
+void test_fallback_without_list() {
+  BrokerPool pool(testClock);
+  pool.configure("", "fallback", 1884, false, "t");
+  TEST_ASSERT_EQUAL_size_t(1, pool.size());
+  assertBroker("fallback", 1884, pool.select());
+
+  BrokerPool empty(testClock);
+  empty.configure("", "", 1883, false, "t");
+  TEST_ASSERT_NULL(empty.select());
+}
+
+//* A failed broker is skipped until its cooldown, which doubles per failure
+void test_cooldown() {
+  BrokerPool pool(testClock);
+  pool.configure("a;b", "", 1883, false, "t");
+  assertBroker("a", 1883, pool.select());
+
+  pool.failed("a", 1883);
+  assertBroker("b", 1883, pool.select());
+  testClock.advance(BROKER_POOL_COOLDOWN_MS - 1);
+  assertBroker("b", 1883, pool.select());
+  testClock.advance(1);
+  assertBroker("a", 1883, pool.select());
+
+  pool.failed("a", 1883);
+  testClock.advance(BROKER_POOL_COOLDOWN_MS);
+  assertBroker("b", 1883, pool.select());
+  testClock.advance(BROKER_POOL_COOLDOWN_MS);
+  assertBroker("a", 1883, pool.select());
+
+  pool.connected("a", 1883);
+  TEST_ASSERT_EQUAL_UINT8(0, pool.getBrokers()[0].failures);
+  TEST_ASSERT_EQUAL_UINT32(1, pool.getBrokers()[0].sessions);
+}
+
+void test_cooldown_is_capped() {
+  BrokerPool pool(testClock);
+  pool.configure("a", "", 1883, false, "t");
+  for (int i = 0; i < 300; i++)
+    pool.failed("a", 1883);
+  TEST_ASSERT_EQUAL_UINT8(UINT8_MAX, pool.getBrokers()[0].failures);
+  TEST_ASSERT_EQUAL_UINT32(BROKER_POOL_MAX_COOLDOWN_MS,
+                           pool.getBrokers()[0].retryAt);
+}
+
+//* With every broker cooling down the one that recovers first is returned
+void test_all_failing() {
+  BrokerPool pool(testClock);
+  pool.configure("a;b", "", 1883, false, "t");
+  TEST_ASSERT_FALSE(pool.allFailing());
+  pool.failed("a", 1883);
+  pool.failed("a", 1883);
+  pool.failed("b", 1883);
+  TEST_ASSERT_TRUE(pool.allFailing());
+  assertBroker("b", 1883, pool.select());
+}
+
+//* millis() wraps after ~49 days, cooldowns keep working across it
+void test_cooldown_across_wrap() {
+  testClock.set((uint64_t)(UINT32_MAX - 1000) * 1000);
+  BrokerPool pool(testClock);
+  pool.configure("a;b", "", 1883, false, "t");
+  pool.failed("a", 1883);
+  assertBroker("b", 1883, pool.select());
+  testClock.advance(BROKER_POOL_COOLDOWN_MS);
+  assertBroker("a", 1883, pool.select());
+}
+
+//* Health survives a rebuild for the brokers that stay
+void test_rebuild_keeps_health() {
+  BrokerPool pool(testClock);
+  pool.configure("a;b", "", 1883, false, "t");
+  pool.failed("b", 1883);
+  pool.connected("a", 1883);
+  TEST_ASSERT_TRUE(pool.configure("c;b;a", "", 1883, false, "t"));
+  assertBroker("c", 1883, &pool.getBrokers()[0]);
+  TEST_ASSERT_EQUAL_UINT8(1, pool.getBrokers()[1].failures);
+  TEST_ASSERT_EQUAL_UINT32(1, pool.getBrokers()[2].sessions);
+}
+
+//* Discovered brokers follow the configured ones, duplicates are dropped
+void test_merge() {
+  BrokerPool pool(testClock);
+  pool.configure("a", "", 1883, false, "t");
+  pool.merge({{"d", 1883, 12}, {"a", 1883, 3}, {"e", 1884, 40}});
+  TEST_ASSERT_EQUAL_size_t(3, pool.size());
+  assertBroker("a", 1883, &pool.getBrokers()[0]);
+  TEST_ASSERT_FALSE(pool.getBrokers()[0].discovered);
+  assertBroker("d", 1883, &pool.getBrokers()[1]);
+  TEST_ASSERT_TRUE(pool.getBrokers()[1].discovered);
+  assertBroker("e", 1884, &pool.getBrokers()[2]);
+
+  //* A later configure keeps them, a is now only a discovered one
+  pool.configure("b", "", 1883, false, "t");
+  TEST_ASSERT_EQUAL_size_t(4, pool.size());
+  assertBroker("b", 1883, &pool.getBrokers()[0]);
+  assertBroker("a", 1883, &pool.getBrokers()[2]);
+  TEST_ASSERT_TRUE(pool.getBrokers()[2].discovered);
+}
+
+//* Spreading starts the walk at a hash of the hostname, stable per tower
+void test_spread() {
+  const char* list = "a;b;c;d;e";
+  size_t starts[2] = {0, 0};
+  const char* hostnames[2] = {"tower-1", "tower-2"};
+  for (int h = 0; h < 2; h++) {
+    uint32_t hash = 2166136261UL;
+    for (const char* c = hostnames[h]; *c; c++) {
+      hash ^= static_cast<uint8_t>(*c);
+      hash *= 16777619UL;
+    }
+    starts[h] = hash % 5;
+  }
+  TEST_ASSERT_TRUE(starts[0] != starts[1]);
+
+  for (int h = 0; h < 2; h++) {
+    BrokerPool pool(testClock);
+    pool.configure(list, "", 1883, true, hostnames[h]);
+    TEST_ASSERT_EQUAL_PTR(&pool.getBrokers()[starts[h]], pool.select());
+    pool.failed(pool.select()->host, 1883);
+    TEST_ASSERT_EQUAL_PTR(&pool.getBrokers()[(starts[h] + 1) % 5],
+                          pool.select());
+  }
+
+  BrokerPool pool(testClock);
+  pool.configure(list, "", 1883, false, hostnames[0]);
+  TEST_ASSERT_EQUAL_PTR(&pool.getBrokers()[0], pool.select());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_list_parsing);
+  RUN_TEST(test_fallback_without_list);
+  RUN_TEST(test_cooldown);
+  RUN_TEST(test_cooldown_is_capped);
+  RUN_TEST(test_all_failing);
+  RUN_TEST(test_cooldown_across_wrap);
+  RUN_TEST(test_rebuild_keeps_health);
+  RUN_TEST(test_merge);
+  RUN_TEST(test_spread);
+  return UNITY_END();
+}
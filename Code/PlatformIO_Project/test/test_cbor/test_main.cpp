@@ -0,0 +1,126 @@
+#include <unity.h>
+//* The library only builds for espressif32, the units are compiled in here
+#include <local/data/codec/cbor.cpp>
+#include <local/data/telemetry/telemetry.cpp>
+
+void setUp() {}
+void tearDown() {}
+
+//* Arguments switch to the next width right past each boundary
+void test_head_widths() {
+  uint8_t buffer[32];
+  CborWriter writer(buffer, sizeof(buffer));
+  writer.unsignedInt(23);
+  writer.unsignedInt(24);
+  writer.unsignedInt(255);
+  writer.unsignedInt(256);
+  writer.unsignedInt(65535);
+  writer.unsignedInt(65536);
+  const uint8_t expected[] = {0x17, 0x18, 0x18, 0x18, 0xFF, 0x19,
+                              0x01, 0x00, 0x19, 0xFF, 0xFF, 0x1A,
+                              0x00, 0x01, 0x00, 0x00};
+  TEST_ASSERT_TRUE(writer.ok());
+  TEST_ASSERT_EQUAL_size_t(sizeof(expected), writer.getLength());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected));
+}
+
+void test_items() {
+  uint8_t buffer[32];
+  CborWriter writer(buffer, sizeof(buffer));
+  writer.signedInt(-1);
+  writer.signedInt(-100);
+  writer.signedInt(10);
+  writer.float32(1.5f);
+  writer.text("ab", 2);
+  writer.null();
+  writer.map(2);
+  writer.array(3);
+  const uint8_t expected[] = {0x20, 0x38, 0x63, 0x0A, 0xFA, 0x3F, 0xC0,
+                              0x00, 0x00, 0x62, 'a',  'b',  0xF6, 0xA2,
+                              0x83};
+  TEST_ASSERT_TRUE(writer.ok());
+  TEST_ASSERT_EQUAL_size_t(sizeof(expected), writer.getLength());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected));
+}
+
+//* A write that does not fit is dropped whole and every later one with it
+void test_overflow() {
+  uint8_t buffer[4];
+  CborWriter writer(buffer, sizeof(buffer));
+  writer.unsignedInt(1);
+  writer.float32(1.0f);
+  TEST_ASSERT_FALSE(writer.ok());
+  writer.unsignedInt(2);
+  TEST_ASSERT_FALSE(writer.ok());
+  TEST_ASSERT_EQUAL_size_t(1, writer.getLength());
+}
+
+void test_encode_cycle() {
+  Telemetry::Sample_t sample;
+  Telemetry::clear(sample);
+  sample.timestamp = 1700000000;
+  sample.timestamp_ms = 1700000000250ULL;
+  sample.uptime = 90;
+  sample.values[Telemetry::LDR] = 1.5f;
+  std::vector<float> probes = {-2.0f};
+
+  uint8_t buffer[TELEMETRY_CBOR_SIZE];
+  size_t length =
+      TelemetryCbor::encode(sample, probes, buffer, sizeof(buffer));
+  const uint8_t expected[] = {
+      0xA6,                                // map of 6
+      0x00, 0x01,                          // version 1
+      0x01, 0x1A, 0x65, 0x53, 0xF1, 0x00,  // timestamp
+      0x02, 0xA1, 0x00, 0xFA, 0x3F, 0xC0, 0x00, 0x00,  // {LDR: 1.5}
+      0x03, 0x81, 0xFA, 0xC0, 0x00, 0x00, 0x00,        // [-2.0]
+      0x04, 0x18, 0xFA,                                // 250 ms
+      0x05, 0x18, 0x5A,                                // uptime 90
+  };
+  TEST_ASSERT_EQUAL_size_t(sizeof(expected), length);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected));
+}
+
+//* Without probes or milliseconds their keys are left out
+void test_encode_minimal() {
+  Telemetry::Sample_t sample;
+  Telemetry::clear(sample);
+  sample.timestamp = 10;
+
+  uint8_t buffer[TELEMETRY_CBOR_SIZE];
+  size_t length =
+      TelemetryCbor::encode(sample, {}, buffer, sizeof(buffer));
+  const uint8_t expected[] = {0xA4, 0x00, 0x01, 0x01, 0x0A,
+                              0x02, 0xA0, 0x05, 0x00};
+  TEST_ASSERT_EQUAL_size_t(sizeof(expected), length);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buffer, sizeof(expected));
+}
+
+//* TELEMETRY_CBOR_SIZE holds the largest cycle, a smaller buffer fails whole
+void test_encode_worst_case() {
+  Telemetry::Sample_t sample;
+  sample.timestamp = UINT32_MAX;
+  sample.timestamp_ms = 999;
+  sample.uptime = UINT32_MAX;
+  for (auto& value : sample.values)
+    value = 123.456f;
+  std::vector<float> probes(TELEMETRY_CBOR_MAX_PROBES, 21.0f);
+
+  uint8_t buffer[TELEMETRY_CBOR_SIZE];
+  size_t length =
+      TelemetryCbor::encode(sample, probes, buffer, sizeof(buffer));
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_LESS_OR_EQUAL(sizeof(buffer), length);
+  TEST_ASSERT_EQUAL_size_t(
+      0, TelemetryCbor::encode(sample, probes, buffer, length - 1));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_head_widths);
+  RUN_TEST(test_items);
+  RUN_TEST(test_overflow);
+  RUN_TEST(test_encode_cycle);
+  RUN_TEST(test_encode_minimal);
+  RUN_TEST(test_encode_worst_case);
+  return UNITY_END();
+}
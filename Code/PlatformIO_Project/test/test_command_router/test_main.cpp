@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <random>
+#include <string>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/network/mqtt/commands/commandrouter.cpp>
+
+static const std::string PREFIX = "tower/1/cmd/";
+
+static CommandRouter* router;
+static std::string called;
+static std::string received;
+
+void setUp() {
+  router = new CommandRouter();
+  router->setPrefix(PREFIX);
+  called.clear();
+  received.clear();
+}
+void tearDown() {
+  delete router;
+}
+
+//* Records which command ran and with what payload
+static CommandRouter::Handler_t handler(const char* name) {
+  return [name](const char* payload, size_t length) {
+    called = name;
+    received.assign(payload, length);
+  };
+}
+
+static bool dispatch(const std::string& topic, const std::string& payload) {
+  return router->dispatch(topic.data(), topic.length(), payload.data(),
+                          payload.length());
+}
+
+void test_prefix_guard() {
+  router->on("read", handler("read"));
+  TEST_ASSERT_FALSE(dispatch("tower/1/cmd/", "1"));
+  TEST_ASSERT_FALSE(dispatch("tower/1/cmd", "1"));
+  TEST_ASSERT_FALSE(dispatch("tower/2/cmd/read", "1"));
+  TEST_ASSERT_FALSE(dispatch("", "1"));
+  TEST_ASSERT_TRUE(called.empty());
+
+  router->setPrefix("");
+  TEST_ASSERT_FALSE(dispatch("tower/1/cmd/read", "1"));
+  TEST_ASSERT_EQUAL_UINT32(5, router->getUnmatched());
+
+  router->setPrefix("tower/2/cmd/");
+  TEST_ASSERT_TRUE(dispatch("tower/2/cmd/read", "1"));
+  TEST_ASSERT_EQUAL_STRING("read", called.c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, router->getDispatched());
+}
+
+void test_unknown_route() {
+  router->on("read", handler("read"));
+  TEST_ASSERT_FALSE(dispatch(PREFIX + "rea", "1"));
+  TEST_ASSERT_FALSE(dispatch(PREFIX + "reads", "1"));
+  TEST_ASSERT_FALSE(dispatch(PREFIX + "READ", "1"));
+  TEST_ASSERT_FALSE(dispatch(PREFIX + "read/x", "1"));
+  TEST_ASSERT_TRUE(called.empty());
+  TEST_ASSERT_EQUAL_UINT32(4, router->getUnmatched());
+}
+
+void test_empty_and_oversized_payloads() {
+  router->on("sample_rate", handler("sample_rate"));
+  TEST_ASSERT_TRUE(dispatch(PREFIX + "sample_rate", ""));
+  TEST_ASSERT_EQUAL_size_t(0, received.length());
+
+  std::string large(64 * 1024, '7');
+  TEST_ASSERT_TRUE(dispatch(PREFIX + "sample_rate", large));
+  TEST_ASSERT_EQUAL_size_t(large.length(), received.length());
+
+  uint32_t value = 42;
+  TEST_ASSERT_FALSE(CommandRouter::parseUInt("", 0, value));
+  TEST_ASSERT_FALSE(
+      CommandRouter::parseUInt(large.data(), large.length(), value));
+  TEST_ASSERT_FALSE(CommandRouter::parseUInt("4294967296", 10, value));
+  TEST_ASSERT_FALSE(CommandRouter::parseUInt("12a", 3, value));
+  TEST_ASSERT_EQUAL_UINT32(42, value);
+  TEST_ASSERT_TRUE(CommandRouter::parseUInt("4294967295", 10, value));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, value);
+
+  bool flag = false;
+  TEST_ASSERT_FALSE(CommandRouter::parseBool("", 0, flag));
+  TEST_ASSERT_FALSE(CommandRouter::parseBool("onn", 3, flag));
+  //* Not null terminated, only the first two bytes are the payload
+  TEST_ASSERT_TRUE(CommandRouter::parseBool("onx", 2, flag));
+  TEST_ASSERT_TRUE(flag);
+  TEST_ASSERT_TRUE(CommandRouter::parseBool("FALSE", 5, flag));
+  TEST_ASSERT_FALSE(flag);
+}
+
+//* Registered out of order, names that prefix each other included
+void test_sorted_lookup() {
+  const char* const names[] = {
+      "sample_rate", "read", "hass_discovery", "read_all", "a",
+      "publish_mode", "re", "z", "history_export",
+  };
+  for (auto name : names)
+    TEST_ASSERT_TRUE(router->on(name, handler(name)));
+  for (auto name : names) {
+    called.clear();
+    TEST_ASSERT_TRUE(dispatch(PREFIX + name, name));
+    TEST_ASSERT_EQUAL_STRING(name, called.c_str());
+    TEST_ASSERT_EQUAL_STRING(name, received.c_str());
+  }
+
+  //* Registering again replaces the handler
+  router->on("read", handler("replaced"));
+  TEST_ASSERT_TRUE(dispatch(PREFIX + "read", ""));
+  TEST_ASSERT_EQUAL_STRING("replaced", called.c_str());
+}
+
+void test_sealed() {
+  router->on("read", handler("read"));
+  router->seal();
+  TEST_ASSERT_FALSE(router->on("late", handler("late")));
+  TEST_ASSERT_FALSE(router->on("read", handler("replaced")));
+  TEST_ASSERT_FALSE(dispatch(PREFIX + "late", ""));
+  TEST_ASSERT_TRUE(dispatch(PREFIX + "read", ""));
+  TEST_ASSERT_EQUAL_STRING("read", called.c_str());
+}
+
+//* Fuzz: random topics around the routes, random bytes as payloads. Every
+//* message either reaches the handler of exactly its command or none.
+void test_random_messages() {
+  const char* const names[] = {"read", "read_all", "sample_rate", "x"};
+  for (auto name : names)
+    router->on(name, handler(name));
+  router->seal();
+
+  std::mt19937 random(36);
+  const std::string alphabet("readl_sample/x\0\xff#+", 18);
+  for (size_t i = 0; i < 200000; i++) {
+    std::string topic;
+    if (random() % 2)
+      topic = PREFIX.substr(0, random() % (PREFIX.length() + 1));
+    size_t length = random() % 16;
+    for (size_t c = 0; c < length; c++)
+      topic += alphabet[random() % alphabet.length()];
+    std::string payload(random() % 32, '\0');
+    for (auto& c : payload)
+      c = random();
+    if (random() % 4 == 0)
+      topic = PREFIX + names[random() % 4];
+
+    called.clear();
+    bool routed = dispatch(topic, payload);
+    std::string command = topic.compare(0, PREFIX.length(), PREFIX) == 0
+                              ? topic.substr(PREFIX.length())
+                              : std::string();
+    bool known = false;
+    for (auto name : names)
+      known |= command == name;
+    TEST_ASSERT_EQUAL(known, routed);
+    if (routed) {
+      TEST_ASSERT_EQUAL_STRING(command.c_str(), called.c_str());
+      TEST_ASSERT_TRUE(received == payload);
+    } else {
+      TEST_ASSERT_TRUE(called.empty());
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_prefix_guard);
+  RUN_TEST(test_unknown_route);
+  RUN_TEST(test_empty_and_oversized_payloads);
+  RUN_TEST(test_sorted_lookup);
+  RUN_TEST(test_sealed);
+  RUN_TEST(test_random_messages);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include <unity.h>
+#include <vector>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/data/history/downsample.cpp>
+
+static const uint32_t START = 1700000000;
+
+void setUp() {}
+void tearDown() {}
+
+//* One point a minute, a flat line at 10
+static std::vector<History::Point_t> series(size_t count) {
+  std::vector<History::Point_t> points(count);
+  for (size_t i = 0; i < count; i++)
+    points[i] = {START + uint32_t(i) * 60, 10, 10, 10};
+  return points;
+}
+
+void test_threshold_not_below_count_copies_means() {
+  std::vector<History::Point_t> in = series(5);
+  in[2] = {in[2].timestamp, 1, 9, 4};
+  Downsample::Point_t out[8];
+
+  for (Downsample::Method_e method : {Downsample::LTTB, Downsample::MIN_MAX}) {
+    for (size_t threshold : {5, 8}) {
+      TEST_ASSERT_EQUAL_size_t(
+          5, Downsample::run(method, in.data(), 5, out, threshold));
+      for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT32(in[i].timestamp, out[i].timestamp);
+        TEST_ASSERT_EQUAL_FLOAT(in[i].mean, out[i].value);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_size_t(0, Downsample::lttb(in.data(), 0, out, 3));
+}
+
+void test_threshold_too_small() {
+  std::vector<History::Point_t> in = series(10);
+  Downsample::Point_t out[2];
+  TEST_ASSERT_EQUAL_size_t(0, Downsample::lttb(in.data(), 10, out, 2));
+  TEST_ASSERT_EQUAL_size_t(0, Downsample::lttb(in.data(), 10, out, 0));
+  TEST_ASSERT_EQUAL_size_t(0, Downsample::minMax(in.data(), 10, out, 1));
+}
+
+void test_lttb_keeps_ends_and_spike() {
+  std::vector<History::Point_t> in = series(100);
+  in[37].mean = 50;
+  Downsample::Point_t out[10];
+  TEST_ASSERT_EQUAL_size_t(10, Downsample::lttb(in.data(), 100, out, 10));
+  TEST_ASSERT_EQUAL_UINT32(in[0].timestamp, out[0].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(in[99].timestamp, out[9].timestamp);
+
+  bool spike = false;
+  for (size_t i = 0; i < 10; i++)
+    spike |= out[i].timestamp == in[37].timestamp && out[i].value == 50;
+  TEST_ASSERT_TRUE(spike);
+}
+
+//* Every split of every size picks one point per bucket, in time order
+void test_lttb_bucket_edges() {
+  for (size_t count = 4; count <= 64; count++) {
+    std::vector<History::Point_t> in = series(count);
+    for (size_t i = 0; i < count; i++)
+      in[i].mean = (i * 7) % 5;
+    std::vector<Downsample::Point_t> out(count);
+    for (size_t threshold = 3; threshold < count; threshold++) {
+      size_t n = Downsample::lttb(in.data(), count, out.data(), threshold);
+      TEST_ASSERT_EQUAL_size_t(threshold, n);
+      TEST_ASSERT_EQUAL_UINT32(in[0].timestamp, out[0].timestamp);
+      TEST_ASSERT_EQUAL_UINT32(in[count - 1].timestamp, out[n - 1].timestamp);
+      for (size_t i = 1; i < n; i++)
+        TEST_ASSERT_TRUE(out[i - 1].timestamp < out[i].timestamp);
+    }
+  }
+}
+
+void test_minmax_order() {
+  std::vector<History::Point_t> in = series(8);
+  //* First bucket peaks before its trough, the second the other way round
+  in[1] = {in[1].timestamp, 9, 30, 20};
+  in[2] = {in[2].timestamp, 2, 10, 5};
+  in[5] = {in[5].timestamp, 1, 10, 4};
+  in[6] = {in[6].timestamp, 9, 40, 20};
+  Downsample::Point_t out[4];
+  TEST_ASSERT_EQUAL_size_t(4, Downsample::minMax(in.data(), 8, out, 4));
+
+  TEST_ASSERT_EQUAL_UINT32(in[1].timestamp, out[0].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(30, out[0].value);
+  TEST_ASSERT_EQUAL_UINT32(in[2].timestamp, out[1].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(2, out[1].value);
+  TEST_ASSERT_EQUAL_UINT32(in[5].timestamp, out[2].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(1, out[2].value);
+  TEST_ASSERT_EQUAL_UINT32(in[6].timestamp, out[3].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(40, out[3].value);
+}
+
+//* A flat bucket emits its mean once, an odd threshold leaves a slot unused
+void test_minmax_flat_bucket() {
+  std::vector<History::Point_t> in = series(9);
+  in[7] = {in[7].timestamp, 0, 10, 5};
+  in[8] = {in[8].timestamp, 10, 20, 15};
+  Downsample::Point_t out[7];
+  size_t n = Downsample::minMax(in.data(), 9, out, 7);
+  TEST_ASSERT_EQUAL_size_t(4, n);
+  TEST_ASSERT_EQUAL_UINT32(in[0].timestamp, out[0].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(10, out[0].value);
+  TEST_ASSERT_EQUAL_UINT32(in[3].timestamp, out[1].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(in[7].timestamp, out[2].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(0, out[2].value);
+  TEST_ASSERT_EQUAL_UINT32(in[8].timestamp, out[3].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(20, out[3].value);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_threshold_not_below_count_copies_means);
+  RUN_TEST(test_threshold_too_small);
+  RUN_TEST(test_lttb_keeps_ends_and_spike);
+  RUN_TEST(test_lttb_bucket_edges);
+  RUN_TEST(test_minmax_order);
+  RUN_TEST(test_minmax_flat_bucket);
+  return UNITY_END();
+}
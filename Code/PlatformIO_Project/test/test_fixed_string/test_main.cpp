@@ -0,0 +1,82 @@
+#include <unity.h>
+#include <local/data/fixedstring/fixedstring.hpp>
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty() {
+  FixedString<8> text;
+  TEST_ASSERT_TRUE(text.empty());
+  TEST_ASSERT_EQUAL_size_t(0, text.size());
+  TEST_ASSERT_EQUAL_STRING("", text.c_str());
+  TEST_ASSERT_EQUAL_size_t(8, FixedString<8>::capacity());
+}
+
+void test_append() {
+  FixedString<16> text("tower");
+  TEST_ASSERT_TRUE(text.append("/"));
+  TEST_ASSERT_TRUE(text.append(std::string("1")));
+  TEST_ASSERT_TRUE(text.append(""));
+  TEST_ASSERT_EQUAL_STRING("tower/1", text.c_str());
+  TEST_ASSERT_EQUAL_size_t(7, text.length());
+  TEST_ASSERT_TRUE(text == "tower/1");
+  TEST_ASSERT_TRUE(text != "tower/2");
+}
+
+//* Text past the capacity is cut, the string stays terminated
+void test_truncation() {
+  FixedString<8> text("tower");
+  TEST_ASSERT_FALSE(text.append("/state"));
+  TEST_ASSERT_EQUAL_STRING("tower/st", text.c_str());
+  TEST_ASSERT_EQUAL_size_t(8, text.size());
+  TEST_ASSERT_FALSE(text.append("x"));
+  TEST_ASSERT_TRUE(text.append(""));
+  TEST_ASSERT_EQUAL_STRING("tower/st", text.c_str());
+
+  FixedString<4> exact;
+  TEST_ASSERT_TRUE(exact.assign("abcd"));
+  TEST_ASSERT_FALSE(exact.assign("abcde"));
+  TEST_ASSERT_EQUAL_STRING("abcd", exact.c_str());
+}
+
+void test_assign_and_clear() {
+  FixedString<16> text("tower/1/state");
+  TEST_ASSERT_TRUE(text.assign("ldr"));
+  TEST_ASSERT_EQUAL_STRING("ldr", text.c_str());
+  text.clear();
+  TEST_ASSERT_TRUE(text.empty());
+  TEST_ASSERT_EQUAL_STRING("", text.c_str());
+}
+
+//* Copies own their text, appending from itself is safe
+void test_copy_and_self_append() {
+  FixedString<16> prefix("tower/");
+  FixedString<16> topic(prefix);
+  topic.append("ldr");
+  TEST_ASSERT_EQUAL_STRING("tower/", prefix.c_str());
+  TEST_ASSERT_EQUAL_STRING("tower/ldr", topic.c_str());
+
+  prefix.append(prefix);
+  TEST_ASSERT_EQUAL_STRING("tower/tower/", prefix.c_str());
+  TEST_ASSERT_FALSE(prefix.append(prefix));
+  TEST_ASSERT_EQUAL_STRING("tower/tower/towe", prefix.c_str());
+}
+
+void test_view() {
+  FixedString<16> text("a/b");
+  std::string_view view = text;
+  TEST_ASSERT_EQUAL_size_t(3, view.size());
+  TEST_ASSERT_EQUAL_PTR(text.data(), view.data());
+  TEST_ASSERT_TRUE(text.view() == "a/b");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty);
+  RUN_TEST(test_append);
+  RUN_TEST(test_truncation);
+  RUN_TEST(test_assign_and_clear);
+  RUN_TEST(test_copy_and_self_append);
+  RUN_TEST(test_view);
+  return UNITY_END();
+}
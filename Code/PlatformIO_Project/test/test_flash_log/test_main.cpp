@@ -0,0 +1,243 @@
+#include <unity.h>
+#include <vector>
+#define HISTORY_RAW_SLOTS 512
+//* The library only builds for espressif32, the units are compiled in here
+#include <local/data/codec/gorilla.cpp>
+#include <local/data/history/flashlog.cpp>
+#include <local/data/history/historystore.cpp>
+#include <local/data/telemetry/telemetry.cpp>
+
+static const uint32_t START = 1700000000;
+static const size_t SECTORS = 4;
+
+/**
+ * @brief Flash in RAM, writes only clear bits
+ * @note budget is the number of bytes programmed before the power fails,
+ * the write in progress is cut there and every later write or erase fails
+ */
+class RamPartition : public FlashPartition {
+ public:
+  std::vector<uint8_t> data;
+  size_t budget;
+
+  RamPartition() : data(SECTORS * SECTOR_SIZE, 0xFF), budget(SIZE_MAX) {}
+
+  bool begin() override { return true; }
+  size_t size() const override { return data.size(); }
+
+  bool read(size_t offset, void* out, size_t length) override {
+    if (offset + length > data.size())
+      return false;
+    memcpy(out, data.data() + offset, length);
+    return true;
+  }
+
+  bool write(size_t offset, const void* in, size_t length) override {
+    if (offset + length > data.size())
+      return false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(in);
+    for (size_t i = 0; i < length; i++) {
+      if (budget == 0)
+        return false;
+      data[offset + i] &= bytes[i];
+      budget--;
+    }
+    return true;
+  }
+
+  bool erase(size_t offset, size_t length) override {
+    if (budget == 0 || offset + length > data.size())
+      return false;
+    memset(data.data() + offset, 0xFF, length);
+    return true;
+  }
+};
+
+static RamPartition* partition;
+static uint32_t next;
+
+void setUp() {
+  partition = new RamPartition();
+  next = START;
+}
+void tearDown() {
+  delete partition;
+}
+
+//* One minute apart, the value is the minute
+static void append(FlashLog& log, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    Telemetry::Sample_t sample;
+    Telemetry::clear(sample);
+    sample.timestamp = next;
+    sample.values[Telemetry::LDR] = (next - START) / 60;
+    log.append(sample);
+    next += 60;
+  }
+  log.flush();
+}
+
+//* Boot a new log on the partition and replay it, the samples must be
+//* consecutive minutes ending at last
+static size_t reboot(uint32_t last) {
+  FlashLog log(*partition);
+  TEST_ASSERT_TRUE(log.begin());
+  HistoryStore history;
+  history.begin();
+  size_t replayed = log.replay(history);
+
+  std::vector<History::Point_t> points(replayed + 1);
+  size_t n = history.query(Telemetry::LDR, History::RAW, 0, UINT32_MAX,
+                           points.data(), points.size());
+  TEST_ASSERT_EQUAL_size_t(replayed, n);
+  if (n > 0)
+    TEST_ASSERT_EQUAL_UINT32(last, points[n - 1].timestamp);
+  return replayed;
+}
+
+void test_replay_after_reboot() {
+  {
+    FlashLog log(*partition);
+    TEST_ASSERT_TRUE(log.begin());
+    append(log, 25);
+  }
+  TEST_ASSERT_EQUAL_size_t(25, reboot(next - 60));
+
+  //* Appends continue behind the replayed records
+  FlashLog log(*partition);
+  log.begin();
+  append(log, 5);
+  TEST_ASSERT_EQUAL_size_t(30, reboot(next - 60));
+}
+
+//* A record cut by a power loss is skipped and its slot is not reused
+void test_torn_record() {
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, 10);
+    partition->budget = sizeof(Record_t) * 3 + 7;
+    append(log, 5);
+  }
+  partition->budget = SIZE_MAX;
+  {
+    FlashLog log(*partition);
+    log.begin();
+    TEST_ASSERT_EQUAL_UINT32(1, log.getTornRecords());
+    append(log, 4);
+  }
+  //* 13 whole records, the torn one, one never written, then the new four
+  TEST_ASSERT_EQUAL_size_t(17, reboot(next - 60));
+}
+
+//* Power lost between erasing the next sector and stamping its header
+void test_torn_header_after_erase() {
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, RECORDS_PER_SECTOR);
+    partition->budget = sizeof(SectorHeader_t) / 2;
+    append(log, 1);
+  }
+  partition->budget = SIZE_MAX;
+  uint32_t last = next - 120;
+  TEST_ASSERT_EQUAL_size_t(RECORDS_PER_SECTOR, reboot(last));
+
+  FlashLog log(*partition);
+  log.begin();
+  append(log, 3);
+  SectorHeader_t header;
+  memcpy(&header, partition->data.data() + SECTOR_SIZE, sizeof(header));
+  TEST_ASSERT_EQUAL_UINT32(MAGIC, header.magic);
+  TEST_ASSERT_EQUAL_UINT32(2, header.sequence);
+  TEST_ASSERT_EQUAL_size_t(RECORDS_PER_SECTOR + 3, reboot(next - 60));
+}
+
+//* Sectors of another layout are neither replayed nor appended to
+void test_version_change() {
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, 20);
+  }
+  SectorHeader_t header;
+  memcpy(&header, partition->data.data(), sizeof(header));
+  header.version = VERSION + 1;
+  header.crc = esp_rom_crc32_le(0, reinterpret_cast<uint8_t*>(&header),
+                                offsetof(SectorHeader_t, crc));
+  memcpy(partition->data.data(), &header, sizeof(header));
+  TEST_ASSERT_EQUAL_size_t(0, reboot(0));
+
+  FlashLog log(*partition);
+  log.begin();
+  append(log, 6);
+  memcpy(&header, partition->data.data() + SECTOR_SIZE, sizeof(header));
+  TEST_ASSERT_EQUAL_UINT8(VERSION, header.version);
+  TEST_ASSERT_EQUAL_UINT32(2, header.sequence);
+  TEST_ASSERT_EQUAL_size_t(6, reboot(next - 60));
+}
+
+//* Once the ring wrapped the sequence numbers, not the sector order, decide
+void test_wrap() {
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, SECTORS * RECORDS_PER_SECTOR + 50);
+  }
+  TEST_ASSERT_EQUAL_size_t((SECTORS - 1) * RECORDS_PER_SECTOR + 50,
+                           reboot(next - 60));
+
+  FlashLog log(*partition);
+  log.begin();
+  append(log, RECORDS_PER_SECTOR);
+  TEST_ASSERT_EQUAL_size_t((SECTORS - 1) * RECORDS_PER_SECTOR + 50,
+                           reboot(next - 60));
+}
+
+//* A write that failed leaves a hole in an older sector, the replay skips
+//* it and goes on with the newer sectors
+void test_failed_write_in_older_sector() {
+  FlashLog log(*partition);
+  log.begin();
+  append(log, 20);
+  partition->budget = 0;
+  append(log, 10);
+  partition->budget = SIZE_MAX;
+  append(log, RECORDS_PER_SECTOR);
+  TEST_ASSERT_EQUAL_size_t(20 + RECORDS_PER_SECTOR, reboot(next - 60));
+}
+
+//* Nothing was programmed, after a reboot the erased slots are written again
+void test_failed_write_in_tail_sector() {
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, 20);
+    partition->budget = 0;
+    append(log, 10);
+  }
+  partition->budget = SIZE_MAX;
+  {
+    FlashLog log(*partition);
+    log.begin();
+    append(log, 5);
+  }
+  Record_t record;
+  memcpy(&record, partition->data.data() + sizeof(SectorHeader_t) +
+                      20 * sizeof(Record_t),
+         sizeof(record));
+  TEST_ASSERT_EQUAL_UINT32(next - 5 * 60, record.timestamp);
+  TEST_ASSERT_EQUAL_size_t(25, reboot(next - 60));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_replay_after_reboot);
+  RUN_TEST(test_torn_record);
+  RUN_TEST(test_torn_header_after_erase);
+  RUN_TEST(test_version_change);
+  RUN_TEST(test_wrap);
+  RUN_TEST(test_failed_write_in_older_sector);
+  RUN_TEST(test_failed_write_in_tail_sector);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/Serializers/FloatFormat/floatformat.cpp>
+
+void setUp() {}
+void tearDown() {}
+
+static std::string text(float value, uint8_t precision) {
+  char buffer[FLOAT_FORMAT_SIZE];
+  size_t length = FloatFormat::format(value, precision, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_size_t(strlen(buffer), length);
+  return std::string(buffer, length);
+}
+
+void test_fixed_width() {
+  TEST_ASSERT_EQUAL_STRING("21.50", text(21.5f, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("0.050", text(0.05f, 3).c_str());
+  TEST_ASSERT_EQUAL_STRING("-3.0", text(-3.0f, 1).c_str());
+  TEST_ASSERT_EQUAL_STRING("1024", text(1024.4f, 0).c_str());
+  TEST_ASSERT_EQUAL_STRING("0.000000", text(0.0f, 6).c_str());
+}
+
+void test_rounds_half_away_from_zero() {
+  TEST_ASSERT_EQUAL_STRING("0.13", text(0.125f, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("-0.13", text(-0.125f, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("3", text(2.5f, 0).c_str());
+  TEST_ASSERT_EQUAL_STRING("10.00", text(9.999f, 2).c_str());
+}
+
+//* 9.995f and 0.45f are stored just below the half, scaling in float used to
+//* round them up
+void test_rounds_the_stored_value() {
+  TEST_ASSERT_EQUAL_STRING("9.99", text(9.995f, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("0.4", text(0.45f, 1).c_str());
+}
+
+void test_no_negative_zero() {
+  TEST_ASSERT_EQUAL_STRING("0.000", text(-0.0004f, 3).c_str());
+  TEST_ASSERT_EQUAL_STRING("0", text(-0.0f, 0).c_str());
+}
+
+void test_null_for_non_finite() {
+  TEST_ASSERT_EQUAL_STRING("null", text(NAN, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("null", text(INFINITY, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("null", text(-INFINITY, 2).c_str());
+  TEST_ASSERT_EQUAL_STRING("null", text(2e15f, 0).c_str());
+}
+
+//* Random floats from 2^-17 to 2^14 against the exact product, a long double
+//* holds the 24 + 20 bits without loss
+void test_matches_exact_rounding() {
+  uint32_t state = 40;
+  for (size_t i = 0; i < 100000; i++) {
+    state = state * 1664525 + 1013904223;
+    uint32_t bits = (state & 0x807FFFFF) | ((110 + (state >> 8) % 32) << 23);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    for (uint8_t precision = 0; precision <= FloatFormat::MAX_PRECISION;
+         precision++) {
+      long double exact =
+          fabsl((long double)value) * FloatFormat::scales[precision];
+      std::string digits =
+          std::to_string((unsigned long long)floorl(exact + 0.5L));
+      bool zero = digits == "0";
+      if (digits.length() <= precision)
+        digits.insert(0, precision + 1 - digits.length(), '0');
+      if (precision > 0)
+        digits.insert(digits.length() - precision, ".");
+      if (value < 0 && !zero)
+        digits.insert(0, "-");
+      TEST_ASSERT_EQUAL_STRING(digits.c_str(), text(value, precision).c_str());
+    }
+  }
+}
+
+void test_extremes() {
+  TEST_ASSERT_EQUAL_STRING("0.000000", text(1e-40f, 6).c_str());
+  TEST_ASSERT_EQUAL_STRING("0.000000", text(-1e-40f, 6).c_str());
+  TEST_ASSERT_EQUAL_STRING("123456792", text(123456789.0f, 0).c_str());
+  TEST_ASSERT_EQUAL_STRING("1000000000.00000", text(1e9f, 5).c_str());
+  TEST_ASSERT_EQUAL_STRING("null", text(1e9f, 6).c_str());
+  TEST_ASSERT_EQUAL_STRING("null", text(-3e38f, 0).c_str());
+}
+
+void test_precision_is_clamped() {
+  TEST_ASSERT_EQUAL_STRING("1.500000", text(1.5f, 9).c_str());
+}
+
+void test_small_buffer() {
+  char buffer[5];
+  TEST_ASSERT_EQUAL_size_t(4, FloatFormat::format(1.5f, 2, buffer, 5));
+  TEST_ASSERT_EQUAL_size_t(0, FloatFormat::format(21.5f, 2, buffer, 5));
+  TEST_ASSERT_EQUAL_size_t(0, FloatFormat::format(NAN, 2, buffer, 4));
+}
+
+void test_append() {
+  std::string out("t=");
+  FloatFormat::append(out, 21.456f, 1);
+  TEST_ASSERT_EQUAL_STRING("t=21.5", out.c_str());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_width);
+  RUN_TEST(test_rounds_half_away_from_zero);
+  RUN_TEST(test_rounds_the_stored_value);
+  RUN_TEST(test_no_negative_zero);
+  RUN_TEST(test_null_for_non_finite);
+  RUN_TEST(test_matches_exact_rounding);
+  RUN_TEST(test_extremes);
+  RUN_TEST(test_precision_is_clamped);
+  RUN_TEST(test_small_buffer);
+  RUN_TEST(test_append);
+  return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <unity.h>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/data/codec/gorilla.cpp>
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t bitsOf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+//* Every point comes back bit for bit, NaN and negative zero included
+void test_round_trip() {
+  const uint32_t timestamps[] = {1700000000, 1700000060, 1700000120,
+                                 1700000185, 1700000185, 1700003000,
+                                 1700003001, 1800000000};
+  const float values[] = {21.5f, 21.5f, 21.625f, -3.0f,
+                          NAN,   -0.0f, 1e-30f,  3.4e38f};
+  const size_t count = sizeof(values) / sizeof(values[0]);
+
+  uint8_t buffer[128];
+  GorillaEncoder encoder(buffer, sizeof(buffer));
+  for (size_t i = 0; i < count; i++)
+    TEST_ASSERT_TRUE(encoder.append(timestamps[i], values[i]));
+  size_t length = encoder.finish();
+  TEST_ASSERT_LESS_OR_EQUAL(GorillaEncoder::maxSize(count), length);
+
+  GorillaDecoder decoder(buffer, length);
+  TEST_ASSERT_EQUAL_UINT16(count, decoder.getCount());
+  uint32_t timestamp;
+  float value;
+  for (size_t i = 0; i < count; i++) {
+    TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+    TEST_ASSERT_EQUAL_UINT32(timestamps[i], timestamp);
+    TEST_ASSERT_EQUAL_HEX32(bitsOf(values[i]), bitsOf(value));
+  }
+  TEST_ASSERT_FALSE(decoder.next(timestamp, value));
+}
+
+//* A steady cadence and an unchanged reading cost two bits per point
+void test_steady_stream_is_compact() {
+  uint8_t buffer[64];
+  GorillaEncoder encoder(buffer, sizeof(buffer));
+  for (uint32_t i = 0; i < 101; i++)
+    TEST_ASSERT_TRUE(encoder.append(1700000000 + i * 60, 20.0f));
+  //* Header, first point, one point with a new delta, 99 two bit points
+  TEST_ASSERT_EQUAL_size_t((16 + 64 + 10 + 99 * 2 + 7) / 8, encoder.finish());
+}
+
+//* A full buffer keeps the points written so far decodable
+void test_overflow_keeps_stream_valid() {
+  uint8_t buffer[16];
+  GorillaEncoder encoder(buffer, sizeof(buffer));
+  uint16_t appended = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    if (!encoder.append(1700000000 + i * i, i * 1.7f))
+      break;
+    appended++;
+  }
+  TEST_ASSERT_GREATER_THAN(0, appended);
+  TEST_ASSERT_TRUE(appended < 100);
+  TEST_ASSERT_FALSE(encoder.append(1800000000, 1.0f));
+
+  size_t length = encoder.finish();
+  TEST_ASSERT_LESS_OR_EQUAL(sizeof(buffer), length);
+  GorillaDecoder decoder(buffer, length);
+  TEST_ASSERT_EQUAL_UINT16(appended, decoder.getCount());
+  uint32_t timestamp;
+  float value;
+  for (uint16_t i = 0; i < appended; i++) {
+    TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+    TEST_ASSERT_EQUAL_UINT32(1700000000 + i * i, timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(i * 1.7f, value);
+  }
+}
+
+void test_truncated_stream_stops() {
+  uint8_t buffer[64];
+  GorillaEncoder encoder(buffer, sizeof(buffer));
+  for (uint32_t i = 0; i < 10; i++)
+    encoder.append(1700000000 + i * 61 + i * i, i * 0.3f);
+  size_t length = encoder.finish();
+
+  GorillaDecoder decoder(buffer, length - 3);
+  uint32_t timestamp;
+  float value;
+  uint16_t decoded = 0;
+  while (decoder.next(timestamp, value))
+    decoded++;
+  TEST_ASSERT_TRUE(decoded < 10);
+}
+
+//* A value window wider than 32 bits ends the stream instead of shifting
+//* past the value
+void test_corrupt_window_stops() {
+  uint8_t buffer[16];
+  BitWriter writer(buffer, sizeof(buffer));
+  writer.write(2, 16);           // count
+  writer.write(1700000000, 32);  // t0
+  writer.write(bitsOf(1.0f), 32);
+  writer.write(0b0, 1);   // same delta
+  writer.write(0b11, 2);  // new window
+  writer.write(31, 5);    // leading
+  writer.write(31, 5);    // length - 1
+
+  GorillaDecoder decoder(buffer, sizeof(buffer));
+  uint32_t timestamp;
+  float value;
+  TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+  TEST_ASSERT_FALSE(decoder.next(timestamp, value));
+  TEST_ASSERT_FALSE(decoder.next(timestamp, value));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_steady_stream_is_compact);
+  RUN_TEST(test_overflow_keeps_stream_valid);
+  RUN_TEST(test_truncated_stream_stops);
+  RUN_TEST(test_corrupt_window_stops);
+  return UNITY_END();
+}
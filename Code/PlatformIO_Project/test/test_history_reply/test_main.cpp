@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <string>
+//* The library only builds for espressif32, the units are compiled in here
+#include <local/Serializers/FloatFormat/floatformat.cpp>
+#include <local/data/codec/gorilla.cpp>
+#include <local/data/history/downsample.cpp>
+#include <local/data/history/historystore.cpp>
+#include <local/data/telemetry/telemetry.cpp>
+#include <local/network/api/history/historyreply.cpp>
+
+static const uint32_t START = 1700000400;
+
+static HistoryStore* store;
+
+void setUp() {
+  store = new HistoryStore();
+  TEST_ASSERT_TRUE(store->begin());
+}
+void tearDown() {
+  delete store;
+}
+
+static void insert(uint32_t timestamp, float ldr, float temperature) {
+  Telemetry::Sample_t sample;
+  Telemetry::clear(sample);
+  sample.timestamp = timestamp;
+  sample.values[Telemetry::LDR] = ldr;
+  sample.values[Telemetry::TOWER_TEMP] = temperature;
+  store->insert(sample);
+}
+
+//* Drain the reply maxLen bytes at a time, until fill() reports the end
+static std::string drain(HistoryReply& reply, size_t maxLen) {
+  std::string body;
+  uint8_t buffer[512];
+  size_t length;
+  while ((length = reply.fill(buffer, maxLen)) > 0) {
+    TEST_ASSERT_TRUE(length <= maxLen);
+    body.append(reinterpret_cast<char*>(buffer), length);
+  }
+  return body;
+}
+
+void test_empty_range() {
+  HistoryReply reply(Telemetry::LDR, 60, Downsample::LTTB);
+  TEST_ASSERT_EQUAL_size_t(
+      0, reply.build(*store, History::RAW, 0, UINT32_MAX, 100));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"channel\":\"ldr\",\"resolution\":60,\"method\":\"lttb\","
+      "\"points\":[]}",
+      drain(reply, 512).c_str());
+}
+
+void test_points_use_channel_precision() {
+  insert(START, 12.34f, 21.5f);
+  insert(START + 60, 7.0f, 22.125f);
+  HistoryReply ldr(Telemetry::LDR, 60, Downsample::MIN_MAX);
+  TEST_ASSERT_EQUAL_size_t(2,
+                           ldr.build(*store, History::RAW, 0, UINT32_MAX, 10));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"channel\":\"ldr\",\"resolution\":60,\"method\":\"minmax\","
+      "\"points\":[[1700000400,12.3],[1700000460,7.0]]}",
+      drain(ldr, 512).c_str());
+
+  HistoryReply temperature(Telemetry::TOWER_TEMP, 60, Downsample::LTTB);
+  temperature.build(*store, History::RAW, 0, UINT32_MAX, 10);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"channel\":\"temperature\",\"resolution\":60,\"method\":\"lttb\","
+      "\"points\":[[1700000400,21.50],[1700000460,22.13]]}",
+      drain(temperature, 512).c_str());
+}
+
+//* Chunks smaller than one point carry the rest over, byte for byte
+void test_fill_smaller_than_a_point() {
+  for (size_t m = 0; m < 40; m++)
+    insert(START + m * 60, m * 1.5f, -m * 0.25f);
+  HistoryReply whole(Telemetry::TOWER_TEMP, 60, Downsample::LTTB);
+  TEST_ASSERT_EQUAL_size_t(
+      10, whole.build(*store, History::RAW, 0, UINT32_MAX, 10));
+  std::string expected = drain(whole, 512);
+  TEST_ASSERT_TRUE(expected.front() == '{');
+  TEST_ASSERT_TRUE(expected.back() == '}');
+
+  for (size_t maxLen : {1, 2, 7, 19}) {
+    HistoryReply reply(Telemetry::TOWER_TEMP, 60, Downsample::LTTB);
+    reply.build(*store, History::RAW, 0, UINT32_MAX, 10);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), drain(reply, maxLen).c_str());
+  }
+}
+
+//* The build never keeps more points than asked for
+void test_build_respects_threshold() {
+  for (size_t m = 0; m < 40; m++)
+    insert(START + m * 60, m, m);
+  HistoryReply reply(Telemetry::LDR, 60, Downsample::MIN_MAX);
+  TEST_ASSERT_EQUAL_size_t(
+      4, reply.build(*store, History::RAW, 0, UINT32_MAX, 5));
+  TEST_ASSERT_EQUAL_size_t(4, reply.getPointCount());
+
+  HistoryReply none(Telemetry::LDR, 60, Downsample::LTTB);
+  TEST_ASSERT_EQUAL_size_t(0,
+                           none.build(*store, History::RAW, 0, UINT32_MAX, 2));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"channel\":\"ldr\",\"resolution\":60,\"method\":\"lttb\","
+      "\"points\":[]}",
+      drain(none, 512).c_str());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_range);
+  RUN_TEST(test_points_use_channel_precision);
+  RUN_TEST(test_fill_smaller_than_a_point);
+  RUN_TEST(test_build_respects_threshold);
+  return UNITY_END();
+}
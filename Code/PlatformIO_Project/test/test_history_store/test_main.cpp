@@ -0,0 +1,216 @@
+#include <unity.h>
+//* Small tiers so a few samples wrap them
+#define HISTORY_RAW_SLOTS 8
+#define HISTORY_5M_SLOTS 6
+#define HISTORY_1H_SLOTS 4
+//* The library only builds for espressif32, the units are compiled in here
+#include <local/data/codec/gorilla.cpp>
+#include <local/data/history/historystore.cpp>
+#include <local/data/telemetry/telemetry.cpp>
+
+static const uint32_t START = 1700000400;  // on an hour boundary
+static const Telemetry::Channel_e CHANNEL = Telemetry::LDR;
+
+static HistoryStore* store;
+
+void setUp() {
+  store = new HistoryStore();
+  TEST_ASSERT_TRUE(store->begin());
+}
+void tearDown() {
+  delete store;
+}
+
+static void insert(uint32_t timestamp, float value) {
+  Telemetry::Sample_t sample;
+  Telemetry::clear(sample);
+  sample.timestamp = timestamp;
+  sample.values[CHANNEL] = value;
+  store->insert(sample);
+}
+
+//* One sample a minute for count minutes, valued by the minute index
+static void insertMinutes(uint32_t from, size_t count) {
+  for (size_t m = 0; m < count; m++)
+    insert(from + m * 60, m);
+}
+
+void test_raw_wraparound() {
+  insertMinutes(START, 20);
+  TEST_ASSERT_EQUAL_size_t(
+      HISTORY_RAW_SLOTS, store->count(CHANNEL, History::RAW, 0, UINT32_MAX));
+
+  History::Point_t points[HISTORY_RAW_SLOTS + 1];
+  size_t n = store->query(CHANNEL, History::RAW, 0, UINT32_MAX, points,
+                          HISTORY_RAW_SLOTS + 1);
+  TEST_ASSERT_EQUAL_size_t(HISTORY_RAW_SLOTS, n);
+  for (size_t i = 0; i < n; i++) {
+    size_t minute = 20 - HISTORY_RAW_SLOTS + i;
+    TEST_ASSERT_EQUAL_UINT32(START + minute * 60, points[i].timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(minute, points[i].mean);
+  }
+}
+
+//* Samples at or before the last one are dropped, the rings stay sorted
+void test_out_of_order_dropped() {
+  insert(START + 60, 1);
+  insert(START + 60, 2);
+  insert(START, 3);
+  History::Point_t points[4];
+  TEST_ASSERT_EQUAL_size_t(
+      1, store->query(CHANNEL, History::RAW, 0, UINT32_MAX, points, 4));
+  TEST_ASSERT_EQUAL_FLOAT(1, points[0].mean);
+}
+
+//* A bucket is on a wall clock boundary and shows once the next one starts
+void test_rollup_boundaries() {
+  insertMinutes(START, 5);
+  TEST_ASSERT_EQUAL_size_t(
+      0, store->count(CHANNEL, History::FIVE_MINUTES, 0, UINT32_MAX));
+
+  insert(START + 300, 100);
+  History::Point_t points[4];
+  TEST_ASSERT_EQUAL_size_t(1, store->query(CHANNEL, History::FIVE_MINUTES, 0,
+                                           UINT32_MAX, points, 4));
+  TEST_ASSERT_EQUAL_UINT32(START, points[0].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(0, points[0].min);
+  TEST_ASSERT_EQUAL_FLOAT(4, points[0].max);
+  TEST_ASSERT_EQUAL_FLOAT(2, points[0].mean);
+
+  //* The last second of a bucket still belongs to it
+  insert(START + 599, 50);
+  insert(START + 600, 0);
+  TEST_ASSERT_EQUAL_size_t(2, store->query(CHANNEL, History::FIVE_MINUTES, 0,
+                                           UINT32_MAX, points, 4));
+  TEST_ASSERT_EQUAL_UINT32(START + 300, points[1].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(50, points[1].min);
+  TEST_ASSERT_EQUAL_FLOAT(100, points[1].max);
+  TEST_ASSERT_EQUAL_FLOAT(75, points[1].mean);
+}
+
+void test_rollup_wraparound() {
+  insertMinutes(START, 5 * (HISTORY_5M_SLOTS + 3) + 1);
+  History::Point_t points[HISTORY_5M_SLOTS + 1];
+  size_t n = store->query(CHANNEL, History::FIVE_MINUTES, 0, UINT32_MAX,
+                          points, HISTORY_5M_SLOTS + 1);
+  TEST_ASSERT_EQUAL_size_t(HISTORY_5M_SLOTS, n);
+  for (size_t i = 0; i < n; i++)
+    TEST_ASSERT_EQUAL_UINT32(START + (3 + i) * 300, points[i].timestamp);
+}
+
+//* Unread channels are skipped by raw queries and left out of rollups
+void test_nan_gaps() {
+  for (size_t m = 0; m < 10; m++)
+    insert(START + m * 60, m % 2 == 0 ? NAN : m);
+  insert(START + 600, NAN);
+  //* The raw ring holds minutes 3 to 10, the odd ones were read
+  TEST_ASSERT_EQUAL_size_t(4,
+                           store->count(CHANNEL, History::RAW, 0, UINT32_MAX));
+
+  History::Point_t points[4];
+  TEST_ASSERT_EQUAL_size_t(2, store->query(CHANNEL, History::FIVE_MINUTES, 0,
+                                           UINT32_MAX, points, 4));
+  TEST_ASSERT_EQUAL_FLOAT(1, points[0].min);
+  TEST_ASSERT_EQUAL_FLOAT(3, points[0].max);
+  TEST_ASSERT_EQUAL_FLOAT(2, points[0].mean);
+
+  //* A bucket without a single reading of the channel is a gap
+  insert(START + 900, NAN);
+  TEST_ASSERT_EQUAL_size_t(2, store->count(CHANNEL, History::FIVE_MINUTES, 0,
+                                           UINT32_MAX));
+  TEST_ASSERT_EQUAL_size_t(0, store->count(Telemetry::WATER_LEVEL,
+                                           History::FIVE_MINUTES, 0,
+                                           UINT32_MAX));
+}
+
+//* Pages of max points, continued from past the last returned timestamp
+void test_query_paging() {
+  insertMinutes(START, HISTORY_RAW_SLOTS);
+  History::Point_t points[3];
+  uint32_t from = START + 60;
+  uint32_t to = START + 6 * 60;
+  size_t total = 0;
+  size_t n;
+  do {
+    n = store->query(CHANNEL, History::RAW, from, to, points, 3);
+    for (size_t i = 0; i < n; i++)
+      TEST_ASSERT_EQUAL_UINT32(START + (1 + total + i) * 60,
+                               points[i].timestamp);
+    total += n;
+    if (n > 0)
+      from = points[n - 1].timestamp + 1;
+  } while (n == 3);
+  TEST_ASSERT_EQUAL_size_t(6, total);
+  TEST_ASSERT_EQUAL_size_t(6, store->count(CHANNEL, History::RAW,
+                                           START + 60, to));
+  TEST_ASSERT_EQUAL_size_t(
+      0, store->query(CHANNEL, History::RAW, to + 61, UINT32_MAX, points, 3));
+}
+
+void test_invalid_arguments() {
+  insertMinutes(START, 2);
+  History::Point_t points[2];
+  TEST_ASSERT_EQUAL_size_t(0, store->query(Telemetry::CHANNEL_COUNT,
+                                           History::RAW, 0, UINT32_MAX,
+                                           points, 2));
+  TEST_ASSERT_EQUAL_size_t(0, store->count(CHANNEL, History::RESOLUTION_COUNT,
+                                           0, UINT32_MAX));
+}
+
+//* The finest tier still reaching back to from, a tier that is not full
+//* yet holds everything since boot
+void test_resolution_for() {
+  TEST_ASSERT_EQUAL(History::RAW, store->resolutionFor(0));
+  insertMinutes(START, HISTORY_RAW_SLOTS - 1);
+  TEST_ASSERT_EQUAL(History::RAW, store->resolutionFor(0));
+
+  insert(START + (HISTORY_RAW_SLOTS - 1) * 60, 0);
+  TEST_ASSERT_EQUAL(History::RAW, store->resolutionFor(START));
+  TEST_ASSERT_EQUAL(History::FIVE_MINUTES, store->resolutionFor(0));
+
+  insert(START + HISTORY_RAW_SLOTS * 60, 0);
+  TEST_ASSERT_EQUAL(History::RAW, store->resolutionFor(START + 60));
+  TEST_ASSERT_EQUAL(History::FIVE_MINUTES, store->resolutionFor(START));
+
+  //* Five more hours wrap every ring past START
+  insertMinutes(START + 3600, 5 * 60 + 1);
+  uint32_t last = START + 3600 + 5 * 3600;
+  TEST_ASSERT_EQUAL(History::FIVE_MINUTES,
+                    store->resolutionFor(last - HISTORY_5M_SLOTS * 300));
+  TEST_ASSERT_EQUAL(History::ONE_HOUR,
+                    store->resolutionFor(last - HISTORY_5M_SLOTS * 300 - 1));
+  TEST_ASSERT_EQUAL(History::ONE_HOUR, store->resolutionFor(START));
+}
+
+void test_encode() {
+  insertMinutes(START, HISTORY_RAW_SLOTS);
+  uint8_t buffer[GorillaEncoder::maxSize(HISTORY_RAW_SLOTS)];
+  GorillaEncoder encoder(buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_size_t(
+      5, store->encode(CHANNEL, History::RAW, START + 120, START + 360,
+                       encoder));
+
+  GorillaDecoder decoder(buffer, encoder.finish());
+  uint32_t timestamp;
+  float value;
+  for (size_t m = 2; m <= 6; m++) {
+    TEST_ASSERT_TRUE(decoder.next(timestamp, value));
+    TEST_ASSERT_EQUAL_UINT32(START + m * 60, timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(m, value);
+  }
+  TEST_ASSERT_FALSE(decoder.next(timestamp, value));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_raw_wraparound);
+  RUN_TEST(test_out_of_order_dropped);
+  RUN_TEST(test_rollup_boundaries);
+  RUN_TEST(test_rollup_wraparound);
+  RUN_TEST(test_nan_gaps);
+  RUN_TEST(test_query_paging);
+  RUN_TEST(test_invalid_arguments);
+  RUN_TEST(test_resolution_for);
+  RUN_TEST(test_encode);
+  return UNITY_END();
+}
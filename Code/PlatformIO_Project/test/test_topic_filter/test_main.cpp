@@ -0,0 +1,47 @@
+#include <unity.h>
+//* The library only builds for espressif32, the unit is compiled in here
+#include <local/network/mqtt/topics/topicfilter.cpp>
+
+void setUp() {}
+void tearDown() {}
+
+void test_literal() {
+  TEST_ASSERT_TRUE(Topics::matches("tower/1/state", "tower/1/state"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/1/state", "tower/1/stat"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/1/state", "tower/1/states"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/1/state", "tower/1/state/cbor"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/1", "tower/2"));
+}
+
+void test_single_level() {
+  TEST_ASSERT_TRUE(Topics::matches("+/+/status", "tower/1/status"));
+  TEST_ASSERT_TRUE(Topics::matches("+/+/status", "/1/status"));
+  TEST_ASSERT_FALSE(Topics::matches("+/+/status", "tower/status"));
+  TEST_ASSERT_FALSE(Topics::matches("+/+/status", "tower/1/2/status"));
+  TEST_ASSERT_TRUE(Topics::matches("tower/+", "tower/1"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/+", "tower/1/state"));
+}
+
+void test_multi_level() {
+  TEST_ASSERT_TRUE(Topics::matches("#", "tower/1/state"));
+  TEST_ASSERT_TRUE(Topics::matches("+/+/history/#", "tower/1/history/ldr"));
+  TEST_ASSERT_TRUE(Topics::matches("+/+/state/#", "tower/1/state/cbor"));
+  TEST_ASSERT_FALSE(Topics::matches("+/+/history/#", "tower/1/state"));
+}
+
+//* a/# also matches a, as in the MQTT specification
+void test_multi_level_matches_parent() {
+  TEST_ASSERT_TRUE(Topics::matches("+/+/state/#", "tower/1/state"));
+  TEST_ASSERT_TRUE(Topics::matches("tower/#", "tower"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/#", "towers"));
+  TEST_ASSERT_FALSE(Topics::matches("tower/1/#", "tower"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_literal);
+  RUN_TEST(test_single_level);
+  RUN_TEST(test_multi_level);
+  RUN_TEST(test_multi_level_matches_parent);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+# Description: Decode CBOR telemetry cycles published by a tower
+#
+# Usable as a library:
+#   from decode_cbor import decode_cycle
+#   cycle = decode_cycle(payload)
+# or from the command line on raw payload files or hex strings:
+#   mosquitto_sub -t 'tower/0/state' -C 1 > cycle.cbor
+#   python3 tools/decode_cbor.py cycle.cbor
+#   python3 tools/decode_cbor.py --hex a4000101...
+#
+# The schema is documented in
+# lib/GreenHouseTowerDIY/src/local/data/codec/cbor.hpp
+
+import argparse
+import json
+import struct
+import sys
+
+KEY_VERSION = 0
+KEY_TIMESTAMP = 1
+KEY_CHANNELS = 2
+KEY_PROBES = 3
+KEY_MILLIS = 4
+KEY_UPTIME = 5
+
+# Must follow Telemetry::channel_names in local/data/telemetry/telemetry.cpp
+CHANNEL_NAMES = [
+    "ldr",
+    "water_level_sensor",
+    "water_level_percentage",
+    "temperature",
+    "dht_hum",
+    "dht_temp",
+    "sht31_1_hum",
+    "sht31_1_temp",
+    "sht31_2_hum",
+    "sht31_2_temp",
+]
+
+
+class DecodeError(ValueError):
+    pass
+
+
+def _half(bits):
+    sign = -1.0 if bits & 0x8000 else 1.0
+    exponent = (bits >> 10) & 0x1F
+    fraction = bits & 0x3FF
+    if exponent == 0:
+        return sign * fraction * 2.0**-24
+    if exponent == 31:
+        return sign * float("inf") if fraction == 0 else float("nan")
+    return sign * (1 + fraction / 1024.0) * 2.0 ** (exponent - 15)
+
+
+def _decode(data, offset):
+    """Decode one item starting at offset, return (value, next offset)."""
+    if offset >= len(data):
+        raise DecodeError("truncated item")
+    initial = data[offset]
+    major, info = initial >> 5, initial & 0x1F
+    offset += 1
+
+    if major == 7:
+        if info == 20:
+            return False, offset
+        if info == 21:
+            return True, offset
+        if info in (22, 23):
+            return None, offset
+        sizes = {25: (2, ">H"), 26: (4, ">f"), 27: (8, ">d")}
+        if info not in sizes:
+            raise DecodeError("unsupported simple value %d" % info)
+        size, fmt = sizes[info]
+        if offset + size > len(data):
+            raise DecodeError("truncated float")
+        (value,) = struct.unpack_from(fmt, data, offset)
+        return (_half(value) if info == 25 else value), offset + size
+
+    if info < 24:
+        argument = info
+    elif info <= 27:
+        size = 1 << (info - 24)
+        if offset + size > len(data):
+            raise DecodeError("truncated argument")
+        argument = int.from_bytes(data[offset : offset + size], "big")
+        offset += size
+    else:
+        raise DecodeError("indefinite lengths are not used by the schema")
+
+    if major == 0:
+        return argument, offset
+    if major == 1:
+        return -1 - argument, offset
+    if major in (2, 3):
+        if offset + argument > len(data):
+            raise DecodeError("truncated string")
+        raw = bytes(data[offset : offset + argument])
+        return (raw if major == 2 else raw.decode("utf-8")), offset + argument
+    if major == 4:
+        items = []
+        for _ in range(argument):
+            item, offset = _decode(data, offset)
+            items.append(item)
+        return items, offset
+    if major == 5:
+        pairs = {}
+        for _ in range(argument):
+            key, offset = _decode(data, offset)
+            value, offset = _decode(data, offset)
+            pairs[key] = value
+        return pairs, offset
+    raise DecodeError("tags are not used by the schema")
+
+
+def decode(data):
+    value, offset = _decode(data, 0)
+    if offset != len(data):
+        raise DecodeError("%d trailing bytes" % (len(data) - offset))
+    return value
+
+
+def decode_cycle(data):
+    """Decode a cycle payload into a dict keyed by channel name."""
+    raw = decode(data)
+    if not isinstance(raw, dict) or KEY_VERSION not in raw:
+        raise DecodeError("not a telemetry cycle")
+    cycle = {"version": raw[KEY_VERSION], "timestamp": raw.get(KEY_TIMESTAMP)}
+    for channel, value in raw.get(KEY_CHANNELS, {}).items():
+        name = (
+            CHANNEL_NAMES[channel]
+            if channel < len(CHANNEL_NAMES)
+            else "channel_%d" % channel
+        )
+        cycle[name] = round(value, 6)
+    if KEY_PROBES in raw:
+        cycle["probes"] = [round(p, 6) for p in raw[KEY_PROBES]]
+    if cycle["timestamp"] is not None:
+        cycle["timestamp_ms"] = cycle["timestamp"] * 1000 + raw.get(KEY_MILLIS, 0)
+    if KEY_UPTIME in raw:
+        cycle["uptime"] = raw[KEY_UPTIME]
+    return cycle
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("inputs", nargs="+", help="payload files or hex strings")
+    parser.add_argument("--hex", action="store_true", help="inputs are hex strings")
+    args = parser.parse_args()
+
+    status = 0
+    for item in args.inputs:
+        try:
+            if args.hex:
+                data = bytes.fromhex(item)
+            else:
+                with open(item, "rb") as f:
+                    data = f.read()
+            print(json.dumps(decode_cycle(data)))
+        except (OSError, ValueError) as error:
+            sys.stderr.write("%s: %s\n" % (item, error))
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Description: Decode a dump of the "history" partition into CSV or JSON
+#
+# Dump the partition from a tower (offsets from partitions_history.csv):
+#   esptool.py read_flash 0x3F0000 0x10000 history.bin
+# Then:
+#   python3 tools/decode_history.py history.bin > history.csv
+#   python3 tools/decode_history.py --format json history.bin > history.json
+#
+# The on-flash format is documented in
+# lib/GreenHouseTowerDIY/src/local/data/history/flashlog.hpp
+
+import argparse
+import csv
+import datetime
+import json
+import math
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4C544847
+SECTOR_SIZE = 4096
+HEADER = struct.Struct("<IBBHII")
+
+# Must follow Telemetry::channel_names in local/data/telemetry/telemetry.cpp
+CHANNEL_NAMES = [
+    "ldr",
+    "water_level_sensor",
+    "water_level_percentage",
+    "temperature",
+    "dht_hum",
+    "dht_temp",
+    "sht31_1_hum",
+    "sht31_1_temp",
+    "sht31_2_hum",
+    "sht31_2_temp",
+]
+
+
+def channel_names(count):
+    names = CHANNEL_NAMES[:count]
+    names += ["channel_%d" % i for i in range(len(names), count)]
+    return names
+
+
+def read_sectors(image):
+    sectors = []
+    for offset in range(0, len(image) - SECTOR_SIZE + 1, SECTOR_SIZE):
+        magic, version, channels, record_size, sequence, crc = HEADER.unpack_from(
+            image, offset
+        )
+        if magic != MAGIC:
+            continue
+        if zlib.crc32(image[offset : offset + HEADER.size - 4]) != crc:
+            sys.stderr.write("sector at 0x%x: torn header, skipped\n" % offset)
+            continue
+        if record_size != 8 + 4 * channels:
+            sys.stderr.write("sector at 0x%x: bad record size, skipped\n" % offset)
+            continue
+        sectors.append((sequence, offset, version, channels, record_size))
+    sectors.sort()
+    return sectors
+
+
+def read_records(image, sectors):
+    """Records oldest first, erased slots left by failed writes are skipped."""
+    torn = 0
+    for sequence, offset, version, channels, record_size in sectors:
+        record = struct.Struct("<I%dfI" % channels)
+        position = offset + HEADER.size
+        while position + record_size <= offset + SECTOR_SIZE:
+            fields = record.unpack_from(image, position)
+            raw = image[position : position + record_size]
+            position += record_size
+            if raw == b"\xff" * record_size:
+                continue
+            if zlib.crc32(raw[:-4]) != fields[-1]:
+                torn += 1
+                continue
+            yield fields[0], channels, fields[1:-1]
+    if torn:
+        sys.stderr.write("%d torn records skipped\n" % torn)
+
+
+def clean(value):
+    return None if math.isnan(value) else round(value, 3)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("image", help="dump of the history partition")
+    parser.add_argument("--format", choices=["csv", "json"], default="csv")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    sectors = read_sectors(image)
+    if not sectors:
+        sys.stderr.write("no valid sectors found\n")
+        return 1
+
+    channels = max(s[3] for s in sectors)
+    names = channel_names(channels)
+    rows = []
+    for timestamp, count, values in read_records(image, sectors):
+        row = {
+            "timestamp": timestamp,
+            "time": datetime.datetime.utcfromtimestamp(timestamp).isoformat() + "Z",
+        }
+        for name, value in zip(names, values):
+            row[name] = clean(value)
+        rows.append(row)
+
+    if args.format == "json":
+        json.dump(rows, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+    else:
+        writer = csv.DictWriter(sys.stdout, fieldnames=["timestamp", "time"] + names)
+        writer.writeheader()
+        writer.writerows(rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
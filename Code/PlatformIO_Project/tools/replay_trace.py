@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+# Description: Build sensor traces and check trace replays against a golden
+#
+# Build a trace from cycles recorded on a production tower, either JSON
+# documents (one per line) or the JSON output of decode_cbor.py and
+# decode_history.py:
+#   mosquitto_sub -t 'tower/0/state' > cycles.jsonl
+#   python3 tools/replay_trace.py capture cycles.jsonl > data/trace.txt
+# Replay it on a board with the esp32dev_replay environment:
+#   pio run -e esp32dev_replay -t uploadfs -t upload -t monitor
+# Then pull the cycle reports out of the monitor log and check them:
+#   python3 tools/replay_trace.py extract monitor.log > results.jsonl
+#   python3 tools/replay_trace.py compare results.jsonl golden.jsonl
+#   python3 tools/replay_trace.py compare results.jsonl golden.jsonl --update
+# With an allocation tracking build (-DALLOC_TRACKING=1) the heap traffic
+# of every cycle can be bounded as well:
+#   python3 tools/replay_trace.py compare results.jsonl golden.jsonl --max-allocs 0
+#
+# The trace format is documented in
+# lib/GreenHouseTowerDIY/src/local/io/sensors/trace/sensortrace.hpp
+
+import argparse
+import json
+import math
+import sys
+
+from decode_cbor import DecodeError, decode_cycle
+
+# Fields that depend on when the replay ran, not on the data path
+VOLATILE_FIELDS = ("timestamp", "timestamp_ms", "uptime", "ntp")
+
+# Document field -> trace source, for the scalar channels
+SOURCES = {
+    "dht_hum": "dht.hum",
+    "dht_temp": "dht.temp",
+    "sht31_1_hum": "sht31_1.hum",
+    "sht31_1_temp": "sht31_1.temp",
+    "sht31_2_hum": "sht31_2.hum",
+    "sht31_2_temp": "sht31_2.temp",
+    "ldr": "bh1750",
+}
+
+
+def cycle_readings(cycle):
+    """Trace readings of one recorded cycle, as (source, value) pairs."""
+    flat = dict(cycle)
+    flat.update(cycle.get("humidity") or {})
+    readings = []
+    for field, source in SOURCES.items():
+        if field in flat:
+            readings.append((source, flat[field]))
+    probes = cycle.get("probes")
+    if probes is None and isinstance(cycle.get("temperature"), list):
+        probes = cycle["temperature"]
+    for index, value in enumerate(probes or []):
+        readings.append(("ds18b20.%d" % index, value))
+    return readings
+
+
+def format_value(value):
+    if value is None or (isinstance(value, float) and math.isnan(value)):
+        return "err"
+    return "%g" % value
+
+
+def capture(args):
+    """Recorded cycles -> trace, times relative to the first cycle."""
+    start = None
+    out = sys.stdout
+    out.write("# ms source value, captured from %s\n" % args.cycles)
+    with open(args.cycles) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            cycle = json.loads(line)
+            stamp = cycle.get("timestamp_ms") or cycle.get("timestamp", 0) * 1000
+            if start is None:
+                start = stamp
+            for source, value in cycle_readings(cycle):
+                out.write("%d %s %s\n" % (stamp - start, source, format_value(value)))
+    # The water level is published as a volume, its distance cannot be recovered
+    return 0
+
+
+def extract(args):
+    """Monitor log -> one JSON result per line, REPLAY_END last."""
+    for path in args.logs:
+        with open(path, errors="replace") as f:
+            for line in f:
+                for tag in ("REPLAY {", "REPLAY_END {"):
+                    at = line.find(tag)
+                    if at >= 0:
+                        report = json.loads(line[at + len(tag) - 1 :])
+                        if tag.startswith("REPLAY_END"):
+                            report["end"] = True
+                        print(json.dumps(report, sort_keys=True))
+                        break
+    return 0
+
+
+def load(path):
+    with open(path) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+def normalise(report):
+    """The part of a cycle report the golden pins down."""
+    doc = {k: v for k, v in report["doc"].items() if k not in VOLATILE_FIELDS}
+    result = {"cycle": report["cycle"], "trace_ms": report["trace_ms"], "doc": doc}
+    if report.get("cbor"):
+        try:
+            cbor = decode_cycle(bytes.fromhex(report["cbor"]))
+        except (DecodeError, ValueError) as error:
+            cbor = {"error": str(error)}
+        result["cbor"] = {k: v for k, v in cbor.items() if k not in VOLATILE_FIELDS}
+    return result
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def compare(args):
+    reports = [r for r in load(args.results) if not r.get("end")]
+    if not reports:
+        sys.stderr.write("%s: no cycles\n" % args.results)
+        return 1
+
+    latency = [r["latency_us"] for r in reports]
+    heap = [r["heap"] for r in reports]
+    arena = [r.get("arena", 0) for r in reports]
+    print(
+        "%d cycles, latency us mean %d p95 %d max %d, heap kept max %d, "
+        "arena max %d"
+        % (
+            len(reports),
+            sum(latency) / len(latency),
+            percentile(latency, 0.95),
+            max(latency),
+            max(heap),
+            max(arena),
+        )
+    )
+
+    status = 0
+    if args.max_allocs is not None:
+        tracked = [r for r in reports if "allocs" in r]
+        if not tracked:
+            print("no allocation counts, build with -DALLOC_TRACKING=1")
+            status = 1
+        else:
+            allocs = [r["allocs"] for r in tracked]
+            print(
+                "allocs per cycle mean %.1f max %d, bytes max %d, leaks max %d"
+                % (
+                    sum(allocs) / float(len(allocs)),
+                    max(allocs),
+                    max(r["alloc_bytes"] for r in tracked),
+                    max(r["leaks"] for r in tracked),
+                )
+            )
+        for report in tracked:
+            if report["allocs"] > args.max_allocs:
+                print(
+                    "cycle %d made %d allocations, limit %d"
+                    % (report["cycle"], report["allocs"], args.max_allocs)
+                )
+                status = 1
+
+    results = [normalise(r) for r in reports]
+    if args.update:
+        with open(args.golden, "w") as f:
+            for result in results:
+                f.write(json.dumps(result, sort_keys=True) + "\n")
+        print("golden written to %s" % args.golden)
+        return status
+
+    golden = load(args.golden)
+    if len(golden) != len(results):
+        print("cycle count %d, golden has %d" % (len(results), len(golden)))
+        status = 1
+    for expected, actual in zip(golden, results):
+        for part in ("trace_ms", "doc", "cbor"):
+            if expected.get(part) != actual.get(part):
+                print(
+                    "cycle %d %s differs\n  golden: %s\n  actual: %s"
+                    % (
+                        actual["cycle"],
+                        part,
+                        json.dumps(expected.get(part), sort_keys=True),
+                        json.dumps(actual.get(part), sort_keys=True),
+                    )
+                )
+                status = 1
+    print("match" if status == 0 else "MISMATCH")
+    return status
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    parser_capture = commands.add_parser("capture", help="recorded cycles to trace")
+    parser_capture.add_argument("cycles", help="JSON cycles, one per line")
+    parser_capture.set_defaults(run=capture)
+
+    parser_extract = commands.add_parser("extract", help="monitor log to results")
+    parser_extract.add_argument("logs", nargs="+", help="monitor logs")
+    parser_extract.set_defaults(run=extract)
+
+    parser_compare = commands.add_parser("compare", help="results against golden")
+    parser_compare.add_argument("results", help="output of extract")
+    parser_compare.add_argument("golden", help="golden results")
+    parser_compare.add_argument(
+        "--update", action="store_true", help="write results as the new golden"
+    )
+    parser_compare.add_argument(
+        "--max-allocs", type=int, help="fail cycles making more allocations"
+    )
+    parser_compare.set_defaults(run=compare)
+
+    args = parser.parse_args()
+    return args.run(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())